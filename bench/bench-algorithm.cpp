@@ -0,0 +1,361 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * bench-algorithm.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "uuidpp.hpp"
+#include "uuidpp-algorithm.hpp"
+#include "uuidpp-index.hpp"
+#include "uuidpp-shard.hpp"
+
+namespace
+{
+
+std::vector<uuid> random_ids(size_t count)
+{
+    std::vector<uuid> ids(count);
+    uuid::version4(ids.data(), count);
+    return ids;
+}
+
+std::vector<uuid> sorted_ids(size_t count)
+{
+    std::vector<uuid> ids = random_ids(count);
+    uuid_algo::radix_sort(ids.data(), ids.size());
+    return ids;
+}
+
+/** Keys drawn at random among UUIDs, so that lookups hit. */
+std::vector<uuid> present_keys(const std::vector<uuid>& ids, size_t count)
+{
+    std::vector<uuid> keys(count);
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    for(uuid& key : keys)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        key = ids[(state >> 33) % ids.size()];
+    }
+    return keys;
+}
+
+/** UUIDs of a version as generated in a row: consecutive times for versions 1 and 7, random otherwise. */
+std::vector<uuid> version_ids(int64_t version, size_t count)
+{
+    if(version != 1 && version != 7)
+    {
+        return random_ids(count);
+    }
+    std::vector<uuid> ids(count);
+    const std::vector<uuid> random = random_ids(count);
+    for(size_t n=0; n<count; ++n)
+    {
+        ids[n] = version == 1
+               ? uuid::version1(0x1ec9414c232ab00ull + n, 0x1234, 0x0a1b2c3d4e5full)
+               : uuid::version7(1700000000000ull + n / 4096, n % 4096, uuid_endian::load_be64(random[n].data() + 8));
+    }
+    return ids;
+}
+
+/** Report the spread of routed UUIDs: largest deviation from the mean in percent, and chi-squared (about shards - 1 if uniform). */
+void report_uniformity(bench_state& state, const std::vector<uint32_t>& routes, uint32_t shards)
+{
+    std::vector<size_t> counts(shards);
+    for(uint32_t route : routes)
+    {
+        ++counts[route];
+    }
+    const double mean = (double)routes.size() / shards;
+    double max_dev = 0, chi2 = 0;
+    for(size_t count : counts)
+    {
+        max_dev = std::max(max_dev, std::fabs(count - mean));
+        chi2 += (count - mean) * (count - mean) / mean;
+    }
+    state.counter("max_dev_pct", max_dev * 100 / mean);
+    state.counter("chi2", chi2);
+}
+
+/** Number of lookup keys, so many that their paths in large arrays do not stay cached. */
+constexpr size_t lookup_keys = 1 << 20;
+
+constexpr uint32_t route_shards = 64;
+constexpr size_t route_count = 1 << 16;
+
+} // anonymous namespace
+
+//
+// Sorting arg random UUIDs, input being restored out of timing.
+//
+
+static void std_sort(bench_state& state)
+{
+    const std::vector<uuid> input = random_ids(state.arg());
+    std::vector<uuid> ids;
+    while(state.keep_running())
+    {
+        state.pause_timing();
+        ids = input;
+        state.resume_timing();
+        std::sort(ids.begin(), ids.end());
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * input.size());
+}
+UUIDPP_BENCH_ARG(std_sort, 1 << 10);
+UUIDPP_BENCH_ARG(std_sort, 1 << 20);
+UUIDPP_BENCH_LARGE_ARG(std_sort, 100000000);
+
+static void radix_sort(bench_state& state)
+{
+    const std::vector<uuid> input = random_ids(state.arg());
+    std::vector<uuid> ids;
+    while(state.keep_running())
+    {
+        state.pause_timing();
+        ids = input;
+        state.resume_timing();
+        uuid_algo::radix_sort(ids.data(), ids.size());
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * input.size());
+}
+UUIDPP_BENCH_ARG(radix_sort, 1 << 10);
+UUIDPP_BENCH_ARG(radix_sort, 1 << 20);
+UUIDPP_BENCH_LARGE_ARG(radix_sort, 100000000);
+
+static void parallel_radix_sort(bench_state& state)
+{
+    const std::vector<uuid> input = random_ids(state.arg());
+    std::vector<uuid> ids;
+    while(state.keep_running())
+    {
+        state.pause_timing();
+        ids = input;
+        state.resume_timing();
+        uuid_algo::parallel_radix_sort(ids.data(), ids.size());
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * input.size());
+}
+UUIDPP_BENCH_ARG(parallel_radix_sort, 1 << 20);
+UUIDPP_BENCH_LARGE_ARG(parallel_radix_sort, 100000000);
+
+//
+// Set operations
+//
+
+static void unique(bench_state& state)
+{
+    std::vector<uuid> input = sorted_ids(state.arg() / 2);
+    input.insert(input.end(), input.begin(), input.end());
+    std::sort(input.begin(), input.end());
+    std::vector<uuid> ids;
+    while(state.keep_running())
+    {
+        state.pause_timing();
+        ids = input;
+        state.resume_timing();
+        do_not_optimize(uuid_algo::unique(ids.data(), ids.size()));
+    }
+    state.set_items_processed(state.iterations() * input.size());
+}
+UUIDPP_BENCH_ARG(unique, 1 << 20);
+
+static void set_intersection(bench_state& state)
+{
+    const std::vector<uuid> a = sorted_ids(state.arg()), b = sorted_ids(state.arg());
+    std::vector<uuid> out(state.arg());
+    while(state.keep_running())
+    {
+        do_not_optimize(uuid_algo::set_intersection(a.data(), a.size(), b.data(), b.size(), out.data()));
+    }
+    state.set_items_processed(state.iterations() * (a.size() + b.size()));
+}
+UUIDPP_BENCH_ARG(set_intersection, 1 << 20);
+
+static void merge(bench_state& state)
+{
+    const std::vector<uuid> a = sorted_ids(state.arg()), b = sorted_ids(state.arg());
+    std::vector<uuid> out(a.size() + b.size());
+    while(state.keep_running())
+    {
+        uuid_algo::merge(a.data(), a.size(), b.data(), b.size(), out.data());
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * out.size());
+}
+UUIDPP_BENCH_ARG(merge, 1 << 20);
+
+//
+// Lookups of present UUIDs in arg sorted UUIDs, 1<<24 ones (256 MB) being
+// beyond last level caches.
+//
+
+static void std_lower_bound(bench_state& state)
+{
+    const std::vector<uuid> ids = sorted_ids(state.arg());
+    const std::vector<uuid> keys = present_keys(ids, lookup_keys);
+    size_t n = 0;
+    while(state.keep_running())
+    {
+        do_not_optimize(std::lower_bound(ids.begin(), ids.end(), keys[n++ & (lookup_keys - 1)]));
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH_ARG(std_lower_bound, 1 << 10);
+UUIDPP_BENCH_ARG(std_lower_bound, 1 << 20);
+UUIDPP_BENCH_ARG(std_lower_bound, 1 << 24);
+
+static void std_map_find(bench_state& state)
+{
+    const std::vector<uuid> ids = random_ids(state.arg());
+    std::map<uuid, size_t> map;
+    for(size_t n=0; n<ids.size(); ++n)
+    {
+        map.emplace(ids[n], n);
+    }
+    size_t n = 0;
+    while(state.keep_running())
+    {
+        do_not_optimize(map.find(ids[n++ % ids.size()]));
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH_ARG(std_map_find, 1 << 10);
+UUIDPP_BENCH_ARG(std_map_find, 1 << 20);
+UUIDPP_BENCH_LARGE_ARG(std_map_find, 1 << 24);
+
+static void index_find(bench_state& state)
+{
+    const std::vector<uuid> ids = sorted_ids(state.arg());
+    const uuid_index index(ids.data(), ids.size());
+    const std::vector<uuid> keys = present_keys(ids, lookup_keys);
+    size_t n = 0;
+    while(state.keep_running())
+    {
+        do_not_optimize(index.find(keys[n++ & (lookup_keys - 1)]));
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH_ARG(index_find, 1 << 10);
+UUIDPP_BENCH_ARG(index_find, 1 << 20);
+UUIDPP_BENCH_ARG(index_find, 1 << 24);
+
+static void index_find_batch(bench_state& state)
+{
+    const std::vector<uuid> ids = sorted_ids(state.arg());
+    const uuid_index index(ids.data(), ids.size());
+    const std::vector<uuid> keys = present_keys(ids, lookup_keys);
+    std::vector<size_t> results(1024);
+    size_t n = 0;
+    while(state.keep_running())
+    {
+        index.find(keys.data() + ((n++ * results.size()) & (lookup_keys - 1)), results.size(), results.data());
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * results.size());
+}
+UUIDPP_BENCH_ARG(index_find_batch, 1 << 10);
+UUIDPP_BENCH_ARG(index_find_batch, 1 << 20);
+UUIDPP_BENCH_ARG(index_find_batch, 1 << 24);
+
+//
+// Routing 64K UUIDs of version arg to 64 shards, with uniformity counters.
+//
+
+static void shard_string_modulo(bench_state& state)
+{
+    const std::vector<uuid> ids = version_ids(state.arg(), route_count);
+    std::vector<uint32_t> routes(ids.size());
+    const std::hash<std::string> hash;
+    while(state.keep_running())
+    {
+        for(size_t n=0; n<ids.size(); ++n)
+        {
+            routes[n] = hash(ids[n].to_string()) % route_shards;
+        }
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * ids.size());
+    report_uniformity(state, routes, route_shards);
+}
+UUIDPP_BENCH_ARG(shard_string_modulo, 1);
+UUIDPP_BENCH_ARG(shard_string_modulo, 4);
+UUIDPP_BENCH_ARG(shard_string_modulo, 7);
+
+static void shard_range(bench_state& state)
+{
+    const std::vector<uuid> ids = version_ids(state.arg(), route_count);
+    std::vector<uint32_t> routes(ids.size());
+    while(state.keep_running())
+    {
+        uuid_shard::range(ids.data(), ids.size(), route_shards, routes.data());
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * ids.size());
+    report_uniformity(state, routes, route_shards);
+}
+UUIDPP_BENCH_ARG(shard_range, 1);
+UUIDPP_BENCH_ARG(shard_range, 4);
+UUIDPP_BENCH_ARG(shard_range, 7);
+
+static void shard_jump(bench_state& state)
+{
+    const std::vector<uuid> ids = version_ids(state.arg(), route_count);
+    std::vector<uint32_t> routes(ids.size());
+    while(state.keep_running())
+    {
+        uuid_shard::jump(ids.data(), ids.size(), route_shards, routes.data());
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * ids.size());
+    report_uniformity(state, routes, route_shards);
+}
+UUIDPP_BENCH_ARG(shard_jump, 1);
+UUIDPP_BENCH_ARG(shard_jump, 4);
+UUIDPP_BENCH_ARG(shard_jump, 7);
+
+static void shard_rendezvous(bench_state& state)
+{
+    const std::vector<uuid> ids = version_ids(state.arg(), route_count);
+    std::vector<uint64_t> nodes(route_shards);
+    for(size_t n=0; n<nodes.size(); ++n)
+    {
+        nodes[n] = 1000 + n;
+    }
+    std::vector<uint32_t> routes(ids.size());
+    while(state.keep_running())
+    {
+        uuid_shard::rendezvous(ids.data(), ids.size(), nodes.data(), route_shards, routes.data());
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * ids.size());
+    report_uniformity(state, routes, route_shards);
+}
+UUIDPP_BENCH_ARG(shard_rendezvous, 1);
+UUIDPP_BENCH_ARG(shard_rendezvous, 4);
+UUIDPP_BENCH_ARG(shard_rendezvous, 7);
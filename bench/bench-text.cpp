@@ -0,0 +1,182 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * bench-text.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "uuidpp.hpp"
+#include "uuidpp-bytes.hpp"
+#include "uuidpp-codec.hpp"
+#include "uuidpp-scan.hpp"
+
+namespace
+{
+
+std::vector<uuid> random_ids(size_t count)
+{
+    std::vector<uuid> ids(count);
+    uuid::version4(ids.data(), count);
+    return ids;
+}
+
+std::vector<uuid> sorted_ids(size_t count)
+{
+    std::vector<uuid> ids = random_ids(count);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+/** Unix time based UUIDs, as generated in a row 64 per millisecond, thus sorted. */
+std::vector<uuid> version7_ids(size_t count)
+{
+    const std::vector<uuid> random = random_ids(count);
+    std::vector<uuid> ids(count);
+    for(size_t n=0; n<count; ++n)
+    {
+        ids[n] = uuid::version7(1700000000000ull + n / 64, n % 64, uuid_endian::load_be64(random[n].data() + 8));
+    }
+    return ids;
+}
+
+/** Log-like text of about size bytes, with a UUID every density lines when not 0. */
+std::string log_text(size_t size, size_t density)
+{
+    std::string text;
+    size_t line = 0;
+    while(text.size() < size)
+    {
+        text += "2017-06-12T10:42:07.123Z INFO request handled in 12ms status=200 ";
+        if(density != 0 && line % density == 0)
+        {
+            text += "id=" + uuid::version4().to_string();
+        }
+        text += "\n";
+        ++line;
+    }
+    return text;
+}
+
+} // anonymous namespace
+
+//
+// Scanning of 1MiB of text
+//
+
+static void scan_sparse(bench_state& state)
+{
+    const std::string text = log_text(1 << 20, 0);
+    const uuid_scanner scanner;
+    while(state.keep_running())
+    {
+        do_not_optimize(scanner.scan(text.data(), text.size(), [](const uuid_match&) {}));
+    }
+    state.set_bytes_processed(state.iterations() * text.size());
+}
+UUIDPP_BENCH(scan_sparse);
+
+static void scan_dense(bench_state& state)
+{
+    const std::string text = log_text(1 << 20, 1);
+    const uuid_scanner scanner;
+    size_t found = 0;
+    while(state.keep_running())
+    {
+        found = scanner.scan(text.data(), text.size(), [](const uuid_match& match) {do_not_optimize(match);});
+    }
+    state.set_bytes_processed(state.iterations() * text.size());
+    state.set_items_processed(state.iterations() * found);
+}
+UUIDPP_BENCH(scan_dense);
+
+//
+// Byte order conversions
+//
+
+static void to_guid(bench_state& state)
+{
+    const std::vector<uuid> ids = random_ids(state.arg());
+    std::vector<uint8_t> out(ids.size() * 16);
+    while(state.keep_running())
+    {
+        uuid_bytes::to_guid(ids.data(), ids.size(), out.data());
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * ids.size());
+    state.set_bytes_processed(state.iterations() * out.size());
+}
+UUIDPP_BENCH_ARG(to_guid, 1024);
+
+//
+// Compression of arg UUIDs, sorted as columns usually are: random ones,
+// and Unix time based ones generated 64 per millisecond.
+//
+
+static void codec_encode_ids(bench_state& state, const std::vector<uuid>& ids)
+{
+    size_t size = 0;
+    while(state.keep_running())
+    {
+        uuid_compressed_array array(ids.data(), ids.size());
+        size = array.bytes().size();
+        do_not_optimize(size);
+    }
+    state.set_items_processed(state.iterations() * ids.size());
+    state.counter("bits_per_uuid", 8.0 * size / ids.size());
+}
+
+static void codec_decode_ids(bench_state& state, const std::vector<uuid>& ids)
+{
+    const uuid_compressed_array array(ids.data(), ids.size());
+    std::vector<uuid> out(ids.size());
+    while(state.keep_running())
+    {
+        array.decode(out.data());
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * ids.size());
+    state.counter("bits_per_uuid", 8.0 * array.bytes().size() / ids.size());
+}
+
+static void codec_encode(bench_state& state)
+{
+    codec_encode_ids(state, sorted_ids(state.arg()));
+}
+UUIDPP_BENCH_ARG(codec_encode, 1 << 16);
+
+static void codec_encode_v7(bench_state& state)
+{
+    codec_encode_ids(state, version7_ids(state.arg()));
+}
+UUIDPP_BENCH_ARG(codec_encode_v7, 1 << 16);
+
+static void codec_decode(bench_state& state)
+{
+    codec_decode_ids(state, sorted_ids(state.arg()));
+}
+UUIDPP_BENCH_ARG(codec_decode, 1 << 16);
+
+static void codec_decode_v7(bench_state& state)
+{
+    codec_decode_ids(state, version7_ids(state.arg()));
+}
+UUIDPP_BENCH_ARG(codec_decode_v7, 1 << 16);
@@ -0,0 +1,538 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * bench-uuid.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include "bench.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "uuidpp.hpp"
+#include "uuidpp-clock.hpp"
+#include "uuidpp-dispenser.hpp"
+#include "uuidpp-host.hpp"
+#include "uuidpp-layout.hpp"
+#include "uuidpp-pool.hpp"
+
+namespace
+{
+
+const uuid sample(std::array<uint8_t, 16>{{0x6b, 0xa7, 0xb8, 0x10, 0x9d, 0xad, 0x11, 0xd1,
+                                           0x80, 0xb4, 0x00, 0xc0, 0x4f, 0xd4, 0x30, 0xc8}});
+
+std::vector<uuid> random_ids(size_t count)
+{
+    std::vector<uuid> ids(count);
+    uuid::version4(ids.data(), count);
+    return ids;
+}
+
+void report_latency(bench_state& state, const uuid_latency_histogram& latency)
+{
+    state.counter("p50_ns", latency.percentile(0.5));
+    state.counter("p99_ns", latency.percentile(0.99));
+    state.counter("p999_ns", latency.percentile(0.999));
+}
+
+} // anonymous namespace
+
+//
+// Generation
+//
+
+static void version1(bench_state& state)
+{
+    uint64_t timestamp = 0x1d1d1d1d1d1d1d1ull;
+    while(state.keep_running())
+    {
+        do_not_optimize(uuid::version1(timestamp++, 0x1234, 0x0123456789abull));
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(version1);
+
+static void version4(bench_state& state)
+{
+    while(state.keep_running())
+    {
+        do_not_optimize(uuid::version4());
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(version4);
+
+static void version4_bulk(bench_state& state)
+{
+    std::vector<uuid> ids(state.arg());
+    while(state.keep_running())
+    {
+        uuid::version4(ids.data(), ids.size());
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations() * ids.size());
+}
+UUIDPP_BENCH_ARG(version4_bulk, 1024);
+
+/** Generate from several threads at once, iterations being shared between threads. */
+static void version4_threads(bench_state& state)
+{
+    const unsigned threads = state.arg();
+    const uint64_t per_thread = (state.iterations() + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    state.start();
+    for(unsigned t=0; t<threads; ++t)
+    {
+        workers.emplace_back([per_thread]()
+        {
+            for(uint64_t n=0; n<per_thread; ++n)
+            {
+                do_not_optimize(uuid::version4());
+            }
+        });
+    }
+    for(std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    state.stop();
+    state.set_items_processed(per_thread * threads);
+}
+UUIDPP_BENCH_ARG(version4_threads, 2);
+UUIDPP_BENCH_ARG(version4_threads, 4);
+UUIDPP_BENCH_ARG(version4_threads, 8);
+
+static void pool_next(bench_state& state)
+{
+    uuid_pool& pool = uuid_pool::local();
+    while(state.keep_running())
+    {
+        do_not_optimize(pool.next());
+    }
+    state.set_items_processed(state.iterations());
+    state.counter("misses", pool.misses());
+}
+UUIDPP_BENCH(pool_next);
+
+static void pool_next_bulk_refill(bench_state& state)
+{
+    uuid_pool pool(uuid_pool::default_capacity, uuid_pool::refill_mode::bulk);
+    while(state.keep_running())
+    {
+        do_not_optimize(pool.next());
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(pool_next_bulk_refill);
+
+static void dispenser_take(bench_state& state)
+{
+    uuid_dispenser dispenser(uuid::version_t::version_unix_time_based);
+    while(state.keep_running())
+    {
+        do_not_optimize(dispenser.take());
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(dispenser_take);
+
+static void dispenser_take_coarse_clock(bench_state& state)
+{
+    uuid_dispenser dispenser(uuid::version_t::version_unix_time_based, uuid_clock::coarse());
+    while(state.keep_running())
+    {
+        do_not_optimize(dispenser.take());
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(dispenser_take_coarse_clock);
+
+static void dispenser_take_tsc_clock(bench_state& state)
+{
+    uuid_dispenser dispenser(uuid::version_t::version_unix_time_based, uuid_clock::tsc());
+    while(state.keep_running())
+    {
+        do_not_optimize(dispenser.take());
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(dispenser_take_tsc_clock);
+
+static void dispenser_cursor_take(bench_state& state)
+{
+    uuid_dispenser dispenser(uuid::version_t::version_unix_time_based);
+    uuid_dispenser_cursor cursor(dispenser);
+    while(state.keep_running())
+    {
+        do_not_optimize(cursor.take());
+    }
+    state.set_items_processed(state.iterations());
+    state.counter("clock_reads", cursor.refills());
+}
+UUIDPP_BENCH(dispenser_cursor_take);
+
+static void dispenser_cursor_take_version6(bench_state& state)
+{
+    uuid_dispenser dispenser(uuid::version_t::version_reordered_time_based);
+    uuid_dispenser_cursor cursor(dispenser);
+    while(state.keep_running())
+    {
+        do_not_optimize(cursor.take());
+    }
+    state.set_items_processed(state.iterations());
+    state.counter("clock_reads", cursor.refills());
+}
+UUIDPP_BENCH(dispenser_cursor_take_version6);
+
+static void dispenser_take_batch(bench_state& state)
+{
+    uuid_dispenser dispenser(uuid::version_t::version_unix_time_based);
+    uuid ids[64];
+    while(state.keep_running())
+    {
+        dispenser.take(ids, 64);
+        do_not_optimize(ids[63]);
+    }
+    state.set_items_processed(state.iterations() * 64);
+}
+UUIDPP_BENCH(dispenser_take_batch);
+
+static void host_state_version6(bench_state& state)
+{
+    {
+        uuid_host_state host("uuidpp-bench.state", 0x0123456789abull);
+        while(state.keep_running())
+        {
+            do_not_optimize(host.version6());
+        }
+    }
+    std::remove("uuidpp-bench.state");
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(host_state_version6);
+
+//
+// Clock reads of time based generators.
+//
+
+static void clock_read(bench_state& state, uuid_clock& clock)
+{
+    while(state.keep_running())
+    {
+        do_not_optimize(clock.now());
+    }
+    state.set_items_processed(state.iterations());
+}
+
+static void clock_system(bench_state& state)
+{
+    clock_read(state, uuid_clock::system());
+}
+UUIDPP_BENCH(clock_system);
+
+static void clock_coarse(bench_state& state)
+{
+    clock_read(state, uuid_clock::coarse());
+}
+UUIDPP_BENCH(clock_coarse);
+
+static void clock_tsc(bench_state& state)
+{
+    clock_read(state, uuid_clock::tsc());
+}
+UUIDPP_BENCH(clock_tsc);
+
+static void clock_fake(bench_state& state)
+{
+    uuid_fake_clock clock(0, 1);
+    clock_read(state, clock);
+}
+UUIDPP_BENCH(clock_fake);
+
+//
+// Latency distributions of single generations, including a clock read.
+//
+
+static void version4_latency(bench_state& state)
+{
+    uuid_latency_histogram latency;
+    while(state.keep_running())
+    {
+        auto start = std::chrono::steady_clock::now();
+        do_not_optimize(uuid::version4());
+        auto end = std::chrono::steady_clock::now();
+        latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+    state.set_items_processed(state.iterations());
+    report_latency(state, latency);
+}
+UUIDPP_BENCH(version4_latency);
+
+static void pool_latency(bench_state& state)
+{
+    uuid_pool& pool = uuid_pool::local();
+    pool.reset_latency();
+    pool.measure(true);
+    while(state.keep_running())
+    {
+        do_not_optimize(pool.next());
+    }
+    pool.measure(false);
+    state.set_items_processed(state.iterations());
+    report_latency(state, pool.latency());
+}
+UUIDPP_BENCH(pool_latency);
+
+static void pool_bulk_refill_latency(bench_state& state)
+{
+    uuid_pool pool(uuid_pool::default_capacity, uuid_pool::refill_mode::bulk);
+    pool.measure(true);
+    while(state.keep_running())
+    {
+        do_not_optimize(pool.next());
+    }
+    state.set_items_processed(state.iterations());
+    report_latency(state, pool.latency());
+}
+UUIDPP_BENCH(pool_bulk_refill_latency);
+
+static void version6(bench_state& state)
+{
+    uint64_t timestamp = 0x1d1d1d1d1d1d1d1ull;
+    while(state.keep_running())
+    {
+        do_not_optimize(uuid::version6(timestamp++, 0x1234, 0x0123456789abull));
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(version6);
+
+static void version7(bench_state& state)
+{
+    uint64_t timestamp = 1500000000000ull;
+    while(state.keep_running())
+    {
+        do_not_optimize(uuid::version7(timestamp++, 0x123, 0x0123456789abcdefull));
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(version7);
+
+//
+// Version 8 layouts.
+//
+
+struct bench_timestamp : uuid_field<48> {};
+struct bench_shard : uuid_field<16> {};
+struct bench_entity : uuid_field<8> {};
+struct bench_sequence : uuid_field<50> {};
+typedef uuid_layout<bench_timestamp, bench_shard, bench_entity, bench_sequence> bench_layout;
+
+static void layout_encode_columns(bench_state& state)
+{
+    const size_t count = 4096;
+    std::vector<uint64_t> timestamps(count), sequences(count);
+    std::vector<uint16_t> shards(count);
+    std::vector<uint8_t> entities(count);
+    for(size_t n=0; n<count; ++n)
+    {
+        timestamps[n] = 1500000000000ull + n;
+        shards[n] = (uint16_t)(n * 7);
+        entities[n] = (uint8_t)n;
+        sequences[n] = n * 0x9E3779B97F4A7C15ull;
+    }
+    std::vector<uuid> ids(count);
+    while(state.keep_running())
+    {
+        bench_layout::encode(ids.data(), count, timestamps.data(), shards.data(), entities.data(), sequences.data());
+        do_not_optimize(ids[count - 1]);
+    }
+    state.set_items_processed(state.iterations() * count);
+}
+UUIDPP_BENCH(layout_encode_columns);
+
+static void layout_decode_columns(bench_state& state)
+{
+    const size_t count = 4096;
+    std::vector<uuid> ids(count);
+    for(size_t n=0; n<count; ++n)
+    {
+        ids[n] = bench_layout::encode(1500000000000ull + n, (uint16_t)(n * 7), (uint8_t)n, n * 0x9E3779B97F4A7C15ull);
+    }
+    std::vector<uint64_t> timestamps(count), sequences(count);
+    std::vector<uint16_t> shards(count);
+    std::vector<uint8_t> entities(count);
+    while(state.keep_running())
+    {
+        bench_layout::decode(ids.data(), count, timestamps.data(), shards.data(), entities.data(), sequences.data());
+        do_not_optimize(sequences[count - 1]);
+    }
+    state.set_items_processed(state.iterations() * count);
+}
+UUIDPP_BENCH(layout_decode_columns);
+
+//
+// Hashing, names of arg bytes
+//
+
+static void version3(bench_state& state)
+{
+    std::string name(state.arg(), 'n');
+    while(state.keep_running())
+    {
+        do_not_optimize(uuid::version3(uuid_ns::dns, name));
+    }
+    state.set_items_processed(state.iterations());
+    state.set_bytes_processed(state.iterations() * name.size());
+}
+UUIDPP_BENCH_ARG(version3, 16);
+UUIDPP_BENCH_ARG(version3, 256);
+
+static void version5(bench_state& state)
+{
+    std::string name(state.arg(), 'n');
+    while(state.keep_running())
+    {
+        do_not_optimize(uuid::version5(uuid_ns::dns, name));
+    }
+    state.set_items_processed(state.iterations());
+    state.set_bytes_processed(state.iterations() * name.size());
+}
+UUIDPP_BENCH_ARG(version5, 16);
+UUIDPP_BENCH_ARG(version5, 256);
+
+//
+// Formatting
+//
+
+static void to_string(bench_state& state)
+{
+    while(state.keep_running())
+    {
+        do_not_optimize(sample.to_string());
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(to_string);
+
+static void to_hex(bench_state& state)
+{
+    while(state.keep_running())
+    {
+        do_not_optimize(sample.to_hex());
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(to_hex);
+
+static void to_chars(bench_state& state)
+{
+    char buffer[36];
+    while(state.keep_running())
+    {
+        do_not_optimize(sample.to_chars(buffer));
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(to_chars);
+
+//
+// Parsing
+//
+
+static void parse(bench_state& state)
+{
+    const std::string text = sample.to_string();
+    uuid id;
+    while(state.keep_running())
+    {
+        do_not_optimize(uuid::parse(text.data(), text.size(), id));
+        do_not_optimize(id);
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(parse);
+
+static void from_string(bench_state& state)
+{
+    const std::string text = sample.to_string();
+    while(state.keep_running())
+    {
+        do_not_optimize(uuid::from_string(text));
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(from_string);
+
+//
+// Construction and comparison
+//
+
+static void construct_iterators(bench_state& state)
+{
+    const std::vector<uint8_t> bytes(sample.begin(), sample.end());
+    while(state.keep_running())
+    {
+        do_not_optimize(uuid(bytes.begin(), bytes.end()));
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(construct_iterators);
+
+static void construct_integers(bench_state& state)
+{
+    uint64_t hi = 0x6ba7b8109dad11d1ull, lo = 0x80b400c04fd430c8ull;
+    while(state.keep_running())
+    {
+        do_not_optimize(uuid(hi, lo));
+        ++lo;
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(construct_integers);
+
+/** Compare consecutive random UUIDs, as sorts and searches do. */
+static void compare(bench_state& state)
+{
+    const std::vector<uuid> ids = random_ids(1024);
+    size_t n = 0;
+    while(state.keep_running())
+    {
+        do_not_optimize(ids[n & 1023].compare(ids[(n + 1) & 1023]));
+        ++n;
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(compare);
+
+/** Compare UUIDs equal but for their last byte, the worst case. */
+static void equal(bench_state& state)
+{
+    uuid a = sample, b = sample;
+    b[15] ^= 1;
+    while(state.keep_running())
+    {
+        do_not_optimize(a == b);
+        clobber_memory();
+    }
+    state.set_items_processed(state.iterations());
+}
+UUIDPP_BENCH(equal);
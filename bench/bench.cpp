@@ -0,0 +1,476 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * bench.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+/*
+ * Benchmark runner.
+ *
+ * Usage: uuidpp-bench [options]
+ *  --filter=REGEX      run benchmarks whose name matches REGEX
+ *  --list              list benchmarks and exit
+ *  --format=FORMAT     console (default), json or csv
+ *  --out=FILE          write the report to FILE instead of standard output
+ *  --min-time=SECONDS  minimum duration of a run (default 0.2)
+ *  --repetitions=N     repeat each benchmark N times, reporting mean, median and stddev
+ *  --cpu=N             pin the process to CPU N for reproducible results
+ *  --large             also run benchmarks of large inputs, far beyond caches
+ *
+ * Kernels of another SIMD level are measured with UUIDPP_CPU, for example
+ * UUIDPP_CPU=scalar uuidpp-bench --filter=scan
+ */
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+#include <unistd.h>
+
+#include "uuidpp-cpu.hpp"
+
+namespace
+{
+
+struct benchmark
+{
+    std::string name;
+    bench_function function;
+    int64_t arg;
+    bool large;
+};
+
+std::vector<benchmark>& registry()
+{
+    static std::vector<benchmark> benchmarks;
+    return benchmarks;
+}
+
+double process_cpu_seconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/** Result of one run, or aggregate of several. */
+struct result
+{
+    std::string name;
+    uint64_t iterations;
+    double real_ns, cpu_ns;
+    double items_per_second, bytes_per_second;
+    std::map<std::string, double> counters;
+};
+
+result run_once(const benchmark& bench, double min_time)
+{
+    uint64_t iterations = 1;
+    for(;;)
+    {
+        bench_state state(iterations, bench.arg);
+        bench.function(state);
+        // Accept runs lasting long enough, or grow the iteration count toward the minimum time.
+        if(state.real_seconds() >= min_time || iterations >= (uint64_t)1 << 40)
+        {
+            result res;
+            res.name = bench.name;
+            res.iterations = iterations;
+            res.real_ns = state.real_seconds() * 1e9 / iterations;
+            res.cpu_ns = state.cpu_seconds() * 1e9 / iterations;
+            res.items_per_second = state.items() / state.real_seconds();
+            res.bytes_per_second = state.bytes() / state.real_seconds();
+            res.counters = state.counters();
+            return res;
+        }
+        double factor = state.real_seconds() > 0 ? min_time * 1.4 / state.real_seconds() : 100;
+        iterations = (uint64_t)(iterations * std::min(std::max(factor, 2.0), 100.0));
+    }
+}
+
+/** Aggregate repetitions with a function of the values of each field. */
+template<class Function>
+result aggregate(const std::vector<result>& runs, const std::string& suffix, Function function)
+{
+    result res = runs.front();
+    res.name += suffix;
+    auto field = [&](double result::* member)
+    {
+        std::vector<double> values;
+        for(const result& run : runs)
+        {
+            values.push_back(run.*member);
+        }
+        return function(values);
+    };
+    res.real_ns = field(&result::real_ns);
+    res.cpu_ns = field(&result::cpu_ns);
+    res.items_per_second = field(&result::items_per_second);
+    res.bytes_per_second = field(&result::bytes_per_second);
+    for(auto& counter : res.counters)
+    {
+        std::vector<double> values;
+        for(const result& run : runs)
+        {
+            values.push_back(run.counters.at(counter.first));
+        }
+        counter.second = function(values);
+    }
+    return res;
+}
+
+double mean(std::vector<double> values)
+{
+    double sum = 0;
+    for(double value : values)
+    {
+        sum += value;
+    }
+    return sum / values.size();
+}
+
+double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+double stddev(std::vector<double> values)
+{
+    double m = mean(values), sum = 0;
+    for(double value : values)
+    {
+        sum += (value - m) * (value - m);
+    }
+    return values.size() > 1 ? std::sqrt(sum / (values.size() - 1)) : 0;
+}
+
+std::string json_string(const std::string& str)
+{
+    std::string res = "\"";
+    for(char c : str)
+    {
+        if(c == '"' || c == '\\')
+        {
+            res += '\\';
+        }
+        res += c;
+    }
+    return res + "\"";
+}
+
+std::string read_first_line(const char* path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+class reporter
+{
+public:
+    reporter(const std::string& format, std::ostream& out, int cpu):
+    _format(format), _out(out), _cpu(cpu)
+    {}
+
+    void begin()
+    {
+        char host[256] = {};
+        gethostname(host, sizeof(host) - 1);
+        char date[64];
+        time_t now = time(nullptr);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+        std::string governor = read_first_line("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor");
+        bool scaling = !governor.empty() && governor != "performance";
+
+        if(_format == "json")
+        {
+            _out << "{\n  \"context\": {\n"
+                 << "    \"date\": " << json_string(date) << ",\n"
+                 << "    \"host_name\": " << json_string(host) << ",\n"
+                 << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+                 << "    \"pinned_cpu\": " << _cpu << ",\n"
+                 << "    \"cpu_scaling_enabled\": " << (scaling ? "true" : "false") << ",\n"
+                 << "    \"simd_level\": " << json_string(uuid_cpu::name(uuid_cpu::active())) << ",\n"
+#if defined(NDEBUG)
+                 << "    \"library_build_type\": \"release\"\n"
+#else
+                 << "    \"library_build_type\": \"debug\"\n"
+#endif
+                 << "  },\n  \"benchmarks\": [";
+        }
+        else if(_format == "csv")
+        {
+            _out << "name,iterations,real_time,cpu_time,time_unit,items_per_second,bytes_per_second,counters\n";
+        }
+        else
+        {
+            _out << date << "\nRunning on " << std::thread::hardware_concurrency() << " CPUs";
+            if(_cpu >= 0)
+            {
+                _out << ", pinned to CPU " << _cpu;
+            }
+            _out << ", SIMD level " << uuid_cpu::name(uuid_cpu::active()) << "\n";
+            if(scaling)
+            {
+                _out << "***WARNING*** CPU scaling is enabled (governor " << governor
+                     << "), measures will be noisy.\n";
+            }
+            _out << std::string(100, '-') << "\n";
+            char line[160];
+            snprintf(line, sizeof(line), "%-44s %14s %14s %12s  %s\n", "Benchmark", "Time", "CPU", "Iterations", "Rates");
+            _out << line << std::string(100, '-') << "\n";
+        }
+        _out.flush();
+    }
+
+    void report(const result& res)
+    {
+        if(_format == "json")
+        {
+            _out << (_first ? "\n" : ",\n") << "    {\n"
+                 << "      \"name\": " << json_string(res.name) << ",\n"
+                 << "      \"iterations\": " << res.iterations << ",\n"
+                 << "      \"real_time\": " << res.real_ns << ",\n"
+                 << "      \"cpu_time\": " << res.cpu_ns << ",\n"
+                 << "      \"time_unit\": \"ns\"";
+            if(res.items_per_second > 0)
+            {
+                _out << ",\n      \"items_per_second\": " << res.items_per_second;
+            }
+            if(res.bytes_per_second > 0)
+            {
+                _out << ",\n      \"bytes_per_second\": " << res.bytes_per_second;
+            }
+            for(const auto& counter : res.counters)
+            {
+                _out << ",\n      " << json_string(counter.first) << ": " << counter.second;
+            }
+            _out << "\n    }";
+        }
+        else if(_format == "csv")
+        {
+            _out << json_string(res.name) << "," << res.iterations << "," << res.real_ns << ","
+                 << res.cpu_ns << ",ns," << res.items_per_second << "," << res.bytes_per_second << ",";
+            std::string sep;
+            for(const auto& counter : res.counters)
+            {
+                _out << sep << counter.first << "=" << counter.second;
+                sep = ";";
+            }
+            _out << "\n";
+        }
+        else
+        {
+            std::ostringstream rates;
+            if(res.items_per_second > 0)
+            {
+                rates << res.items_per_second / 1e6 << " M items/s ";
+            }
+            if(res.bytes_per_second > 0)
+            {
+                rates << res.bytes_per_second / (1 << 30) << " GiB/s ";
+            }
+            for(const auto& counter : res.counters)
+            {
+                rates << counter.first << "=" << counter.second << " ";
+            }
+            char line[512];
+            snprintf(line, sizeof(line), "%-44s %11.1f ns %11.1f ns %12llu  %s\n", res.name.c_str(),
+                     res.real_ns, res.cpu_ns, (unsigned long long)res.iterations, rates.str().c_str());
+            _out << line;
+        }
+        _first = false;
+        _out.flush();
+    }
+
+    void end()
+    {
+        if(_format == "json")
+        {
+            _out << "\n  ]\n}\n";
+        }
+    }
+
+private:
+    std::string _format;
+    std::ostream& _out;
+    int _cpu;
+    bool _first = true;
+};
+
+int usage()
+{
+    std::cerr << "Usage: uuidpp-bench [--filter=REGEX] [--list] [--format=console|json|csv] [--out=FILE]\n"
+                 "                    [--min-time=SECONDS] [--repetitions=N] [--cpu=N] [--large]\n";
+    return 2;
+}
+
+} // anonymous namespace
+
+bench_state::bench_state(uint64_t iterations, int64_t arg):
+_iterations(iterations),
+_remaining(iterations),
+_arg(arg)
+{
+}
+
+void bench_state::start()
+{
+    _running = true;
+    _real_start = std::chrono::steady_clock::now();
+    _cpu_start = process_cpu_seconds();
+}
+
+void bench_state::stop()
+{
+    if(_running)
+    {
+        _real += std::chrono::duration<double>(std::chrono::steady_clock::now() - _real_start).count();
+        _cpu += process_cpu_seconds() - _cpu_start;
+        _running = false;
+    }
+}
+
+void bench_state::pause_timing()
+{
+    stop();
+}
+
+void bench_state::resume_timing()
+{
+    start();
+}
+
+bench_registration::bench_registration(const char* name, bench_function function, int64_t arg, bool has_arg, bool large)
+{
+    std::string full = name;
+    if(has_arg)
+    {
+        full += "/" + std::to_string(arg);
+    }
+    registry().push_back(benchmark{full, function, arg, large});
+}
+
+int main(int argc, char** argv)
+{
+    std::string filter = ".*", format = "console", out_path;
+    double min_time = 0.2;
+    int repetitions = 1, cpu = -1;
+    bool list = false, large = false;
+    for(int n=1; n<argc; ++n)
+    {
+        std::string arg = argv[n];
+        auto value = [&](const char* option) -> const char*
+        {
+            size_t len = strlen(option);
+            return arg.compare(0, len, option) == 0 ? argv[n] + len : nullptr;
+        };
+        const char* val;
+        if((val = value("--filter=")) != nullptr) filter = val;
+        else if((val = value("--format=")) != nullptr) format = val;
+        else if((val = value("--out=")) != nullptr) out_path = val;
+        else if((val = value("--min-time=")) != nullptr) min_time = atof(val);
+        else if((val = value("--repetitions=")) != nullptr) repetitions = std::max(1, atoi(val));
+        else if((val = value("--cpu=")) != nullptr) cpu = atoi(val);
+        else if(arg == "--list") list = true;
+        else if(arg == "--large") large = true;
+        else return usage();
+    }
+    if(format != "console" && format != "json" && format != "csv")
+    {
+        return usage();
+    }
+
+    std::regex pattern(filter);
+    std::vector<benchmark> selected;
+    for(const benchmark& bench : registry())
+    {
+        if((large || !bench.large) && std::regex_search(bench.name, pattern))
+        {
+            selected.push_back(bench);
+        }
+    }
+    std::sort(selected.begin(), selected.end(), [](const benchmark& l, const benchmark& r)
+    {
+        return l.name < r.name;
+    });
+    if(list)
+    {
+        for(const benchmark& bench : selected)
+        {
+            std::cout << bench.name << "\n";
+        }
+        return 0;
+    }
+
+    if(cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if(sched_setaffinity(0, sizeof(set), &set) != 0)
+        {
+            perror("uuidpp-bench: cannot pin CPU");
+            return 1;
+        }
+    }
+
+    std::ofstream file;
+    if(!out_path.empty())
+    {
+        file.open(out_path);
+        if(!file)
+        {
+            std::cerr << "uuidpp-bench: cannot write " << out_path << "\n";
+            return 1;
+        }
+    }
+    reporter report(format, out_path.empty() ? std::cout : file, cpu);
+    report.begin();
+    for(const benchmark& bench : selected)
+    {
+        std::vector<result> runs;
+        for(int rep=0; rep<repetitions; ++rep)
+        {
+            runs.push_back(run_once(bench, min_time));
+            report.report(runs.back());
+        }
+        if(repetitions > 1)
+        {
+            report.report(aggregate(runs, "_mean", mean));
+            report.report(aggregate(runs, "_median", median));
+            report.report(aggregate(runs, "_stddev", stddev));
+        }
+    }
+    report.end();
+    return 0;
+}
@@ -0,0 +1,142 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * bench.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_BENCH_HPP_
+#define _UUIDPP_BENCH_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * Minimal microbenchmark harness, in the spirit of Google Benchmark.
+ *
+ * A benchmark is a function looping while keep_running() returns true,
+ * the harness choosing the number of iterations so that a run lasts at
+ * least the minimum time.
+ */
+class bench_state
+{
+public:
+    bench_state(uint64_t iterations, int64_t arg);
+
+    /** Test if another iteration must run, starting timing on the first call. */
+    bool keep_running()
+    {
+        if(_remaining == _iterations)
+        {
+            start();
+        }
+        if(_remaining-- == 0)
+        {
+            stop();
+            return false;
+        }
+        return true;
+    }
+
+    /** Number of iterations of this run. */
+    uint64_t iterations() const noexcept {return _iterations;}
+
+    /** Argument of the benchmark, 0 if registered without one. */
+    int64_t arg() const noexcept {return _arg;}
+
+    /** Stop timing, for example to prepare input out of the measure. */
+    void pause_timing();
+
+    /** Restart timing after pause_timing(). */
+    void resume_timing();
+
+    /** Declare the total number of processed items, to report items per second. */
+    void set_items_processed(uint64_t items) {_items = items;}
+
+    /** Declare the total number of processed bytes, to report bytes per second. */
+    void set_bytes_processed(uint64_t bytes) {_bytes = bytes;}
+
+    /** Report a named value along with times. */
+    void counter(const std::string& name, double value) {_counters[name] = value;}
+
+    /**
+     * Start timing and iterations explicitly, for benchmarks dividing
+     * iterations between threads instead of calling keep_running().
+     */
+    void start();
+
+    /** Stop timing started with start(). */
+    void stop();
+
+    double real_seconds() const noexcept {return _real;}
+    double cpu_seconds() const noexcept {return _cpu;}
+    uint64_t items() const noexcept {return _items;}
+    uint64_t bytes() const noexcept {return _bytes;}
+    const std::map<std::string, double>& counters() const noexcept {return _counters;}
+
+private:
+    uint64_t _iterations, _remaining;
+    int64_t _arg;
+    bool _running = false;
+    std::chrono::steady_clock::time_point _real_start;
+    double _cpu_start = 0;
+    double _real = 0, _cpu = 0;
+    uint64_t _items = 0, _bytes = 0;
+    std::map<std::string, double> _counters;
+};
+
+typedef void (*bench_function)(bench_state&);
+
+/** Register a benchmark, through UUIDPP_BENCH macros. */
+struct bench_registration
+{
+    bench_registration(const char* name, bench_function function, int64_t arg = 0, bool has_arg = false, bool large = false);
+};
+
+/** Prevent the compiler from optimizing away a computed value. */
+template<class T>
+inline void do_not_optimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/** Prevent the compiler from assuming memory unchanged. */
+inline void clobber_memory()
+{
+    asm volatile("" : : : "memory");
+}
+
+#define UUIDPP_BENCH_CONCAT2(a, b) a##b
+#define UUIDPP_BENCH_CONCAT(a, b) UUIDPP_BENCH_CONCAT2(a, b)
+
+/** Register a benchmark function under its name. */
+#define UUIDPP_BENCH(function) \
+    static bench_registration UUIDPP_BENCH_CONCAT(bench_registration_, __LINE__)(#function, function)
+
+/** Register a benchmark function with an argument, named "function/arg". */
+#define UUIDPP_BENCH_ARG(function, arg) \
+    static bench_registration UUIDPP_BENCH_CONCAT(bench_registration_, __LINE__)(#function, function, arg, true)
+
+/**
+ * Register a benchmark function with an argument too large to run by
+ * default (gigabytes of memory, seconds per iteration), run with --large.
+ */
+#define UUIDPP_BENCH_LARGE_ARG(function, arg) \
+    static bench_registration UUIDPP_BENCH_CONCAT(bench_registration_, __LINE__)(#function, function, arg, true, true)
+
+#endif // _UUIDPP_BENCH_HPP_
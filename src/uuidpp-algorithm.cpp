@@ -0,0 +1,697 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-algorithm.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-algorithm.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "uuidpp-endian.hpp"
+
+namespace
+{
+
+/** UUID associated to its position before sorting. */
+struct indexed_uuid
+{
+    uuid id;
+    size_t index;
+};
+
+inline const uuid& key_of(const uuid& id)
+{
+    return id;
+}
+
+inline const uuid& key_of(const indexed_uuid& elem)
+{
+    return elem.id;
+}
+
+using uuid_endian::load_be64;
+
+inline bool key_less(const uuid& l, const uuid& r)
+{
+    uint64_t lhi = load_be64(l.data()), rhi = load_be64(r.data());
+    if(lhi != rhi)
+    {
+        return lhi < rhi;
+    }
+    return load_be64(l.data() + 8) < load_be64(r.data() + 8);
+}
+
+/** UUID as two native 64 bits words, for branchless comparisons. */
+struct word_key
+{
+    uint64_t hi, lo;
+};
+
+inline word_key key_words(const uuid& id)
+{
+    return word_key{load_be64(id.data()), load_be64(id.data() + 8)};
+}
+
+inline bool words_less(const word_key& l, const word_key& r)
+{
+    return (l.hi < r.hi) | ((l.hi == r.hi) & (l.lo < r.lo));
+}
+
+inline bool words_equal(const word_key& l, const word_key& r)
+{
+    return ((l.hi ^ r.hi) | (l.lo ^ r.lo)) == 0;
+}
+
+template<class T>
+struct elem_less
+{
+    bool operator()(const T& l, const T& r) const
+    {
+        return key_less(key_of(l), key_of(r));
+    }
+};
+
+/** Under this size, buckets are sorted by comparison. */
+constexpr size_t small_bucket = 64;
+
+/** Under this size, parallel sort falls back to the sequential one. */
+constexpr size_t parallel_threshold = 1 << 16;
+
+/**
+ * Recursive MSD radix sort, one byte per level.
+ * Elements are read from a and scattered in b, which is used as scratch.
+ * @param a Elements to sort.
+ * @param b Scratch buffer of the same size.
+ * @param n Number of elements.
+ * @param byte Index of the UUID byte used as digit.
+ * @param a_is_final True if sorted elements must be left in a, false for b.
+ */
+template<class T>
+void msd_sort(T* a, T* b, size_t n, unsigned byte, bool a_is_final)
+{
+    while(n > small_bucket && byte < 16)
+    {
+        size_t hist[256] = {0};
+        for(size_t i=0; i<n; ++i)
+        {
+            ++hist[key_of(a[i])[byte]];
+        }
+
+        // All keys share this digit, no need to move anything.
+        if(hist[key_of(a[0])[byte]] == n)
+        {
+            ++byte;
+            continue;
+        }
+
+        size_t offsets[256];
+        for(size_t d=0, sum=0; d<256; ++d)
+        {
+            offsets[d] = sum;
+            sum += hist[d];
+        }
+        for(size_t i=0; i<n; ++i)
+        {
+            b[offsets[key_of(a[i])[byte]]++] = a[i];
+        }
+
+        for(size_t d=0, start=0; d<256; ++d)
+        {
+            if(hist[d] != 0)
+            {
+                msd_sort(b + start, a + start, hist[d], byte + 1, !a_is_final);
+                start += hist[d];
+            }
+        }
+        return;
+    }
+
+    if(byte < 16)
+    {
+        std::sort(a, a + n, elem_less<T>());
+    }
+    if(!a_is_final)
+    {
+        std::copy(a, a + n, b);
+    }
+}
+
+template<class T>
+void sequential_sort(T* elems, size_t count)
+{
+    if(count > small_bucket)
+    {
+        std::vector<T> scratch(count);
+        msd_sort(elems, scratch.data(), count, 0, true);
+    }
+    else
+    {
+        std::sort(elems, elems + count, elem_less<T>());
+    }
+}
+
+unsigned thread_count(unsigned threads, size_t count)
+{
+    if(threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t max_threads = std::max<size_t>(1, count / (parallel_threshold / 4));
+    return (unsigned)std::min<size_t>(threads, max_threads);
+}
+
+/**
+ * Run a function on several threads, passing the thread index to each.
+ */
+template<class Fn>
+void run_parallel(unsigned threads, Fn fn)
+{
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for(unsigned t=1; t<threads; ++t)
+    {
+        workers.emplace_back(fn, t);
+    }
+    fn(0u);
+    for(std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+/**
+ * Parallel MSD radix sort.
+ * The first distinguishing byte is histogrammed and scattered by all threads
+ * together, then resulting buckets are sorted concurrently.
+ */
+template<class T>
+void parallel_sort(T* elems, size_t count, unsigned threads)
+{
+    threads = thread_count(threads, count);
+    if(count < parallel_threshold || threads < 2)
+    {
+        sequential_sort(elems, count);
+        return;
+    }
+
+    size_t chunk = (count + threads - 1) / threads;
+    auto chunk_begin = [=](unsigned t) { return std::min(count, t * chunk); };
+
+    // Look for the first byte where keys differ, skipping common prefixes (as in time-based UUIDs).
+    const uint64_t ref_hi = load_be64(key_of(elems[0]).data());
+    const uint64_t ref_lo = load_be64(key_of(elems[0]).data() + 8);
+    std::vector<uint64_t> diff_hi(threads, 0), diff_lo(threads, 0);
+    run_parallel(threads, [&](unsigned t)
+    {
+        uint64_t hi = 0, lo = 0;
+        for(size_t i=chunk_begin(t), end=chunk_begin(t+1); i<end; ++i)
+        {
+            hi |= load_be64(key_of(elems[i]).data()) ^ ref_hi;
+            lo |= load_be64(key_of(elems[i]).data() + 8) ^ ref_lo;
+        }
+        diff_hi[t] = hi;
+        diff_lo[t] = lo;
+    });
+    uint64_t hi = 0, lo = 0;
+    for(unsigned t=0; t<threads; ++t)
+    {
+        hi |= diff_hi[t];
+        lo |= diff_lo[t];
+    }
+    if(hi == 0 && lo == 0)
+    {
+        return; // All keys are equal.
+    }
+    const unsigned byte = hi != 0 ? __builtin_clzll(hi) / 8 : 8 + __builtin_clzll(lo) / 8;
+
+    std::vector<T> scratch(count);
+    std::vector<size_t> hist(threads * 256, 0);
+    run_parallel(threads, [&](unsigned t)
+    {
+        size_t* h = &hist[t * 256];
+        for(size_t i=chunk_begin(t), end=chunk_begin(t+1); i<end; ++i)
+        {
+            ++h[key_of(elems[i])[byte]];
+        }
+    });
+
+    // Offsets are laid out bucket-major, then thread by thread inside each bucket.
+    std::vector<size_t> offsets(threads * 256);
+    size_t bucket_begin[257];
+    for(size_t d=0, sum=0; d<256; ++d)
+    {
+        bucket_begin[d] = sum;
+        for(unsigned t=0; t<threads; ++t)
+        {
+            offsets[t * 256 + d] = sum;
+            sum += hist[t * 256 + d];
+        }
+    }
+    bucket_begin[256] = count;
+
+    run_parallel(threads, [&](unsigned t)
+    {
+        size_t* off = &offsets[t * 256];
+        for(size_t i=chunk_begin(t), end=chunk_begin(t+1); i<end; ++i)
+        {
+            scratch[off[key_of(elems[i])[byte]]++] = elems[i];
+        }
+    });
+
+    // Sort buckets, biggest first, dispatched dynamically to balance the load.
+    std::vector<unsigned> buckets;
+    for(unsigned d=0; d<256; ++d)
+    {
+        if(bucket_begin[d+1] != bucket_begin[d])
+        {
+            buckets.push_back(d);
+        }
+    }
+    std::sort(buckets.begin(), buckets.end(), [&](unsigned l, unsigned r)
+    {
+        return bucket_begin[l+1] - bucket_begin[l] > bucket_begin[r+1] - bucket_begin[r];
+    });
+    std::atomic<size_t> next(0);
+    run_parallel(threads, [&](unsigned)
+    {
+        for(size_t n=next++; n<buckets.size(); n=next++)
+        {
+            unsigned d = buckets[n];
+            size_t begin = bucket_begin[d], size = bucket_begin[d+1] - begin;
+            msd_sort(scratch.data() + begin, elems + begin, size, byte + 1, false);
+        }
+    });
+}
+
+template<class Sort>
+void indexed_sort(uuid* ids, size_t count, size_t* permutation, Sort sort)
+{
+    std::vector<indexed_uuid> elems(count);
+    for(size_t n=0; n<count; ++n)
+    {
+        elems[n].id = ids[n];
+        elems[n].index = n;
+    }
+    sort(elems.data(), count);
+    for(size_t n=0; n<count; ++n)
+    {
+        ids[n] = elems[n].id;
+        permutation[n] = elems[n].index;
+    }
+}
+
+size_t unique_range(uuid* ids, size_t count)
+{
+    if(count == 0)
+    {
+        return 0;
+    }
+    size_t out = 1;
+    word_key last = key_words(ids[0]);
+    for(size_t n=1; n<count; ++n)
+    {
+        word_key key = key_words(ids[n]);
+        ids[out] = ids[n];
+        out += !words_equal(key, last);
+        last = key;
+    }
+    return out;
+}
+
+void merge_range(const uuid* a, size_t a_count, const uuid* b, size_t b_count, uuid* out)
+{
+    size_t ia = 0, ib = 0;
+    while(ia < a_count && ib < b_count)
+    {
+        bool take_b = words_less(key_words(b[ib]), key_words(a[ia]));
+        *out++ = take_b ? b[ib] : a[ia];
+        ia += !take_b;
+        ib += take_b;
+    }
+    out = std::copy(a + ia, a + a_count, out);
+    std::copy(b + ib, b + b_count, out);
+}
+
+size_t intersection_range(const uuid* a, size_t a_count, const uuid* b, size_t b_count, uuid* out)
+{
+    size_t ia = 0, ib = 0, k = 0;
+    while(ia < a_count && ib < b_count)
+    {
+        word_key ka = key_words(a[ia]), kb = key_words(b[ib]);
+        bool lt = words_less(ka, kb), gt = words_less(kb, ka);
+        out[k] = a[ia];
+        k += !(lt | gt);
+        ia += !gt;
+        ib += !lt;
+    }
+    return k;
+}
+
+size_t difference_range(const uuid* a, size_t a_count, const uuid* b, size_t b_count, uuid* out)
+{
+    size_t ia = 0, ib = 0, k = 0;
+    while(ia < a_count && ib < b_count)
+    {
+        word_key ka = key_words(a[ia]), kb = key_words(b[ib]);
+        bool lt = words_less(ka, kb), gt = words_less(kb, ka);
+        out[k] = a[ia];
+        k += lt;
+        ia += !gt;
+        ib += !lt;
+    }
+    return std::copy(a + ia, a + a_count, out + k) - out;
+}
+
+/** Entry of the k-way merge heap. */
+struct run_head
+{
+    word_key key;
+    size_t run;
+};
+
+/** Heap ordering, the smallest key (then the first run) on top. */
+struct run_head_greater
+{
+    bool operator()(const run_head& l, const run_head& r) const
+    {
+        return words_less(r.key, l.key) || (words_equal(l.key, r.key) && l.run > r.run);
+    }
+};
+
+void kway_merge_range(const uuid* const* begins, const uuid* const* ends, size_t k, uuid* out)
+{
+    std::vector<const uuid*> heads(begins, begins + k);
+    std::vector<run_head> heap;
+    heap.reserve(k);
+    for(size_t r=0; r<k; ++r)
+    {
+        if(heads[r] != ends[r])
+        {
+            heap.push_back(run_head{key_words(*heads[r]), r});
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), run_head_greater());
+
+    while(heap.size() > 1)
+    {
+        std::pop_heap(heap.begin(), heap.end(), run_head_greater());
+        run_head& head = heap.back();
+        *out++ = *heads[head.run]++;
+        if(heads[head.run] != ends[head.run])
+        {
+            head.key = key_words(*heads[head.run]);
+            std::push_heap(heap.begin(), heap.end(), run_head_greater());
+        }
+        else
+        {
+            heap.pop_back();
+        }
+    }
+    if(!heap.empty())
+    {
+        size_t r = heap.front().run;
+        std::copy(heads[r], ends[r], out);
+    }
+}
+
+/**
+ * Split a sorted array in chunks of roughly equal sizes without separating equal UUIDs,
+ * and split a second sorted array at the same values.
+ */
+void split_sorted(const uuid* a, size_t a_count, const uuid* b, size_t b_count, unsigned parts,
+                  std::vector<size_t>& a_split, std::vector<size_t>& b_split)
+{
+    a_split.assign(parts + 1, a_count);
+    b_split.assign(parts + 1, b_count);
+    a_split[0] = b_split[0] = 0;
+    for(unsigned t=1; t<parts; ++t)
+    {
+        size_t pos = std::max(a_split[t-1], a_count * t / parts);
+        if(pos > 0 && pos < a_count)
+        {
+            pos = std::upper_bound(a + pos, a + a_count, a[pos-1], elem_less<uuid>()) - a;
+        }
+        a_split[t] = pos;
+        b_split[t] = pos < a_count ? std::lower_bound(b, b + b_count, a[pos], elem_less<uuid>()) - b : b_count;
+    }
+}
+
+/**
+ * Apply a set operation chunk by chunk on several threads, then gather partial results.
+ */
+template<class Op>
+size_t parallel_set_operation(const uuid* a, size_t a_count, const uuid* b, size_t b_count,
+                              uuid* out, unsigned threads, Op op)
+{
+    threads = thread_count(threads, a_count + b_count);
+    if(a_count + b_count < parallel_threshold || threads < 2)
+    {
+        return op(a, a_count, b, b_count, out);
+    }
+
+    std::vector<size_t> a_split, b_split;
+    split_sorted(a, a_count, b, b_count, threads, a_split, b_split);
+
+    std::vector<std::vector<uuid>> partials(threads);
+    std::vector<size_t> sizes(threads + 1, 0);
+    run_parallel(threads, [&](unsigned t)
+    {
+        size_t na = a_split[t+1] - a_split[t], nb = b_split[t+1] - b_split[t];
+        partials[t].resize(na);
+        sizes[t+1] = op(a + a_split[t], na, b + b_split[t], nb, partials[t].data());
+    });
+    for(unsigned t=0; t<threads; ++t)
+    {
+        sizes[t+1] += sizes[t];
+    }
+    run_parallel(threads, [&](unsigned t)
+    {
+        std::copy(partials[t].begin(), partials[t].begin() + (sizes[t+1] - sizes[t]), out + sizes[t]);
+    });
+    return sizes[threads];
+}
+
+} // anonymous namespace
+
+namespace uuid_algo
+{
+
+void radix_sort(uuid* ids, size_t count)
+{
+    sequential_sort(ids, count);
+}
+
+void radix_sort(uuid* ids, size_t count, size_t* permutation)
+{
+    indexed_sort(ids, count, permutation, [](indexed_uuid* elems, size_t n)
+    {
+        sequential_sort(elems, n);
+    });
+}
+
+void parallel_radix_sort(uuid* ids, size_t count, unsigned threads)
+{
+    parallel_sort(ids, count, threads);
+}
+
+void parallel_radix_sort(uuid* ids, size_t count, size_t* permutation, unsigned threads)
+{
+    indexed_sort(ids, count, permutation, [=](indexed_uuid* elems, size_t n)
+    {
+        parallel_sort(elems, n, threads);
+    });
+}
+
+size_t unique(uuid* ids, size_t count)
+{
+    return unique_range(ids, count);
+}
+
+size_t parallel_unique(uuid* ids, size_t count, unsigned threads)
+{
+    threads = thread_count(threads, count);
+    if(count < parallel_threshold || threads < 2)
+    {
+        return unique_range(ids, count);
+    }
+
+    size_t chunk = (count + threads - 1) / threads;
+    std::vector<size_t> begins(threads + 1), starts(threads), sizes(threads);
+    std::vector<word_key> previous(threads);
+    for(unsigned t=0; t<=threads; ++t)
+    {
+        begins[t] = std::min(count, t * chunk);
+    }
+    // Chunk heads must be compared to their predecessors before any chunk is compacted.
+    for(unsigned t=1; t<threads; ++t)
+    {
+        if(begins[t] < count)
+        {
+            previous[t] = key_words(ids[begins[t]-1]);
+        }
+    }
+
+    run_parallel(threads, [&](unsigned t)
+    {
+        size_t begin = begins[t], end = begins[t+1];
+        if(t > 0)
+        {
+            while(begin < end && words_equal(key_words(ids[begin]), previous[t]))
+            {
+                ++begin;
+            }
+        }
+        starts[t] = begin;
+        sizes[t] = unique_range(ids + begin, end - begin);
+    });
+
+    // Gather compacted chunks; destinations never run past their sources.
+    size_t out = sizes[0];
+    for(unsigned t=1; t<threads; ++t)
+    {
+        std::copy(ids + starts[t], ids + starts[t] + sizes[t], ids + out);
+        out += sizes[t];
+    }
+    return out;
+}
+
+void merge(const uuid* a, size_t a_count, const uuid* b, size_t b_count, uuid* out)
+{
+    merge_range(a, a_count, b, b_count, out);
+}
+
+void parallel_merge(const uuid* a, size_t a_count, const uuid* b, size_t b_count, uuid* out,
+                    unsigned threads)
+{
+    size_t total = a_count + b_count;
+    threads = thread_count(threads, total);
+    if(total < parallel_threshold || threads < 2)
+    {
+        merge_range(a, a_count, b, b_count, out);
+        return;
+    }
+
+    // Merge path: split the output in equal parts and find the matching input positions.
+    std::vector<size_t> a_split(threads + 1), diag(threads + 1);
+    for(unsigned t=0; t<=threads; ++t)
+    {
+        size_t d = total * t / threads;
+        size_t lo = d > b_count ? d - b_count : 0, hi = std::min(d, a_count);
+        while(lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if(words_less(key_words(b[d - mid - 1]), key_words(a[mid])))
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+        a_split[t] = lo;
+        diag[t] = d;
+    }
+
+    run_parallel(threads, [&](unsigned t)
+    {
+        size_t ia = a_split[t], ib = diag[t] - ia;
+        size_t na = a_split[t+1] - ia, nb = diag[t+1] - a_split[t+1] - ib;
+        merge_range(a + ia, na, b + ib, nb, out + diag[t]);
+    });
+}
+
+void kway_merge(const uuid* const* runs, const size_t* counts, size_t k, uuid* out)
+{
+    std::vector<const uuid*> ends(k);
+    for(size_t r=0; r<k; ++r)
+    {
+        ends[r] = runs[r] + counts[r];
+    }
+    kway_merge_range(runs, ends.data(), k, out);
+}
+
+void parallel_kway_merge(const uuid* const* runs, const size_t* counts, size_t k, uuid* out,
+                         unsigned threads)
+{
+    size_t total = 0, longest = 0;
+    for(size_t r=0; r<k; ++r)
+    {
+        total += counts[r];
+        longest = counts[r] > counts[longest] ? r : longest;
+    }
+    threads = thread_count(threads, total);
+    if(total < parallel_threshold || threads < 2)
+    {
+        kway_merge(runs, counts, k, out);
+        return;
+    }
+
+    // Split all runs at values sampled from the longest one.
+    std::vector<const uuid*> bounds((threads + 1) * k);
+    std::vector<size_t> offsets(threads + 1, 0);
+    for(unsigned t=0; t<=threads; ++t)
+    {
+        for(size_t r=0; r<k; ++r)
+        {
+            const uuid*& bound = bounds[t * k + r];
+            if(t == 0 || t == threads)
+            {
+                bound = runs[r] + (t == 0 ? 0 : counts[r]);
+            }
+            else
+            {
+                const uuid& splitter = runs[longest][counts[longest] * t / threads];
+                bound = std::lower_bound(runs[r], runs[r] + counts[r], splitter, elem_less<uuid>());
+            }
+            offsets[t] += bound - runs[r];
+        }
+    }
+
+    run_parallel(threads, [&](unsigned t)
+    {
+        kway_merge_range(&bounds[t * k], &bounds[(t + 1) * k], k, out + offsets[t]);
+    });
+}
+
+size_t set_intersection(const uuid* a, size_t a_count, const uuid* b, size_t b_count, uuid* out)
+{
+    return intersection_range(a, a_count, b, b_count, out);
+}
+
+size_t parallel_set_intersection(const uuid* a, size_t a_count, const uuid* b, size_t b_count,
+                                 uuid* out, unsigned threads)
+{
+    return parallel_set_operation(a, a_count, b, b_count, out, threads, intersection_range);
+}
+
+size_t set_difference(const uuid* a, size_t a_count, const uuid* b, size_t b_count, uuid* out)
+{
+    return difference_range(a, a_count, b, b_count, out);
+}
+
+size_t parallel_set_difference(const uuid* a, size_t a_count, const uuid* b, size_t b_count,
+                               uuid* out, unsigned threads)
+{
+    return parallel_set_operation(a, a_count, b, b_count, out, threads, difference_range);
+}
+
+} // namespace uuid_algo
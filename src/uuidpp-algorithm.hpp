@@ -0,0 +1,179 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-algorithm.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_ALGORITHM_HPP_
+#define _UUIDPP_ALGORITHM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "uuidpp.hpp"
+
+/**
+ * Bulk algorithms on arrays of UUIDs.
+ * UUIDs are ordered as two big-endian 64 bits unsigned keys, which is the
+ * same order than the lexicographic order of their bytes.
+ */
+namespace uuid_algo
+{
+    /**
+     * Sort an array of UUIDs with a MSD radix sort.
+     * @param ids First UUID of the array to sort.
+     * @param count Number of UUIDs in the array.
+     */
+    void radix_sort(uuid* ids, size_t count);
+
+    /**
+     * Sort an array of UUIDs with a MSD radix sort and report the applied permutation.
+     * @param ids First UUID of the array to sort.
+     * @param count Number of UUIDs in the array.
+     * @param permutation Array of count indexes, filled such that the n-th sorted
+     * UUID was at position permutation[n] before sorting.
+     * It can be used to reorder any payload associated to the UUIDs.
+     */
+    void radix_sort(uuid* ids, size_t count, size_t* permutation);
+
+    /**
+     * Sort an array of UUIDs with a multithreaded MSD radix sort.
+     * @param ids First UUID of the array to sort.
+     * @param count Number of UUIDs in the array.
+     * @param threads Number of threads to use, 0 to use the hardware concurrency.
+     */
+    void parallel_radix_sort(uuid* ids, size_t count, unsigned threads = 0);
+
+    /**
+     * Sort an array of UUIDs with a multithreaded MSD radix sort and report the applied permutation.
+     * @param ids First UUID of the array to sort.
+     * @param count Number of UUIDs in the array.
+     * @param permutation Array of count indexes, filled such that the n-th sorted
+     * UUID was at position permutation[n] before sorting.
+     * @param threads Number of threads to use, 0 to use the hardware concurrency.
+     */
+    void parallel_radix_sort(uuid* ids, size_t count, size_t* permutation, unsigned threads = 0);
+
+    /**
+     * Remove consecutive duplicated UUIDs from an array, like std::unique.
+     * @param ids First UUID of the array.
+     * @param count Number of UUIDs in the array.
+     * @return Number of UUIDs remaining at the beginning of the array.
+     */
+    size_t unique(uuid* ids, size_t count);
+
+    /**
+     * Remove consecutive duplicated UUIDs from an array with several threads.
+     * @param ids First UUID of the array.
+     * @param count Number of UUIDs in the array.
+     * @param threads Number of threads to use, 0 to use the hardware concurrency.
+     * @return Number of UUIDs remaining at the beginning of the array.
+     */
+    size_t parallel_unique(uuid* ids, size_t count, unsigned threads = 0);
+
+    /**
+     * Merge two sorted arrays of UUIDs, like std::merge.
+     * @param a First sorted array.
+     * @param a_count Size of the first array.
+     * @param b Second sorted array.
+     * @param b_count Size of the second array.
+     * @param out Output array, of a_count+b_count UUIDs, not overlapping inputs.
+     */
+    void merge(const uuid* a, size_t a_count, const uuid* b, size_t b_count, uuid* out);
+
+    /**
+     * Merge two sorted arrays of UUIDs with several threads.
+     * @param a First sorted array.
+     * @param a_count Size of the first array.
+     * @param b Second sorted array.
+     * @param b_count Size of the second array.
+     * @param out Output array, of a_count+b_count UUIDs, not overlapping inputs.
+     * @param threads Number of threads to use, 0 to use the hardware concurrency.
+     */
+    void parallel_merge(const uuid* a, size_t a_count, const uuid* b, size_t b_count, uuid* out,
+                        unsigned threads = 0);
+
+    /**
+     * Merge k sorted arrays of UUIDs.
+     * @param runs Sorted arrays to merge.
+     * @param counts Sizes of the sorted arrays.
+     * @param k Number of arrays.
+     * @param out Output array, of the sum of counts UUIDs, not overlapping inputs.
+     */
+    void kway_merge(const uuid* const* runs, const size_t* counts, size_t k, uuid* out);
+
+    /**
+     * Merge k sorted arrays of UUIDs with several threads.
+     * @param runs Sorted arrays to merge.
+     * @param counts Sizes of the sorted arrays.
+     * @param k Number of arrays.
+     * @param out Output array, of the sum of counts UUIDs, not overlapping inputs.
+     * @param threads Number of threads to use, 0 to use the hardware concurrency.
+     */
+    void parallel_kway_merge(const uuid* const* runs, const size_t* counts, size_t k, uuid* out,
+                             unsigned threads = 0);
+
+    /**
+     * Compute the intersection of two sorted arrays of UUIDs, like std::set_intersection.
+     * @param a First sorted array.
+     * @param a_count Size of the first array.
+     * @param b Second sorted array.
+     * @param b_count Size of the second array.
+     * @param out Output array, of at least min(a_count, b_count) UUIDs.
+     * @return Number of UUIDs written to out.
+     */
+    size_t set_intersection(const uuid* a, size_t a_count, const uuid* b, size_t b_count, uuid* out);
+
+    /**
+     * Compute the intersection of two sorted arrays of UUIDs with several threads.
+     * @param a First sorted array.
+     * @param a_count Size of the first array.
+     * @param b Second sorted array.
+     * @param b_count Size of the second array.
+     * @param out Output array, of at least min(a_count, b_count) UUIDs.
+     * @param threads Number of threads to use, 0 to use the hardware concurrency.
+     * @return Number of UUIDs written to out.
+     */
+    size_t parallel_set_intersection(const uuid* a, size_t a_count, const uuid* b, size_t b_count,
+                                     uuid* out, unsigned threads = 0);
+
+    /**
+     * Compute the UUIDs of a sorted array not present in another, like std::set_difference.
+     * @param a Sorted array to filter.
+     * @param a_count Size of the first array.
+     * @param b Sorted array of UUIDs to remove.
+     * @param b_count Size of the second array.
+     * @param out Output array, of at least a_count UUIDs.
+     * @return Number of UUIDs written to out.
+     */
+    size_t set_difference(const uuid* a, size_t a_count, const uuid* b, size_t b_count, uuid* out);
+
+    /**
+     * Compute the UUIDs of a sorted array not present in another with several threads.
+     * @param a Sorted array to filter.
+     * @param a_count Size of the first array.
+     * @param b Sorted array of UUIDs to remove.
+     * @param b_count Size of the second array.
+     * @param out Output array, of at least a_count UUIDs.
+     * @param threads Number of threads to use, 0 to use the hardware concurrency.
+     * @return Number of UUIDs written to out.
+     */
+    size_t parallel_set_difference(const uuid* a, size_t a_count, const uuid* b, size_t b_count,
+                                   uuid* out, unsigned threads = 0);
+}
+
+#endif // _UUIDPP_ALGORITHM_HPP_
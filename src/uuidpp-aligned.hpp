@@ -0,0 +1,83 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-aligned.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_ALIGNED_HPP_
+#define _UUIDPP_ALIGNED_HPP_
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+/**
+ * Allocator returning memory aligned on a given boundary, typically a cache line.
+ * @tparam T Type of allocated elements.
+ * @tparam Align Alignment in bytes, power of two multiple of sizeof(void*).
+ */
+template<class T, size_t Align = 64>
+class uuid_aligned_allocator
+{
+public:
+    typedef T value_type;
+
+    template<class U>
+    struct rebind
+    {
+        typedef uuid_aligned_allocator<U, Align> other;
+    };
+
+    uuid_aligned_allocator() = default;
+
+    template<class U>
+    uuid_aligned_allocator(const uuid_aligned_allocator<U, Align>&) {}
+
+    T* allocate(size_t count)
+    {
+        void* ptr = nullptr;
+        if(posix_memalign(&ptr, Align, count * sizeof(T)) != 0)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t)
+    {
+        free(ptr);
+    }
+
+    template<class U>
+    bool operator==(const uuid_aligned_allocator<U, Align>&) const
+    {
+        return true;
+    }
+
+    template<class U>
+    bool operator!=(const uuid_aligned_allocator<U, Align>&) const
+    {
+        return false;
+    }
+};
+
+/** Vector with cache line aligned storage. */
+template<class T>
+using uuid_aligned_vector = std::vector<T, uuid_aligned_allocator<T>>;
+
+#endif // _UUIDPP_ALIGNED_HPP_
@@ -0,0 +1,111 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-bytes.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-bytes.hpp"
+
+#include <cstring>
+
+#include "uuidpp-cpu.hpp"
+
+#if defined(UUIDPP_CPU_X86)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+/**
+ * Byte order of a GUID relatively to the UUID one: first three fields reversed.
+ * The permutation is its own inverse, so it converts both ways.
+ */
+constexpr uint8_t guid_order[16] = {3, 2, 1, 0, 5, 4, 7, 6, 8, 9, 10, 11, 12, 13, 14, 15};
+
+#if defined(UUIDPP_CPU_X86)
+
+/** Swap fields of pairs of records with AVX2, return the number of records done. */
+UUIDPP_TARGET("avx2")
+size_t swap_fields_avx2(const uint8_t* in, size_t count, uint8_t* out)
+{
+    // Byte shuffles stay within 128 bits lanes: one shuffle converts two UUIDs.
+    const __m256i shuffle2 = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(guid_order)));
+    size_t n = 0;
+    for(; n+2<=count; n+=2)
+    {
+        __m256i ids = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + n * 16));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + n * 16), _mm256_shuffle_epi8(ids, shuffle2));
+    }
+    return n;
+}
+
+/** Swap fields of records from n with SSSE3. */
+UUIDPP_TARGET("ssse3")
+void swap_fields_ssse3(const uint8_t* in, size_t n, size_t count, uint8_t* out)
+{
+    const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(guid_order));
+    for(; n<count; ++n)
+    {
+        __m128i id = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + n * 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + n * 16), _mm_shuffle_epi8(id, shuffle));
+    }
+}
+
+#endif
+
+/** Swap the byte order of the three first fields of 16 bytes records. */
+void swap_fields(const uint8_t* in, size_t count, uint8_t* out)
+{
+    size_t n = 0;
+#if defined(UUIDPP_CPU_X86)
+    if(uuid_cpu::has(uuid_cpu::avx2))
+    {
+        n = swap_fields_avx2(in, count, out);
+    }
+    if(uuid_cpu::has(uuid_cpu::ssse3))
+    {
+        swap_fields_ssse3(in, n, count, out);
+        return;
+    }
+#endif
+    for(; n<count; ++n)
+    {
+        uint8_t id[16];
+        std::memcpy(id, in + n * 16, 16);
+        for(size_t b=0; b<16; ++b)
+        {
+            out[n * 16 + b] = id[guid_order[b]];
+        }
+    }
+}
+
+} // anonymous namespace
+
+namespace uuid_bytes
+{
+
+void to_guid(const uuid* ids, size_t count, uint8_t* out)
+{
+    swap_fields(as_bytes(ids), count, out);
+}
+
+void from_guid(const uint8_t* data, size_t count, uuid* out)
+{
+    swap_fields(data, count, as_bytes(out));
+}
+
+} // namespace uuid_bytes
@@ -0,0 +1,192 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-bytes.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_BYTES_HPP_
+#define _UUIDPP_BYTES_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "uuidpp.hpp"
+
+/**
+ * Zero-copy views between UUIDs and raw bytes, and conversions between
+ * RFC 4122 byte order and Microsoft GUID byte order.
+ *
+ * UUIDs are stored in RFC 4122 (big endian) byte order. Microsoft GUID
+ * structures store their three first fields (Data1, Data2 and Data3) in
+ * little endian order, the last 8 bytes being unchanged ("mixed-endian").
+ */
+namespace uuid_bytes
+{
+
+    /**
+     * View a buffer of 16 bytes records as UUIDs, without copy.
+     * @param data Buffer, with no alignment requirement.
+     * @param size Size of buffer in bytes.
+     * @return The UUIDs, size/16 of them.
+     * @throw std::invalid_argument if size is not a multiple of 16.
+     */
+    inline const uuid* as_uuids(const void* data, size_t size)
+    {
+        if(size % sizeof(uuid) != 0)
+        {
+            throw std::invalid_argument("Buffer size is not a multiple of UUID size");
+        }
+        return static_cast<const uuid*>(data);
+    }
+
+    /** @copydoc as_uuids(const void*, size_t) */
+    inline uuid* as_uuids(void* data, size_t size)
+    {
+        return const_cast<uuid*>(as_uuids(static_cast<const void*>(data), size));
+    }
+
+    /**
+     * View UUIDs as raw bytes, without copy.
+     * @param ids UUIDs.
+     * @return The 16 bytes of each UUID, one after the other.
+     */
+    inline const uint8_t* as_bytes(const uuid* ids) noexcept
+    {
+        return reinterpret_cast<const uint8_t*>(ids);
+    }
+
+    /** @copydoc as_bytes(const uuid*) */
+    inline uint8_t* as_bytes(uuid* ids) noexcept
+    {
+        return reinterpret_cast<uint8_t*>(ids);
+    }
+
+    /**
+     * Convert UUIDs to GUID byte order.
+     * @param ids UUIDs to convert.
+     * @param count Number of UUIDs.
+     * @param out Output buffer of count*16 bytes, can be ids itself.
+     * With AVX2, one byte shuffle converts two UUIDs.
+     */
+    void to_guid(const uuid* ids, size_t count, uint8_t* out);
+
+    /**
+     * Convert GUIDs to UUIDs in RFC 4122 byte order.
+     * @param data Buffer of count*16 bytes of GUIDs.
+     * @param count Number of GUIDs.
+     * @param out Output UUIDs, can be data itself.
+     */
+    void from_guid(const uint8_t* data, size_t count, uuid* out);
+
+    /**
+     * Convert a UUID to GUID byte order.
+     * @param id UUID to convert.
+     * @return The 16 bytes of the GUID structure.
+     */
+    inline std::array<uint8_t, 16> to_guid(const uuid& id)
+    {
+        std::array<uint8_t, 16> guid;
+        to_guid(&id, 1, guid.data());
+        return guid;
+    }
+
+    /**
+     * Convert a GUID to a UUID.
+     * @param guid The 16 bytes of the GUID structure.
+     * @return The UUID.
+     */
+    inline uuid from_guid(const std::array<uint8_t, 16>& guid)
+    {
+        uuid id;
+        from_guid(guid.data(), 1, &id);
+        return id;
+    }
+
+    /**
+     * Read-only view of a GUID structure in place, in GUID byte order.
+     * Fields are read on demand, the GUID is never converted as a whole.
+     */
+    class guid_view
+    {
+    public:
+        /**
+         * Construct a view.
+         * @param data The 16 bytes of the GUID structure, with no alignment requirement.
+         */
+        explicit guid_view(const uint8_t* data) noexcept: _data(data) {}
+
+        /** First field, little endian in the structure. */
+        uint32_t data1() const noexcept
+        {
+            return (uint32_t)_data[3] << 24 | (uint32_t)_data[2] << 16 | (uint32_t)_data[1] << 8 | _data[0];
+        }
+
+        /** Second field, little endian in the structure. */
+        uint16_t data2() const noexcept
+        {
+            return (uint16_t)(_data[5] << 8 | _data[4]);
+        }
+
+        /** Third field, little endian in the structure, holding the version. */
+        uint16_t data3() const noexcept
+        {
+            return (uint16_t)(_data[7] << 8 | _data[6]);
+        }
+
+        /** Last 8 bytes, clock sequence and node, in the same order as UUIDs. */
+        const uint8_t* data4() const noexcept {return _data + 8;}
+
+        /** Version of the GUID. */
+        uuid::version_t version() const noexcept
+        {
+            return uuid::version_t(data3() >> 12);
+        }
+
+        /** Raw bytes of the GUID structure. */
+        const uint8_t* data() const noexcept {return _data;}
+
+        /** Convert the GUID to a UUID. */
+        uuid to_uuid() const
+        {
+            uuid id;
+            from_guid(_data, 1, &id);
+            return id;
+        }
+
+        /** Test if the GUID designates the same identifier as a UUID. */
+        bool operator==(const uuid& id) const
+        {
+            return data1() == ((uint32_t)id[0] << 24 | (uint32_t)id[1] << 16 | (uint32_t)id[2] << 8 | id[3])
+                && data2() == (uint16_t)(id[4] << 8 | id[5])
+                && data3() == (uint16_t)(id[6] << 8 | id[7])
+                && std::memcmp(data4(), id.data() + 8, 8) == 0;
+        }
+
+        bool operator!=(const uuid& id) const
+        {
+            return !(*this == id);
+        }
+
+    private:
+        const uint8_t* _data;
+    };
+
+} // namespace uuid_bytes
+
+#endif // _UUIDPP_BYTES_HPP_
@@ -0,0 +1,672 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-cli.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+/*
+ * uuidpp command line tool: generate, convert, validate and extract UUIDs.
+ * Run "uuidpp help" for usage.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "uuidpp.hpp"
+#include "uuidpp-bytes.hpp"
+#include "uuidpp-stream.hpp"
+
+namespace
+{
+
+const char* const usage_text =
+    "Usage: uuidpp <command> [options] [arguments]\n"
+    "\n"
+    "Commands:\n"
+    "  generate [-v version] [-n count] [-f format] [-N namespace] [-s name]\n"
+    "      Generate count UUIDs (default 1) of version 1, 3, 4 (default), 5, 6 or 7.\n"
+    "      Versions 3 and 5 hash the name given with -s, or each line of standard\n"
+    "      input, in namespace -N: dns, url, oid, x500 or a UUID (default dns).\n"
+    "  convert [-i input] [-f format] [uuid...]\n"
+    "      Convert UUIDs given as arguments or read from standard input.\n"
+    "      Input is text (default, any format), binary or guid (16 bytes records).\n"
+    "  validate [-q] [file...]\n"
+    "      Check that each non empty line of files or standard input is a UUID,\n"
+    "      print invalid lines unless -q. Exit status is 1 if any line is invalid.\n"
+    "  extract [-b] [-t types] [-f format] [file...]\n"
+    "      Extract UUIDs embedded in files or standard input. Types is a comma\n"
+    "      separated list of canonical, compact and braced (default all).\n"
+    "      With -b, each UUID is prefixed by its byte offset.\n"
+    "\n"
+    "Output formats (-f): canonical (default), hex, braced, urn, binary, guid.\n";
+
+int usage()
+{
+    fputs(usage_text, stderr);
+    return 2;
+}
+
+/** Output formats. */
+enum class format_t
+{
+    canonical,
+    hex,
+    braced,
+    urn,
+    binary,
+    guid
+};
+
+bool parse_format(const char* arg, format_t& format)
+{
+    static const struct {const char* name; format_t format;} formats[] = {
+        {"canonical", format_t::canonical}, {"hex", format_t::hex}, {"braced", format_t::braced},
+        {"urn", format_t::urn}, {"binary", format_t::binary}, {"guid", format_t::guid}
+    };
+    for(const auto& entry : formats)
+    {
+        if(strcmp(arg, entry.name) == 0)
+        {
+            format = entry.format;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_count(const char* arg, uint64_t& count)
+{
+    char* end;
+    errno = 0;
+    count = strtoull(arg, &end, 10);
+    return errno == 0 && end != arg && *end == 0 && arg[0] != '-';
+}
+
+/** Buffered standard output, written by large blocks. */
+class output
+{
+public:
+    output(): _buffer(1 << 20), _size(0), _failed(false) {}
+
+    ~output()
+    {
+        flush();
+    }
+
+    /** Reserve room for n bytes, to be committed with commit(). */
+    char* reserve(size_t n)
+    {
+        if(_size + n > _buffer.size())
+        {
+            flush();
+        }
+        return _buffer.data() + _size;
+    }
+
+    void commit(char* end)
+    {
+        _size = end - _buffer.data();
+    }
+
+    void write(const char* str, size_t n)
+    {
+        char* ptr = reserve(n);
+        memcpy(ptr, str, n);
+        commit(ptr + n);
+    }
+
+    void write_id(const uuid& id, format_t format)
+    {
+        char* ptr = reserve(64);
+        switch(format)
+        {
+        case format_t::canonical:
+            ptr = id.to_chars(ptr);
+            break;
+        case format_t::hex:
+            ptr = id.to_hex_chars(ptr);
+            break;
+        case format_t::braced:
+            *ptr++ = '{';
+            ptr = id.to_chars(ptr);
+            *ptr++ = '}';
+            break;
+        case format_t::urn:
+            memcpy(ptr, "urn:uuid:", 9);
+            ptr = id.to_chars(ptr + 9);
+            break;
+        case format_t::binary:
+            commit(std::copy(id.begin(), id.end(), ptr));
+            return;
+        case format_t::guid:
+            uuid_bytes::to_guid(&id, 1, reinterpret_cast<uint8_t*>(ptr));
+            commit(ptr + 16);
+            return;
+        }
+        *ptr++ = '\n';
+        commit(ptr);
+    }
+
+    /**
+     * Write buffered bytes and flush standard output.
+     * @return True if all output was written.
+     */
+    bool flush()
+    {
+        if(_size > 0 && !_failed && fwrite(_buffer.data(), 1, _size, stdout) != _size)
+        {
+            _failed = true;
+        }
+        _size = 0;
+        if(!_failed && (fflush(stdout) != 0 || ferror(stdout)))
+        {
+            _failed = true;
+        }
+        return !_failed;
+    }
+
+    /** Test if writing failed, typically on a closed pipe. */
+    bool failed() const
+    {
+        return _failed;
+    }
+
+private:
+    std::vector<char> _buffer;
+    size_t _size;
+    bool _failed;
+};
+
+/** Read standard input or a file line by line, without the line terminator. */
+class line_reader
+{
+public:
+    explicit line_reader(FILE* file): _file(file) {}
+
+    bool next(std::string& line)
+    {
+        line.clear();
+        int c;
+        while((c = getc_unlocked(_file)) != EOF && c != '\n')
+        {
+            line += (char)c;
+        }
+        if(c == EOF && line.empty())
+        {
+            return false;
+        }
+        while(!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+        {
+            line.pop_back();
+        }
+        return true;
+    }
+
+private:
+    FILE* _file;
+};
+
+/** Current time, in 100ns ticks since the Unix epoch. */
+uint64_t unix_100ns_now()
+{
+    return std::chrono::duration_cast<std::chrono::duration<uint64_t, std::ratio<1, 10000000>>>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::mt19937_64& random_engine()
+{
+    static std::random_device device;
+    static std::mt19937_64 engine(((uint64_t)device() << 32) ^ device());
+    return engine;
+}
+
+int generate(int argc, char** argv)
+{
+    unsigned version = 4;
+    uint64_t count = 1;
+    format_t format = format_t::canonical;
+    uuid ns = uuid_ns::dns;
+    const char* name = nullptr;
+    int opt;
+    while((opt = getopt(argc, argv, "v:n:f:N:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'v':
+            version = atoi(optarg);
+            if(version == 0 || version == 2 || version > 7)
+            {
+                return usage();
+            }
+            break;
+        case 'n':
+            if(!parse_count(optarg, count))
+            {
+                return usage();
+            }
+            break;
+        case 'f':
+            if(!parse_format(optarg, format))
+            {
+                return usage();
+            }
+            break;
+        case 'N':
+            if(strcmp(optarg, "dns") == 0) ns = uuid_ns::dns;
+            else if(strcmp(optarg, "url") == 0) ns = uuid_ns::url;
+            else if(strcmp(optarg, "oid") == 0) ns = uuid_ns::oid;
+            else if(strcmp(optarg, "x500") == 0) ns = uuid_ns::x500;
+            else if(!uuid::parse(optarg, strlen(optarg), ns)) return usage();
+            break;
+        case 's':
+            name = optarg;
+            break;
+        default:
+            return usage();
+        }
+    }
+    if(optind != argc)
+    {
+        return usage();
+    }
+
+    output out;
+    if(version == 3 || version == 5)
+    {
+        auto hash = [&](const std::string& str)
+        {
+            out.write_id(version == 3 ? uuid::version3(ns, str) : uuid::version5(ns, str), format);
+        };
+        if(name != nullptr)
+        {
+            hash(name);
+        }
+        else
+        {
+            line_reader reader(stdin);
+            std::string line;
+            while(reader.next(line) && !out.failed())
+            {
+                hash(line);
+            }
+        }
+        return out.flush() ? 0 : 1;
+    }
+
+    std::mt19937_64& engine = random_engine();
+    // Time based versions: consecutive 100ns ticks (or milliseconds and counter for
+    // version 7) from now, random clock sequence and random node with multicast bit
+    // set: runs share no state, concurrent ones must not depend on the clock sequence
+    // alone to differ. Ticks are never taken ahead of the clock: when they are
+    // exhausted, generation stalls until the clock advances (RFC 4122, section 4.2.1.2).
+    uint64_t timestamp = unix_100ns_now() + 0x01B21DD213814000ull;
+    uint64_t timestamp_end = timestamp + 1;
+    const uint16_t clock_seq = (uint16_t)engine();
+    const uint64_t node = (engine() & 0xFFFFFFFFFFFFull) | 0x010000000000ull;
+    uint64_t unix_ms = (timestamp - 0x01B21DD213814000ull) / 10000;
+    uint16_t counter = engine() & 0x7FF;
+    auto next_timestamp = [&]()
+    {
+        while(timestamp >= timestamp_end)
+        {
+            timestamp_end = unix_100ns_now() + 0x01B21DD213814000ull + 1;
+            if(timestamp >= timestamp_end)
+            {
+                std::this_thread::yield();
+            }
+        }
+        return timestamp++;
+    };
+
+    uuid batch[4096];
+    while(count > 0 && !out.failed())
+    {
+        size_t size = (size_t)std::min<uint64_t>(count, 4096);
+        switch(version)
+        {
+        case 4:
+            uuid::version4(batch, size);
+            break;
+        case 1:
+        case 6:
+            for(size_t n=0; n<size; ++n)
+            {
+                uint64_t time = next_timestamp();
+                batch[n] = version == 1 ? uuid::version1(time, clock_seq, node)
+                                        : uuid::version6(time, clock_seq, node);
+            }
+            break;
+        case 7:
+            for(size_t n=0; n<size; ++n)
+            {
+                if(++counter > 0xFFF)
+                {
+                    // Counter exhausted: wait for the next millisecond.
+                    uint64_t now_ms;
+                    while((now_ms = unix_100ns_now() / 10000) <= unix_ms)
+                    {
+                        std::this_thread::yield();
+                    }
+                    unix_ms = now_ms;
+                    counter = engine() & 0x7FF;
+                }
+                batch[n] = uuid::version7(unix_ms, counter, engine());
+            }
+            break;
+        }
+        for(size_t n=0; n<size; ++n)
+        {
+            out.write_id(batch[n], format);
+        }
+        count -= size;
+    }
+    return out.flush() ? 0 : 1;
+}
+
+int convert(int argc, char** argv)
+{
+    enum {text, binary, guid} input = text;
+    format_t format = format_t::canonical;
+    int opt;
+    while((opt = getopt(argc, argv, "i:f:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'i':
+            if(strcmp(optarg, "text") == 0) input = text;
+            else if(strcmp(optarg, "binary") == 0) input = binary;
+            else if(strcmp(optarg, "guid") == 0) input = guid;
+            else return usage();
+            break;
+        case 'f':
+            if(!parse_format(optarg, format))
+            {
+                return usage();
+            }
+            break;
+        default:
+            return usage();
+        }
+    }
+
+    int status = 0;
+    output out;
+    uuid id;
+    if(optind < argc)
+    {
+        for(int arg=optind; arg<argc; ++arg)
+        {
+            if(uuid::parse(argv[arg], strlen(argv[arg]), id))
+            {
+                out.write_id(id, format);
+            }
+            else
+            {
+                fprintf(stderr, "uuidpp: not a UUID: %s\n", argv[arg]);
+                status = 1;
+            }
+        }
+    }
+    else if(input == text)
+    {
+        line_reader reader(stdin);
+        std::string line;
+        for(size_t number=1; reader.next(line) && !out.failed(); ++number)
+        {
+            if(uuid::parse(line.data(), line.size(), id))
+            {
+                out.write_id(id, format);
+            }
+            else if(!line.empty())
+            {
+                fprintf(stderr, "uuidpp: line %zu: not a UUID: %s\n", number, line.c_str());
+                status = 1;
+            }
+        }
+    }
+    else
+    {
+        // Read bytes rather than records, to see a truncated last record.
+        uuid batch[4096];
+        size_t bytes = 0, read;
+        while((read = fread(uuid_bytes::as_bytes(batch) + bytes, 1, sizeof(batch) - bytes, stdin)) > 0
+              && !out.failed())
+        {
+            bytes += read;
+            size_t size = bytes / sizeof(uuid);
+            if(input == guid)
+            {
+                uuid_bytes::from_guid(uuid_bytes::as_bytes(batch), size, batch);
+            }
+            for(size_t n=0; n<size; ++n)
+            {
+                out.write_id(batch[n], format);
+            }
+            bytes -= size * sizeof(uuid);
+            std::memmove(uuid_bytes::as_bytes(batch), uuid_bytes::as_bytes(batch + size), bytes);
+        }
+        if(ferror(stdin))
+        {
+            fprintf(stderr, "uuidpp: cannot read standard input: %s\n", strerror(errno));
+            status = 1;
+        }
+        else if(bytes != 0 && !out.failed())
+        {
+            fprintf(stderr, "uuidpp: truncated record of %zu bytes at end of input\n", bytes);
+            status = 1;
+        }
+    }
+    return out.flush() ? status : 1;
+}
+
+int validate(int argc, char** argv)
+{
+    bool quiet = false;
+    int opt;
+    while((opt = getopt(argc, argv, "q")) != -1)
+    {
+        if(opt != 'q')
+        {
+            return usage();
+        }
+        quiet = true;
+    }
+
+    int status = 0;
+    output out;
+    auto check = [&](FILE* file, const char* path)
+    {
+        line_reader reader(file);
+        std::string line;
+        uuid id;
+        for(size_t number=1; reader.next(line); ++number)
+        {
+            if(!line.empty() && !uuid::parse(line.data(), line.size(), id))
+            {
+                status = 1;
+                if(!quiet)
+                {
+                    std::string message = std::string(path) + ":" + std::to_string(number) + ": " + line + "\n";
+                    out.write(message.data(), message.size());
+                }
+            }
+        }
+    };
+    if(optind == argc)
+    {
+        check(stdin, "-");
+    }
+    for(int arg=optind; arg<argc; ++arg)
+    {
+        FILE* file = strcmp(argv[arg], "-") == 0 ? stdin : fopen(argv[arg], "r");
+        if(file == nullptr)
+        {
+            fprintf(stderr, "uuidpp: cannot open %s: %s\n", argv[arg], strerror(errno));
+            status = 1;
+            continue;
+        }
+        check(file, argv[arg]);
+        if(file != stdin)
+        {
+            fclose(file);
+        }
+    }
+    return out.flush() ? status : 1;
+}
+
+bool parse_types(const char* arg, unsigned& types)
+{
+    types = 0;
+    std::string list(arg);
+    for(size_t begin=0; begin<=list.size();)
+    {
+        size_t end = std::min(list.find(',', begin), list.size());
+        std::string type = list.substr(begin, end - begin);
+        if(type == "canonical") types |= uuid_scanner::canonical;
+        else if(type == "compact") types |= uuid_scanner::compact;
+        else if(type == "braced") types |= uuid_scanner::braced;
+        else return false;
+        begin = end + 1;
+    }
+    return types != 0;
+}
+
+int extract(int argc, char** argv)
+{
+    bool offsets = false;
+    unsigned types = uuid_scanner::all;
+    format_t format = format_t::canonical;
+    int opt;
+    while((opt = getopt(argc, argv, "bt:f:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'b':
+            offsets = true;
+            break;
+        case 't':
+            if(!parse_types(optarg, types))
+            {
+                return usage();
+            }
+            break;
+        case 'f':
+            if(!parse_format(optarg, format))
+            {
+                return usage();
+            }
+            break;
+        default:
+            return usage();
+        }
+    }
+
+    int status = 0;
+    output out;
+    const uuid_scanner scanner(types);
+    auto run = [&](uuid_extractor& extractor)
+    {
+        uuid_match matches[4096];
+        size_t count;
+        while((count = extractor.read(matches, 4096)) > 0 && !out.failed())
+        {
+            for(size_t n=0; n<count; ++n)
+            {
+                if(offsets)
+                {
+                    std::string offset = std::to_string(matches[n].offset) + " ";
+                    out.write(offset.data(), offset.size());
+                }
+                out.write_id(matches[n].id, format);
+            }
+        }
+    };
+    std::vector<const char*> paths(argv + optind, argv + argc);
+    if(paths.empty())
+    {
+        paths.push_back("-");
+    }
+    for(const char* path : paths)
+    {
+        try
+        {
+            if(strcmp(path, "-") == 0)
+            {
+                uuid_extractor extractor(STDIN_FILENO, scanner);
+                run(extractor);
+            }
+            else
+            {
+                uuid_extractor extractor(std::string(path), scanner);
+                run(extractor);
+            }
+        }
+        catch(const std::system_error& error)
+        {
+            fprintf(stderr, "uuidpp: %s\n", error.what());
+            status = 1;
+        }
+    }
+    return out.flush() ? status : 1;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        return usage();
+    }
+    std::string command = argv[1];
+    // Options are parsed after the command name.
+    --argc;
+    ++argv;
+    if(command == "generate")
+    {
+        return generate(argc, argv);
+    }
+    if(command == "convert")
+    {
+        return convert(argc, argv);
+    }
+    if(command == "validate")
+    {
+        return validate(argc, argv);
+    }
+    if(command == "extract")
+    {
+        return extract(argc, argv);
+    }
+    if(command == "help" || command == "--help" || command == "-h")
+    {
+        fputs(usage_text, stdout);
+        return 0;
+    }
+    return usage();
+}
@@ -0,0 +1,235 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-clock.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-clock.hpp"
+
+#include <chrono>
+
+#include <time.h>
+
+#include "uuidpp-cpu.hpp"
+
+#if defined(UUIDPP_CPU_X86)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+namespace
+{
+
+uint64_t realtime() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+class system_clock : public uuid_clock
+{
+public:
+    uint64_t now() noexcept override
+    {
+        return realtime();
+    }
+};
+
+class coarse_clock : public uuid_clock
+{
+public:
+    uint64_t now() noexcept override
+    {
+#if defined(CLOCK_REALTIME_COARSE)
+        struct timespec ts;
+        ::clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+        return realtime();
+#endif
+    }
+};
+
+/** Time stamp counter, or a nanosecond counter where there is none. */
+inline uint64_t read_tsc() noexcept
+{
+#if defined(UUIDPP_CPU_X86)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/** Rate of the counter, as nanoseconds per cycle in 32.32 fixed point. */
+uint64_t rate(uint64_t ns, uint64_t cycles) noexcept
+{
+    if(cycles == 0)
+    {
+        return (uint64_t)1 << 32;
+    }
+#if defined(__SIZEOF_INT128__)
+    return (uint64_t)(((unsigned __int128)ns << 32) / cycles);
+#else
+    return (uint64_t)((long double)ns * 4294967296.0L / cycles);
+#endif
+}
+
+/** Cycles of a time at a rate. */
+uint64_t cycles(uint64_t ns, uint64_t mult) noexcept
+{
+    return (uint64_t)((double)ns * 4294967296.0 / (double)mult);
+}
+
+/** Test if two rates differ by at most uuid_tsc_clock::max_drift_ppm. */
+bool close_rates(uint64_t a, uint64_t b) noexcept
+{
+    const uint64_t diff = a > b ? a - b : b - a;
+    return diff <= b / (1000000 / uuid_tsc_clock::max_drift_ppm);
+}
+
+} // anonymous namespace
+
+constexpr uint64_t uuid_tsc_clock::max_drift_ppm;
+
+uuid_clock& uuid_clock::system() noexcept
+{
+    static system_clock clock;
+    return clock;
+}
+
+uuid_clock& uuid_clock::coarse() noexcept
+{
+    static coarse_clock clock;
+    return clock;
+}
+
+uuid_clock& uuid_clock::tsc() noexcept
+{
+    if(!uuid_tsc_clock::supported())
+    {
+        return system();
+    }
+    static uuid_tsc_clock clock;
+    return clock;
+}
+
+bool uuid_tsc_clock::supported() noexcept
+{
+#if defined(UUIDPP_CPU_X86)
+    // CPUID leaf 0x80000007, EDX bit 8: invariant TSC.
+    unsigned eax, ebx, ecx, edx;
+    return __get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) && eax >= 0x80000007
+        && __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+uuid_tsc_clock::uuid_tsc_clock(uint64_t resync_ns, uuid_clock& reference):
+_reference(&reference)
+{
+    // Products of elapsed cycles by the rate must not overflow: 4s at most.
+    _resync_ns = resync_ns < 4000000000ull ? resync_ns : 4000000000ull;
+    uint64_t origin_tsc, tsc;
+    uint64_t origin_ns = reference_at(origin_tsc), ns;
+    do
+    {
+        ns = reference_at(tsc);
+        if(ns < origin_ns)
+        {
+            // Clock set back meanwhile: start again.
+            origin_ns = ns;
+            origin_tsc = tsc;
+        }
+    }
+    while(ns - origin_ns < 1000000);
+
+    const uint64_t mult = rate(ns - origin_ns, tsc - origin_tsc);
+    _measured = mult;
+    _base_tsc.store(tsc, std::memory_order_relaxed);
+    _base_ns.store(ns, std::memory_order_relaxed);
+    _mult.store(mult, std::memory_order_relaxed);
+    _resync_cycles.store(cycles(_resync_ns, mult), std::memory_order_relaxed);
+}
+
+uint64_t uuid_tsc_clock::reference_at(uint64_t& tsc) noexcept
+{
+    // Middle of counter reads around the clock read.
+    uint64_t before = read_tsc();
+    uint64_t ns = _reference->now();
+    tsc = before + (read_tsc() - before) / 2;
+    return ns;
+}
+
+uint64_t uuid_tsc_clock::now() noexcept
+{
+    const uint64_t tsc = read_tsc();
+    for(;;)
+    {
+        const uint64_t sequence = _sequence.load(std::memory_order_acquire);
+        const uint64_t base_tsc = _base_tsc.load(std::memory_order_relaxed);
+        const uint64_t base_ns = _base_ns.load(std::memory_order_relaxed);
+        const uint64_t mult = _mult.load(std::memory_order_relaxed);
+        const uint64_t resync_cycles = _resync_cycles.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if((sequence & 1) != 0 || _sequence.load(std::memory_order_relaxed) != sequence)
+        {
+            continue;
+        }
+        // Read before a resynchronization by another thread: as of the resynchronization.
+        const uint64_t elapsed = tsc > base_tsc ? tsc - base_tsc : 0;
+        if(elapsed < resync_cycles)
+        {
+            return base_ns + (elapsed * mult >> 32);
+        }
+        const uint64_t ns = resync(sequence);
+        if(ns != 0)
+        {
+            return ns;
+        }
+    }
+}
+
+uint64_t uuid_tsc_clock::resync(uint64_t sequence) noexcept
+{
+    // One thread resynchronizes, others read the new calibration once published.
+    if(!_sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire))
+    {
+        return 0;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    uint64_t tsc;
+    const uint64_t ns = reference_at(tsc);
+    const uint64_t base_tsc = _base_tsc.load(std::memory_order_relaxed);
+    const uint64_t base_ns = _base_ns.load(std::memory_order_relaxed);
+    if(ns > base_ns && tsc > base_tsc)
+    {
+        // Rate since the last calibration. A step of the real time clock
+        // makes it drift: the clock is then only set to the real time. A
+        // drift found twice in a row is a wrong rate instead.
+        const uint64_t measured = rate(ns - base_ns, tsc - base_tsc);
+        if(close_rates(measured, _mult.load(std::memory_order_relaxed)) || close_rates(measured, _measured))
+        {
+            _mult.store(measured, std::memory_order_relaxed);
+            _resync_cycles.store(cycles(_resync_ns, measured), std::memory_order_relaxed);
+        }
+        _measured = measured;
+    }
+    _base_tsc.store(tsc, std::memory_order_relaxed);
+    _base_ns.store(ns, std::memory_order_relaxed);
+    _sequence.store(sequence + 2, std::memory_order_release);
+    _resyncs.fetch_add(1, std::memory_order_relaxed);
+    return ns;
+}
@@ -0,0 +1,157 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-clock.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_CLOCK_HPP_
+#define _UUIDPP_CLOCK_HPP_
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Source of time of time based UUIDs (versions 1, 6 and 7), in nanoseconds
+ * since the Unix epoch.
+ *
+ * Generators read the clock once per call, so its cost bounds their rate:
+ * - system(): the real time clock of the OS, precise, about 20-50ns a read;
+ * - coarse(): the real time clock at the last tick of the OS (1 to 4ms on
+ *   Linux), a few ns a read; generators count UUIDs between ticks;
+ * - tsc(): the processor time stamp counter, calibrated against the real
+ *   time clock and resynchronized every second, a few ns a read;
+ * - uuid_fake_clock: set by hand, for deterministic tests.
+ *
+ * Generators do not rely on clocks being monotonic: they never go back.
+ */
+class uuid_clock
+{
+public:
+    virtual ~uuid_clock() = default;
+
+    /** Current time, in nanoseconds since the Unix epoch. Thread safe. */
+    virtual uint64_t now() noexcept = 0;
+
+    /** Real time clock of the OS. */
+    static uuid_clock& system() noexcept;
+
+    /** Coarse real time clock of the OS, the system clock where there is none. */
+    static uuid_clock& coarse() noexcept;
+
+    /** Clock of the processor time stamp counter, the system clock if the counter is not invariant. */
+    static uuid_clock& tsc() noexcept;
+
+    /** Convert a time to 100ns ticks since the Gregorian epoch, as in versions 1 and 6. */
+    static constexpr uint64_t gregorian_ticks(uint64_t ns)
+    {
+        return ns / 100 + 0x01B21DD213814000ull;
+    }
+
+    /** Convert a time to milliseconds since the Unix epoch, as in version 7. */
+    static constexpr uint64_t unix_ms(uint64_t ns)
+    {
+        return ns / 1000000;
+    }
+};
+
+/**
+ * Clock counting processor cycles, x86 only.
+ *
+ * The time stamp counter is converted with a rate measured against the
+ * real time clock between consecutive resynchronizations; at each
+ * resynchronization the clock is also set back to the real time clock,
+ * so it follows its adjustments. A rate drifting by more than max_drift_ppm
+ * from the current one is taken for a step of the real time clock (set by
+ * hand or by NTP) and ignored, unless the previous measure found it too.
+ * Readers take no lock: they read the last calibration, published with a
+ * sequence counter.
+ */
+class uuid_tsc_clock : public uuid_clock
+{
+public:
+    /** True if the counter is invariant: same rate on all cores whatever their power state. */
+    static bool supported() noexcept;
+
+    /** Largest change of rate between resynchronizations not taken for a step of the real time clock. */
+    static constexpr uint64_t max_drift_ppm = 500;
+
+    /**
+     * Create a clock, calibrating it for about 1ms.
+     * @param resync_ns Time between resynchronizations to the real time clock, 4s at most.
+     * @param reference Real time clock, outliving this clock.
+     */
+    explicit uuid_tsc_clock(uint64_t resync_ns = 1000000000, uuid_clock& reference = uuid_clock::system());
+
+    uint64_t now() noexcept override;
+
+    /** Number of resynchronizations since creation. */
+    uint64_t resyncs() const noexcept {return _resyncs.load(std::memory_order_relaxed);}
+
+private:
+    /** Take a new calibration point unless another thread does, returning the real time or 0. */
+    uint64_t resync(uint64_t sequence) noexcept;
+
+    /** Read the reference clock and the counter at the same time. */
+    uint64_t reference_at(uint64_t& tsc) noexcept;
+
+    uuid_clock* _reference;
+    uint64_t _resync_ns;
+    /** Rate measured by the last resynchronization, accepted or not. */
+    uint64_t _measured = 0;
+
+    /** Odd while a calibration is published. */
+    std::atomic<uint64_t> _sequence{0};
+    /** Last calibration: ns = base_ns + (tsc - base_tsc) * mult >> 32. */
+    std::atomic<uint64_t> _base_tsc{0};
+    std::atomic<uint64_t> _base_ns{0};
+    std::atomic<uint64_t> _mult{0};
+    /** Cycles between resynchronizations at the rate, so that products by the rate do not overflow. */
+    std::atomic<uint64_t> _resync_cycles{0};
+    std::atomic<uint64_t> _resyncs{0};
+};
+
+/** Clock set by hand, optionally advancing at each read. */
+class uuid_fake_clock : public uuid_clock
+{
+public:
+    /**
+     * Create a fake clock.
+     * @param start Time of the first read.
+     * @param step Time added after each read.
+     */
+    explicit uuid_fake_clock(uint64_t start = 0, uint64_t step = 0) noexcept:
+    _time(start), _step(step)
+    {
+    }
+
+    uint64_t now() noexcept override
+    {
+        return _time.fetch_add(_step, std::memory_order_relaxed);
+    }
+
+    /** Set the time of the next read. */
+    void set(uint64_t ns) noexcept {_time.store(ns, std::memory_order_relaxed);}
+
+    /** Move the time forward (or backward, with a negative amount). */
+    void advance(int64_t ns) noexcept {_time.fetch_add((uint64_t)ns, std::memory_order_relaxed);}
+
+private:
+    std::atomic<uint64_t> _time;
+    uint64_t _step;
+};
+
+#endif // _UUIDPP_CLOCK_HPP_
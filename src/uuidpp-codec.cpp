@@ -0,0 +1,512 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-codec.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-codec.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "uuidpp-cpu.hpp"
+
+#if defined(UUIDPP_CPU_X86)
+#include <immintrin.h>
+#endif
+
+#include "uuidpp-endian.hpp"
+
+constexpr size_t uuid_compressed_array::block_size;
+
+namespace
+{
+
+const uint8_t magic[4] = {'U', 'U', 'Z', '1'};
+
+/** Size of the stream header: magic and count. */
+constexpr size_t header_size = 4 + 8;
+
+/** Size of a block header: first hi, delta minimum, lo minimum, widths, exception count, reserved. */
+constexpr size_t block_header_size = 8 + 8 + 8 + 4;
+
+/** Position of the byte fields in a block header. */
+constexpr size_t hi_width_field = 24, lo_width_field = 25, exceptions_field = 26;
+
+/** Zero bytes ending the stream, so that unpacking can always read 8 bytes. */
+constexpr size_t padding_size = 8;
+
+using uuid_endian::load_be64;
+using uuid_endian::store_be64;
+using uuid_endian::load_le64;
+using uuid_endian::store_le64;
+
+inline void append_le64(std::vector<uint8_t>& out, uint64_t val)
+{
+    for(int n=0; n<8; ++n)
+    {
+        out.push_back((uint8_t)(val >> (8 * n)));
+    }
+}
+
+inline unsigned bit_width(uint64_t val)
+{
+    return val == 0 ? 0 : 64 - __builtin_clzll(val);
+}
+
+inline uint64_t low_mask(unsigned width)
+{
+    return width >= 64 ? ~0ull : (1ull << width) - 1;
+}
+
+inline size_t packed_bytes(size_t count, unsigned width)
+{
+    return (count * width + 7) / 8;
+}
+
+/** Number of LEB128 bytes needed for a value of a given bit width. */
+inline size_t varint_bytes(unsigned width)
+{
+    return width <= 7 ? 1 : (width + 6) / 7;
+}
+
+/** Little endian bit packer. */
+class bit_writer
+{
+public:
+    bit_writer(std::vector<uint8_t>& out): _out(out) {}
+
+    void put(uint64_t val, unsigned width)
+    {
+        for(unsigned done=0; done<width;)
+        {
+            unsigned take = std::min(width - done, 56u);
+            _acc |= ((val >> done) & low_mask(take)) << _bits;
+            _bits += take;
+            done += take;
+            while(_bits >= 8)
+            {
+                _out.push_back((uint8_t)_acc);
+                _acc >>= 8;
+                _bits -= 8;
+            }
+        }
+    }
+
+    void flush()
+    {
+        if(_bits != 0)
+        {
+            _out.push_back((uint8_t)_acc);
+        }
+        _acc = 0;
+        _bits = 0;
+    }
+
+private:
+    std::vector<uint8_t>& _out;
+    uint64_t _acc = 0;
+    unsigned _bits = 0;
+};
+
+/** Read a packed value, reading up to 9 bytes from its first byte. */
+inline uint64_t bits_at(const uint8_t* data, size_t bitpos, unsigned width)
+{
+    const uint8_t* ptr = data + bitpos / 8;
+    unsigned shift = bitpos % 8;
+    uint64_t val = load_le64(ptr) >> shift;
+    if(shift + width > 64)
+    {
+        val |= (uint64_t)ptr[8] << (64 - shift);
+    }
+    return val & low_mask(width);
+}
+
+#if defined(UUIDPP_CPU_X86)
+
+/** Unpack values of width <= 56 four at a time with AVX2, return the number of values done. */
+UUIDPP_TARGET("avx2")
+size_t unpack_avx2(const uint8_t* data, size_t count, unsigned width, uint64_t* out)
+{
+    // Gather the 8 bytes holding each value, then shift and mask.
+    const __m256i mask = _mm256_set1_epi64x((long long)low_mask(width));
+    const __m256i seven = _mm256_set1_epi64x(7);
+    const __m256i step = _mm256_set1_epi64x(4 * (long long)width);
+    __m256i bitpos = _mm256_setr_epi64x(0, width, 2 * width, 3 * width);
+    size_t n = 0;
+    for(; n+4<=count; n+=4)
+    {
+        __m256i bytes = _mm256_srli_epi64(bitpos, 3);
+        __m256i words = _mm256_i64gather_epi64(reinterpret_cast<const long long*>(data), bytes, 1);
+        words = _mm256_srlv_epi64(words, _mm256_and_si256(bitpos, seven));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + n), _mm256_and_si256(words, mask));
+        bitpos = _mm256_add_epi64(bitpos, step);
+    }
+    return n;
+}
+
+/** Prefix sum four values at a time with AVX2 from position 1, return the first position not done. */
+UUIDPP_TARGET("avx2")
+size_t prefix_sum_avx2(uint64_t* vals, size_t count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i carry = _mm256_set1_epi64x((long long)vals[0]);
+    size_t n = 1;
+    for(; n+4<=count; n+=4)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vals + n));
+        // [a, b, c, d] -> [a, a+b, b+c, c+d] -> [a, a+b, a+b+c, a+b+c+d]
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x90), zero, 0x03));
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x40), zero, 0x0F));
+        x = _mm256_add_epi64(x, carry);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(vals + n), x);
+        carry = _mm256_permute4x64_epi64(x, 0xFF);
+    }
+    return n;
+}
+
+#endif
+
+/** Unpack count values of a given width. */
+void unpack(const uint8_t* data, size_t count, unsigned width, uint64_t* out)
+{
+    size_t n = 0;
+    if(width == 0)
+    {
+        std::fill(out, out + count, 0);
+        return;
+    }
+#if defined(UUIDPP_CPU_X86)
+    if(width <= 56 && uuid_cpu::has(uuid_cpu::avx2))
+    {
+        n = unpack_avx2(data, count, width, out);
+    }
+#endif
+    for(; n<count; ++n)
+    {
+        out[n] = bits_at(data, n * width, width);
+    }
+}
+
+/** In place inclusive prefix sum. */
+void prefix_sum(uint64_t* vals, size_t count)
+{
+    size_t n = 1;
+#if defined(UUIDPP_CPU_X86)
+    if(uuid_cpu::has(uuid_cpu::avx2))
+    {
+        n = prefix_sum_avx2(vals, count);
+    }
+#endif
+    for(; n<count; ++n)
+    {
+        vals[n] += vals[n-1];
+    }
+}
+
+/** Choose the PFOR width minimizing the block size. */
+unsigned choose_width(const uint64_t* deltas, size_t count)
+{
+    size_t widths[65] = {0};
+    for(size_t n=0; n<count; ++n)
+    {
+        ++widths[bit_width(deltas[n])];
+    }
+    unsigned best = 64;
+    size_t best_cost = count * 64 + 1;
+    for(unsigned width=0; width<64; ++width)
+    {
+        size_t cost = count * width;
+        for(unsigned w=width+1; w<=64; ++w)
+        {
+            cost += widths[w] * 8 * (1 + varint_bytes(w - width));
+        }
+        if(cost < best_cost)
+        {
+            best = width;
+            best_cost = cost;
+        }
+    }
+    return best;
+}
+
+void encode_block(const uuid* ids, size_t count, std::vector<uint8_t>& out)
+{
+    uint64_t hi[uuid_compressed_array::block_size], lo[uuid_compressed_array::block_size];
+    for(size_t n=0; n<count; ++n)
+    {
+        hi[n] = load_be64(ids[n].data());
+        lo[n] = load_be64(ids[n].data() + 8);
+    }
+
+    uint64_t deltas[uuid_compressed_array::block_size];
+    for(size_t n=1; n<count; ++n)
+    {
+        deltas[n-1] = hi[n] - hi[n-1];
+    }
+    // Frame of reference: constant strides (as in version 1 UUIDs) pack in zero bits.
+    uint64_t delta_min = count > 1 ? *std::min_element(deltas, deltas + count - 1) : 0;
+    for(size_t n=0; n<count-1; ++n)
+    {
+        deltas[n] -= delta_min;
+    }
+    unsigned hi_width = choose_width(deltas, count - 1);
+
+    uint64_t lo_min = *std::min_element(lo, lo + count), lo_max = *std::max_element(lo, lo + count);
+    unsigned lo_width = bit_width(lo_max - lo_min);
+
+    size_t exceptions = 0;
+    for(size_t n=0; n<count-1; ++n)
+    {
+        exceptions += bit_width(deltas[n]) > hi_width;
+    }
+
+    append_le64(out, hi[0]);
+    append_le64(out, delta_min);
+    append_le64(out, lo_min);
+    out.push_back((uint8_t)hi_width);
+    out.push_back((uint8_t)lo_width);
+    out.push_back((uint8_t)exceptions);
+    out.push_back(0);
+
+    bit_writer writer(out);
+    for(size_t n=0; n<count-1; ++n)
+    {
+        writer.put(deltas[n], hi_width);
+    }
+    writer.flush();
+    for(size_t n=0; n<count; ++n)
+    {
+        writer.put(lo[n] - lo_min, lo_width);
+    }
+    writer.flush();
+
+    for(size_t n=0; n<count-1; ++n)
+    {
+        if(bit_width(deltas[n]) > hi_width)
+        {
+            out.push_back((uint8_t)n);
+            for(uint64_t high = deltas[n] >> hi_width; ; high >>= 7)
+            {
+                if(high < 0x80)
+                {
+                    out.push_back((uint8_t)high);
+                    break;
+                }
+                out.push_back((uint8_t)(high | 0x80));
+            }
+        }
+    }
+}
+
+/**
+ * Read a LEB128 value.
+ * @return Pointer after the value, nullptr if the value is truncated or too long.
+ */
+const uint8_t* read_varint(const uint8_t* ptr, const uint8_t* end, uint64_t& val)
+{
+    val = 0;
+    for(unsigned shift=0; shift<64 && ptr<end; shift+=7)
+    {
+        uint8_t byte = *ptr++;
+        val |= (uint64_t)(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0)
+        {
+            return ptr;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Compute the end of a block, checking its content.
+ * @return Pointer after the block, nullptr if the block is invalid.
+ */
+const uint8_t* check_block(const uint8_t* block, const uint8_t* end, size_t count)
+{
+    if(end - block < (ptrdiff_t)block_header_size)
+    {
+        return nullptr;
+    }
+    unsigned hi_width = block[hi_width_field], lo_width = block[lo_width_field], exceptions = block[exceptions_field];
+    if(hi_width > 64 || lo_width > 64 || exceptions > count - 1)
+    {
+        return nullptr;
+    }
+    size_t packed = packed_bytes(count - 1, hi_width) + packed_bytes(count, lo_width);
+    if((size_t)(end - block) - block_header_size < packed)
+    {
+        return nullptr;
+    }
+    const uint8_t* ptr = block + block_header_size + packed;
+    for(unsigned e=0; e<exceptions; ++e)
+    {
+        uint64_t high;
+        if(ptr == end || *ptr >= count - 1 || hi_width == 64)
+        {
+            return nullptr;
+        }
+        ptr = read_varint(ptr + 1, end, high);
+        if(ptr == nullptr)
+        {
+            return nullptr;
+        }
+    }
+    return ptr;
+}
+
+} // anonymous namespace
+
+uuid_compressed_array::uuid_compressed_array():
+uuid_compressed_array(nullptr, 0)
+{
+}
+
+uuid_compressed_array::uuid_compressed_array(const uuid* ids, size_t count):
+_count(count)
+{
+    const size_t blocks = block_count();
+    const size_t table = header_size;
+    _data.resize(table + 8 * blocks);
+    std::memcpy(_data.data(), magic, sizeof(magic));
+    store_le64(&_data[4], count);
+    const size_t base = _data.size();
+
+    for(size_t block=0; block<blocks; ++block)
+    {
+        store_le64(&_data[table + 8 * block], _data.size() - base);
+        size_t first = block * block_size;
+        encode_block(ids + first, std::min(block_size, count - first), _data);
+    }
+    _data.resize(_data.size() + padding_size, 0);
+}
+
+uuid_compressed_array uuid_compressed_array::from_bytes(const uint8_t* data, size_t size)
+{
+    if(size < header_size + padding_size || std::memcmp(data, magic, 4) != 0)
+    {
+        throw std::invalid_argument("Not a compressed UUID array");
+    }
+    uint64_t count = load_le64(data + 4);
+    // Bound the count by the size before rounding it up to blocks, so that it cannot overflow.
+    const uint64_t max_blocks = (size - header_size - padding_size) / (8 + block_header_size);
+    if(count / block_size > max_blocks)
+    {
+        throw std::invalid_argument("Truncated compressed UUID array");
+    }
+    uint64_t blocks = (count + block_size - 1) / block_size;
+    if(blocks > max_blocks)
+    {
+        throw std::invalid_argument("Truncated compressed UUID array");
+    }
+
+    const uint8_t* base = data + header_size + 8 * blocks;
+    const uint8_t* end = data + size - padding_size;
+    const uint8_t* ptr = base;
+    for(uint64_t block=0; block<blocks; ++block)
+    {
+        if(load_le64(data + header_size + 8 * block) != (uint64_t)(ptr - base))
+        {
+            throw std::invalid_argument("Invalid block offset in compressed UUID array");
+        }
+        ptr = check_block(ptr, end, std::min<uint64_t>(block_size, count - block * block_size));
+        if(ptr == nullptr)
+        {
+            throw std::invalid_argument("Invalid block in compressed UUID array");
+        }
+    }
+    if(ptr != end)
+    {
+        throw std::invalid_argument("Trailing data in compressed UUID array");
+    }
+
+    uuid_compressed_array res;
+    res._count = count;
+    res._data.assign(data, data + size);
+    return res;
+}
+
+const uint8_t* uuid_compressed_array::block_data(size_t block) const
+{
+    const uint8_t* base = _data.data() + header_size + 8 * block_count();
+    return base + load_le64(_data.data() + header_size + 8 * block);
+}
+
+size_t uuid_compressed_array::decode_block(size_t block, uint64_t* hi, uint64_t* lo) const
+{
+    const size_t count = std::min(block_size, _count - block * block_size);
+    const uint8_t* ptr = block_data(block);
+    const unsigned hi_width = ptr[hi_width_field], lo_width = ptr[lo_width_field], exceptions = ptr[exceptions_field];
+    const uint64_t delta_min = load_le64(ptr + 8);
+    const uint64_t lo_min = load_le64(ptr + 16);
+
+    hi[0] = load_le64(ptr);
+    ptr += block_header_size;
+    unpack(ptr, count - 1, hi_width, hi + 1);
+    ptr += packed_bytes(count - 1, hi_width);
+    unpack(ptr, count, lo_width, lo);
+    ptr += packed_bytes(count, lo_width);
+
+    for(unsigned e=0; e<exceptions; ++e)
+    {
+        uint64_t high;
+        size_t index = *ptr;
+        ptr = read_varint(ptr + 1, _data.data() + _data.size(), high);
+        hi[index + 1] |= high << hi_width;
+    }
+    for(size_t n=1; n<count; ++n)
+    {
+        hi[n] += delta_min;
+    }
+    prefix_sum(hi, count);
+    for(size_t n=0; n<count; ++n)
+    {
+        lo[n] += lo_min;
+    }
+    return count;
+}
+
+size_t uuid_compressed_array::decode_block(size_t block, uuid* out) const
+{
+    uint64_t hi[block_size], lo[block_size];
+    size_t count = decode_block(block, hi, lo);
+    for(size_t n=0; n<count; ++n)
+    {
+        store_be64(out[n].data(), hi[n]);
+        store_be64(out[n].data() + 8, lo[n]);
+    }
+    return count;
+}
+
+void uuid_compressed_array::decode(uuid* out) const
+{
+    for(size_t block=0, blocks=block_count(); block<blocks; ++block)
+    {
+        out += decode_block(block, out);
+    }
+}
+
+uuid uuid_compressed_array::at(size_t pos) const
+{
+    if(pos >= _count)
+    {
+        throw std::out_of_range("UUID position out of compressed array");
+    }
+    uint64_t hi[block_size], lo[block_size];
+    decode_block(pos / block_size, hi, lo);
+    return uuid(hi[pos % block_size], lo[pos % block_size]);
+}
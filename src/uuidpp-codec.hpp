@@ -0,0 +1,126 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-codec.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_CODEC_HPP_
+#define _UUIDPP_CODEC_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "uuidpp.hpp"
+
+/**
+ * Compressed array of UUIDs, efficient for sorted or time ordered sequences.
+ *
+ * UUIDs are encoded by blocks of 128, each block being decodable alone.
+ * In a block, most significant 64 bits are delta encoded from the first one,
+ * deltas being bit packed relatively to their minimum with patched frame of
+ * reference (PFOR: deltas wider than the chosen width are stored as exceptions). Least significant 64 bits are
+ * bit packed relatively to their minimum (FOR).
+ *
+ * Any sequence can be encoded, but only sequences whose most significant
+ * bits increase slowly (sorted UUIDs, version 1 UUIDs of a node, version 6
+ * and 7 UUIDs) are really compressed.
+ *
+ * Encoded format, all integers being little endian:
+ * - "UUZ1" magic and format version,
+ * - UUID count on 8 bytes,
+ * - offset of each block from the end of the offset table, on 8 bytes each,
+ * - blocks, made of the first most significant 64 bits, the minimum delta,
+ *   the minimum of least significant 64 bits, the delta width, the least significant width,
+ *   the exception count and a reserved byte, followed by packed deltas,
+ *   packed least significant bits and exceptions (delta index byte and
+ *   LEB128 value of bits beyond the delta width),
+ * - 8 padding bytes.
+ */
+class uuid_compressed_array
+{
+public:
+    /** Number of UUIDs per block. */
+    static constexpr size_t block_size = 128;
+
+    /** Construct an empty array. */
+    uuid_compressed_array();
+
+    /**
+     * Compress UUIDs.
+     * @param ids UUIDs to compress.
+     * @param count Number of UUIDs.
+     */
+    uuid_compressed_array(const uuid* ids, size_t count);
+
+    /**
+     * Load an encoded array.
+     * @param data Encoded array, as returned by bytes().
+     * @param size Size of encoded array in bytes.
+     * @return The loaded array.
+     * @throw std::invalid_argument if data is not a valid encoded array.
+     */
+    static uuid_compressed_array from_bytes(const uint8_t* data, size_t size);
+
+    /** Encoded array, to store or send. */
+    const std::vector<uint8_t>& bytes() const noexcept {return _data;}
+
+    /** Number of UUIDs. */
+    size_t size() const noexcept {return _count;}
+
+    /** Number of blocks. */
+    size_t block_count() const noexcept {return (_count + block_size - 1) / block_size;}
+
+    /**
+     * Decode all UUIDs.
+     * @param out Output array of size() UUIDs.
+     */
+    void decode(uuid* out) const;
+
+    /**
+     * Decode one block.
+     * @param block Index of the block, less than block_count().
+     * @param out Output array of at least block_size UUIDs.
+     * @return Number of decoded UUIDs.
+     */
+    size_t decode_block(size_t block, uuid* out) const;
+
+    /**
+     * Decode the most and least significant halves of one block, as native integers.
+     * @param block Index of the block, less than block_count().
+     * @param hi Output array of at least block_size most significant halves.
+     * @param lo Output array of at least block_size least significant halves.
+     * @return Number of decoded UUIDs.
+     */
+    size_t decode_block(size_t block, uint64_t* hi, uint64_t* lo) const;
+
+    /**
+     * Decode one UUID.
+     * @param pos Position of the UUID.
+     * @return The UUID.
+     * @throw std::out_of_range if pos is not less than size().
+     */
+    uuid at(size_t pos) const;
+
+private:
+    const uint8_t* block_data(size_t block) const;
+
+    size_t _count = 0;
+    std::vector<uint8_t> _data;
+};
+
+#endif // _UUIDPP_CODEC_HPP_
@@ -0,0 +1,309 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-column.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-column.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "uuidpp-cpu.hpp"
+
+#if defined(UUIDPP_CPU_X86)
+#include <immintrin.h>
+#endif
+
+#include "uuidpp-endian.hpp"
+
+namespace
+{
+
+using uuid_endian::load_be64;
+using uuid_endian::store_be64;
+
+/**
+ * Filter on the most significant halves, evaluated 64 UUIDs at a time:
+ * accept min <= hi <= max with (hi & mask) == value.
+ */
+struct hi_filter
+{
+    uint64_t min, span, mask, value;
+
+    hi_filter(uint64_t min_hi, uint64_t max_hi, uint64_t field_mask = 0, uint64_t field_value = 0):
+    min(min_hi), span(max_hi - min_hi), mask(field_mask), value(field_value)
+    {}
+
+    bool accept(uint64_t hi) const
+    {
+        return (hi - min) <= span && (hi & mask) == value;
+    }
+
+    /** Bitmap of accepted UUIDs among n <= 64 consecutive ones. */
+    uint64_t word(const uint64_t* hi, size_t n) const
+    {
+        uint64_t bits = 0;
+        size_t i = 0;
+#if defined(UUIDPP_CPU_X86)
+        if(uuid_cpu::has(uuid_cpu::avx2))
+        {
+            i = n & ~(size_t)3;
+            bits = word_avx2(hi, i);
+        }
+#endif
+        for(; i<n; ++i)
+        {
+            bits |= (uint64_t)accept(hi[i]) << i;
+        }
+        return bits;
+    }
+
+#if defined(UUIDPP_CPU_X86)
+    /** Bitmap of accepted UUIDs among n <= 64 consecutive ones, n multiple of 4. */
+    UUIDPP_TARGET("avx2")
+    uint64_t word_avx2(const uint64_t* hi, size_t n) const
+    {
+        const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ull);
+        const __m256i vmin = _mm256_set1_epi64x((long long)min);
+        const __m256i vspan = _mm256_set1_epi64x((long long)(span ^ 0x8000000000000000ull));
+        const __m256i vmask = _mm256_set1_epi64x((long long)mask);
+        const __m256i vvalue = _mm256_set1_epi64x((long long)value);
+        uint64_t bits = 0;
+        for(size_t i=0; i<n; i+=4)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hi + i));
+            // Unsigned (x - min) > span, as a signed comparison of biased values.
+            __m256i out = _mm256_cmpgt_epi64(_mm256_xor_si256(_mm256_sub_epi64(x, vmin), sign), vspan);
+            __m256i field = _mm256_cmpeq_epi64(_mm256_and_si256(x, vmask), vvalue);
+            __m256i ok = _mm256_andnot_si256(out, field);
+            bits |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(ok)) << i;
+        }
+        return bits;
+    }
+#endif
+};
+
+/** Filter on both halves, accepting one UUID. */
+struct equal_filter
+{
+    uint64_t hi, lo;
+
+    uint64_t word(const uint64_t* his, const uint64_t* los, size_t n) const
+    {
+        uint64_t bits = 0;
+        size_t i = 0;
+#if defined(UUIDPP_CPU_X86)
+        if(uuid_cpu::has(uuid_cpu::avx2))
+        {
+            i = n & ~(size_t)3;
+            bits = word_avx2(his, los, i);
+        }
+#endif
+        for(; i<n; ++i)
+        {
+            bits |= (uint64_t)((his[i] == hi) & (los[i] == lo)) << i;
+        }
+        return bits;
+    }
+
+#if defined(UUIDPP_CPU_X86)
+    /** Bitmap of equal UUIDs among n <= 64 consecutive ones, n multiple of 4. */
+    UUIDPP_TARGET("avx2")
+    uint64_t word_avx2(const uint64_t* his, const uint64_t* los, size_t n) const
+    {
+        const __m256i vhi = _mm256_set1_epi64x((long long)hi);
+        const __m256i vlo = _mm256_set1_epi64x((long long)lo);
+        uint64_t bits = 0;
+        for(size_t i=0; i<n; i+=4)
+        {
+            __m256i eq_hi = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(his + i)), vhi);
+            __m256i eq_lo = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(los + i)), vlo);
+            bits |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_and_si256(eq_hi, eq_lo))) << i;
+        }
+        return bits;
+    }
+#endif
+};
+
+/** Filter of version 1 UUIDs, whose timestamp fields must be reordered before comparison. */
+struct v1_time_filter
+{
+    uint64_t from, span;
+
+    uint64_t word(const uint64_t* hi, size_t n) const
+    {
+        uint64_t bits = 0;
+        for(size_t i=0; i<n; ++i)
+        {
+            uint64_t h = hi[i];
+            uint64_t time = ((h & 0x0FFF) << 48) | (((h >> 16) & 0xFFFF) << 32) | (h >> 32);
+            bool ok = (time - from) <= span && (h & 0xF000) == 0x1000;
+            bits |= (uint64_t)ok << i;
+        }
+        return bits;
+    }
+};
+
+/** Write positions of bits set in a bitmap word. */
+inline size_t write_positions(uint64_t bits, size_t base, size_t* positions)
+{
+    size_t count = 0;
+    while(bits != 0)
+    {
+        positions[count++] = base + __builtin_ctzll(bits);
+        bits &= bits - 1;
+    }
+    return count;
+}
+
+/**
+ * Run a filter 64 UUIDs at a time and collect accepted positions.
+ * @param count Number of UUIDs.
+ * @param word Function returning the bitmap for n UUIDs from a position.
+ */
+template<class Word>
+size_t select(size_t count, size_t* positions, Word word)
+{
+    size_t selected = 0;
+    for(size_t base=0; base<count; base+=64)
+    {
+        selected += write_positions(word(base, std::min<size_t>(64, count - base)), base, positions + selected);
+    }
+    return selected;
+}
+
+} // anonymous namespace
+
+void uuid_column::push_back(const uuid& id)
+{
+    _hi.push_back(load_be64(id.data()));
+    _lo.push_back(load_be64(id.data() + 8));
+}
+
+void uuid_column::append(const uuid* ids, size_t count)
+{
+    size_t pos = size();
+    _hi.resize(pos + count);
+    _lo.resize(pos + count);
+    uint64_t* hi = _hi.data() + pos;
+    uint64_t* lo = _lo.data() + pos;
+    for(size_t n=0; n<count; ++n)
+    {
+        hi[n] = load_be64(ids[n].data());
+        lo[n] = load_be64(ids[n].data() + 8);
+    }
+}
+
+void uuid_column::copy_to(size_t pos, size_t count, uuid* out) const
+{
+    const uint64_t* hi = _hi.data() + pos;
+    const uint64_t* lo = _lo.data() + pos;
+    for(size_t n=0; n<count; ++n)
+    {
+        store_be64(out[n].data(), hi[n]);
+        store_be64(out[n].data() + 8, lo[n]);
+    }
+}
+
+void uuid_column::set(size_t pos, const uuid& id)
+{
+    _hi[pos] = load_be64(id.data());
+    _lo[pos] = load_be64(id.data() + 8);
+}
+
+size_t uuid_column::mask_hi_range(uint64_t min_hi, uint64_t max_hi, uint64_t* bitmap) const
+{
+    const size_t count = size();
+    size_t selected = 0;
+    for(size_t base=0; base<count; base+=64)
+    {
+        uint64_t bits = min_hi <= max_hi
+                ? hi_filter(min_hi, max_hi).word(_hi.data() + base, std::min<size_t>(64, count - base))
+                : 0;
+        bitmap[base / 64] = bits;
+        selected += __builtin_popcountll(bits);
+    }
+    return selected;
+}
+
+size_t uuid_column::select_hi_range(uint64_t min_hi, uint64_t max_hi, size_t* positions) const
+{
+    if(min_hi > max_hi)
+    {
+        return 0;
+    }
+    const hi_filter filter(min_hi, max_hi);
+    return select(size(), positions, [&](size_t base, size_t n)
+    {
+        return filter.word(_hi.data() + base, n);
+    });
+}
+
+size_t uuid_column::select_equal(const uuid& id, size_t* positions) const
+{
+    const equal_filter filter{load_be64(id.data()), load_be64(id.data() + 8)};
+    return select(size(), positions, [&](size_t base, size_t n)
+    {
+        return filter.word(_hi.data() + base, _lo.data() + base, n);
+    });
+}
+
+size_t uuid_column::select_time_range(uuid::version_t version, uint64_t from, uint64_t to, size_t* positions) const
+{
+    if(version == uuid::version_t::version_time_based)
+    {
+        to = std::min<uint64_t>(to, 0x0FFFFFFFFFFFFFFFull);
+        if(from > to)
+        {
+            return 0;
+        }
+        const v1_time_filter filter{from, to - from};
+        return select(size(), positions, [&](size_t base, size_t n)
+        {
+            return filter.word(_hi.data() + base, n);
+        });
+    }
+
+    // Versions 6 and 7 keep timestamps in most significant bits, their ranges map to ranges of hi.
+    uint64_t min_hi, max_hi;
+    if(version == uuid::version_t::version_reordered_time_based)
+    {
+        to = std::min<uint64_t>(to, 0x0FFFFFFFFFFFFFFFull);
+        min_hi = ((from << 4) & 0xFFFFFFFFFFFF0000ull) | 0x6000 | (from & 0x0FFF);
+        max_hi = ((to << 4) & 0xFFFFFFFFFFFF0000ull) | 0x6000 | (to & 0x0FFF);
+    }
+    else if(version == uuid::version_t::version_unix_time_based)
+    {
+        to = std::min<uint64_t>(to, 0xFFFFFFFFFFFFull);
+        min_hi = from << 16;
+        max_hi = (to << 16) | 0xFFFF;
+    }
+    else
+    {
+        return 0;
+    }
+    if(from > to)
+    {
+        return 0;
+    }
+
+    const hi_filter filter(min_hi, max_hi, 0xF000, (uint64_t)version << 12);
+    return select(size(), positions, [&](size_t base, size_t n)
+    {
+        return filter.word(_hi.data() + base, n);
+    });
+}
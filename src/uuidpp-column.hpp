@@ -0,0 +1,156 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-column.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_COLUMN_HPP_
+#define _UUIDPP_COLUMN_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "uuidpp.hpp"
+#include "uuidpp-iterator.hpp"
+#include "uuidpp-aligned.hpp"
+
+/**
+ * Column of UUIDs stored as struct of arrays.
+ * Most and least significant 64 bits of UUIDs are stored in two separate
+ * cache line aligned arrays of native integers, so that scans can read
+ * only one half (typically the high one, holding timestamps of time-based UUIDs).
+ */
+class uuid_column
+{
+public:
+    /** Random access iterator building UUIDs on the fly from both halves. */
+    typedef uuid_split_iterator<uuid_column> const_iterator;
+
+    /** Construct an empty column. */
+    uuid_column() = default;
+
+    /**
+     * Construct a column from an array of UUIDs.
+     * @param ids UUIDs to copy.
+     * @param count Number of UUIDs.
+     */
+    uuid_column(const uuid* ids, size_t count)
+    {
+        append(ids, count);
+    }
+
+    /** Number of UUIDs. */
+    size_t size() const noexcept {return _hi.size();}
+
+    /** Test if the column is empty. */
+    bool empty() const noexcept {return _hi.empty();}
+
+    /** Reserve storage for a number of UUIDs. */
+    void reserve(size_t count)
+    {
+        _hi.reserve(count);
+        _lo.reserve(count);
+    }
+
+    /** Remove all UUIDs. */
+    void clear() noexcept
+    {
+        _hi.clear();
+        _lo.clear();
+    }
+
+    /** Append a UUID. */
+    void push_back(const uuid& id);
+
+    /**
+     * Append UUIDs.
+     * @param ids UUIDs to copy.
+     * @param count Number of UUIDs.
+     */
+    void append(const uuid* ids, size_t count);
+
+    /**
+     * Copy UUIDs out of the column.
+     * @param pos Position of the first UUID to copy.
+     * @param count Number of UUIDs to copy.
+     * @param out Output array of count UUIDs.
+     */
+    void copy_to(size_t pos, size_t count, uuid* out) const;
+
+    /** Retrieve the UUID at a position. */
+    uuid operator[](size_t pos) const
+    {
+        return uuid(_hi[pos], _lo[pos]);
+    }
+
+    /** Replace the UUID at a position. */
+    void set(size_t pos, const uuid& id);
+
+    /** Most significant 64 bits of UUIDs, as native integers. */
+    const uint64_t* hi() const noexcept {return _hi.data();}
+
+    /** Least significant 64 bits of UUIDs, as native integers. */
+    const uint64_t* lo() const noexcept {return _lo.data();}
+
+    const_iterator begin() const {return const_iterator(this, 0);}
+    const_iterator end() const {return const_iterator(this, size());}
+
+    /**
+     * Build a bitmap of UUIDs whose most significant 64 bits are in a range.
+     * @param min_hi Lowest accepted value, included.
+     * @param max_hi Highest accepted value, included.
+     * @param bitmap Output array of (size()+63)/64 words, bit n%64 of word n/64
+     * is set if UUID n is accepted.
+     * @return Number of accepted UUIDs.
+     */
+    size_t mask_hi_range(uint64_t min_hi, uint64_t max_hi, uint64_t* bitmap) const;
+
+    /**
+     * Select UUIDs whose most significant 64 bits are in a range.
+     * @param min_hi Lowest accepted value, included.
+     * @param max_hi Highest accepted value, included.
+     * @param positions Output array of at least size() positions.
+     * @return Number of accepted UUIDs, whose positions are written in increasing order.
+     */
+    size_t select_hi_range(uint64_t min_hi, uint64_t max_hi, size_t* positions) const;
+
+    /**
+     * Select occurrences of a UUID.
+     * @param id UUID to look for.
+     * @param positions Output array of at least size() positions.
+     * @return Number of occurrences, whose positions are written in increasing order.
+     */
+    size_t select_equal(const uuid& id, size_t* positions) const;
+
+    /**
+     * Select time-based UUIDs of a version whose timestamp is in a range.
+     * Versions 6 and 7 are filtered on their most significant bits only.
+     * @param version Version of UUIDs to accept: time based (1),
+     * reordered time based (6) or Unix time based (7).
+     * @param from Lowest accepted timestamp, included. Number of 100ns since
+     * 15 October 1582 for versions 1 and 6, of milliseconds since Unix Epoch for version 7.
+     * @param to Highest accepted timestamp, included.
+     * @param positions Output array of at least size() positions.
+     * @return Number of accepted UUIDs, whose positions are written in increasing order.
+     */
+    size_t select_time_range(uuid::version_t version, uint64_t from, uint64_t to, size_t* positions) const;
+
+private:
+    uuid_aligned_vector<uint64_t> _hi, _lo;
+};
+
+#endif // _UUIDPP_COLUMN_HPP_
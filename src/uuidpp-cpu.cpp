@@ -0,0 +1,138 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-cpu.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-cpu.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+const char* const names[] = {"scalar", "sse2", "ssse3", "sse4.2", "avx2", "avx512"};
+
+uuid_cpu::level probe() noexcept
+{
+#if defined(UUIDPP_CPU_X86)
+    // The builtins check CPUID bits and that the OS saves the extended registers.
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx2"))
+    {
+        return uuid_cpu::avx512;
+    }
+    if(__builtin_cpu_supports("avx2"))
+    {
+        return uuid_cpu::avx2;
+    }
+    if(__builtin_cpu_supports("sse4.2"))
+    {
+        return uuid_cpu::sse4_2;
+    }
+    if(__builtin_cpu_supports("ssse3"))
+    {
+        return uuid_cpu::ssse3;
+    }
+    if(__builtin_cpu_supports("sse2"))
+    {
+        return uuid_cpu::sse2;
+    }
+#endif
+    return uuid_cpu::scalar;
+}
+
+/** Lower a level to a supported one. */
+uuid_cpu::level clamp(uuid_cpu::level l) noexcept
+{
+    if(uuid_cpu::supported(l))
+    {
+        return l;
+    }
+    return uuid_cpu::detected();
+}
+
+/** Detected level, lowered by UUIDPP_CPU if set. */
+uuid_cpu::level initial() noexcept
+{
+    uuid_cpu::level l = uuid_cpu::detected();
+    const char* env = std::getenv("UUIDPP_CPU");
+    uuid_cpu::level requested;
+    if(env != nullptr && uuid_cpu::parse(env, requested))
+    {
+        l = clamp(requested);
+    }
+    return l;
+}
+
+std::atomic<unsigned>& current() noexcept
+{
+    static std::atomic<unsigned> level(initial());
+    return level;
+}
+
+/** Probe at load rather than on the first kernel call. */
+const bool initialized = (current(), true);
+
+} // anonymous namespace
+
+namespace uuid_cpu
+{
+
+level detected() noexcept
+{
+    static const level best = probe();
+    return best;
+}
+
+level active() noexcept
+{
+    return static_cast<level>(current().load(std::memory_order_relaxed));
+}
+
+bool supported(level l) noexcept
+{
+    return l <= detected();
+}
+
+level select(level l) noexcept
+{
+    l = clamp(l);
+    current().store(l, std::memory_order_relaxed);
+    return l;
+}
+
+const char* name(level l) noexcept
+{
+    return l <= avx512 ? names[l] : "unknown";
+}
+
+bool parse(const char* str, level& out) noexcept
+{
+    for(unsigned n=scalar; n<=avx512; ++n)
+    {
+        if(std::strcmp(str, names[n]) == 0)
+        {
+            out = static_cast<level>(n);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace uuid_cpu
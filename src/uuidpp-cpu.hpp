@@ -0,0 +1,100 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-cpu.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_CPU_HPP_
+#define _UUIDPP_CPU_HPP_
+
+#if defined(__x86_64__) || defined(__i386__)
+#define UUIDPP_CPU_X86 1
+#endif
+
+/**
+ * Compile a kernel for an instruction set whatever the compilation flags,
+ * inlining its callees so that templates instantiated for the kernel use
+ * the instruction set too. Kernels must only be called when uuid_cpu::has()
+ * accepts their level.
+ */
+#define UUIDPP_TARGET(isa) __attribute__((target(isa), flatten))
+
+/**
+ * Runtime selection of SIMD kernels.
+ *
+ * The processor is probed once (CPUID on x86) and the best
+ * supported level is used by all kernels of the library. The level can be
+ * lowered with the UUIDPP_CPU environment variable (for example
+ * UUIDPP_CPU=sse4.2 or UUIDPP_CPU=scalar) or with select(), to compare
+ * kernels or to test every path on a single machine.
+ */
+namespace uuid_cpu
+{
+
+    /** SIMD levels, ordered: each one implies the previous ones. */
+    enum level : unsigned
+    {
+        /** Portable code only. */
+        scalar = 0,
+        sse2,
+        ssse3,
+        sse4_2,
+        avx2,
+        /** AVX-512 F and BW. */
+        avx512
+    };
+
+    /** Best level supported by the processor. */
+    level detected() noexcept;
+
+    /** Level used by kernels. */
+    level active() noexcept;
+
+    /**
+     * Test if kernels of a level can be used.
+     * @param l Level of a kernel.
+     * @return True if the active level is l or implies it.
+     */
+    inline bool has(level l) noexcept
+    {
+        return l <= active();
+    }
+
+    /** Test if a level is supported by the processor. */
+    bool supported(level l) noexcept;
+
+    /**
+     * Change the level used by kernels, from now on.
+     * @param l Requested level, lowered to the best supported one if not supported.
+     * @return Level actually selected.
+     */
+    level select(level l) noexcept;
+
+    /** Name of a level, as accepted by UUIDPP_CPU: "scalar", "sse2", "ssse3", "sse4.2", "avx2" or "avx512". */
+    const char* name(level l) noexcept;
+
+    /**
+     * Find a level by name.
+     * @param str Name of the level.
+     * @param out Found level.
+     * @return True if the name is known.
+     */
+    bool parse(const char* str, level& out) noexcept;
+
+} // namespace uuid_cpu
+
+#endif // _UUIDPP_CPU_HPP_
@@ -0,0 +1,324 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-dispenser.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-dispenser.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "uuidpp-aligned.hpp"
+#include "uuidpp-node.hpp"
+
+constexpr size_t uuid_dispenser_cursor::default_block;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "stream positions must be shared without locks");
+
+/** Shared memory segment: written once by its creator, then only the stream position changes. */
+struct uuid_dispenser::segment
+{
+    /** Set last by the creator, when other fields are valid. */
+    std::atomic<uint32_t> magic{0};
+    uint32_t format_version = 0;
+    uint8_t version = 0;
+    uint16_t clock_seq = 0;
+    uint64_t node = 0;
+
+    /** Next free position of the stream, alone in its cache line. */
+    alignas(64) std::atomic<uint64_t> next{0};
+};
+
+namespace
+{
+
+/** "UDSP" */
+constexpr uint32_t segment_magic = 0x50534455;
+constexpr uint32_t segment_format_version = 1;
+
+std::mt19937_64& random_engine()
+{
+    static thread_local std::mt19937_64 engine(((uint64_t)std::random_device()() << 32) ^ std::random_device()());
+    return engine;
+}
+
+uint16_t random_clock_seq()
+{
+    return (uint16_t)(random_engine()() & 0x3FFF);
+}
+
+void check_version(uuid::version_t version)
+{
+    if(version != uuid::version_t::version_time_based
+       && version != uuid::version_t::version_reordered_time_based
+       && version != uuid::version_t::version_unix_time_based)
+    {
+        throw std::invalid_argument("UUID dispensers only dispense versions 1, 6 and 7");
+    }
+}
+
+/** Unlock and close a segment: mappings keep the lock of the file description otherwise. */
+void release(int fd)
+{
+    ::flock(fd, LOCK_UN);
+    ::close(fd);
+}
+
+/** Construct a segment in memory, publishing it with its magic number last. */
+uuid_dispenser::segment* construct(void* memory, uuid::version_t version, uint64_t node, uint16_t clock_seq)
+{
+    uuid_dispenser::segment* seg = new(memory) uuid_dispenser::segment;
+    seg->format_version = segment_format_version;
+    seg->version = (uint8_t)version;
+    seg->node = node & 0xFFFFFFFFFFFFull;
+    seg->clock_seq = clock_seq & 0x3FFF;
+    seg->magic.store(segment_magic, std::memory_order_release);
+    return seg;
+}
+
+} // anonymous namespace
+
+uuid_dispenser::uuid_dispenser(uuid::version_t version, uuid_clock& clock):
+uuid_dispenser(version, uuid_node::host(), random_clock_seq(), clock)
+{
+}
+
+uuid_dispenser::uuid_dispenser(uuid::version_t version, uint64_t node, uint16_t clock_seq, uuid_clock& clock):
+_version(version), _clock(&clock)
+{
+    check_version(version);
+    init_private(node, clock_seq);
+}
+
+uuid_dispenser::uuid_dispenser(const std::string& name, uuid::version_t version, uuid_clock& clock):
+uuid_dispenser(name, version, uuid_node::host(), random_clock_seq(), clock)
+{
+}
+
+uuid_dispenser::uuid_dispenser(const std::string& name, uuid::version_t version, uint64_t node, uint16_t clock_seq,
+                               uuid_clock& clock):
+_version(version), _clock(&clock)
+{
+    check_version(version);
+    init_shared(name, node, clock_seq);
+}
+
+uuid_dispenser::~uuid_dispenser()
+{
+    if(_map_size != 0)
+    {
+        ::munmap(_segment, _map_size);
+    }
+    else if(_segment != nullptr)
+    {
+        _segment->~segment();
+        uuid_aligned_allocator<segment>().deallocate(_segment, 1);
+    }
+}
+
+void uuid_dispenser::init_private(uint64_t node, uint16_t clock_seq)
+{
+    _segment = construct(uuid_aligned_allocator<segment>().allocate(1), _version, node, clock_seq);
+}
+
+void uuid_dispenser::init_shared(const std::string& name, uint64_t node, uint16_t clock_seq)
+{
+    const size_t size = sizeof(segment);
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if(fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot open shared memory " + name);
+    }
+    // Openings are serialized: a segment left unpublished by a creator which
+    // died (magic still 0) is initialized by the next opener.
+    struct stat st;
+    if(::flock(fd, LOCK_EX) != 0 || ::fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        release(fd);
+        throw std::system_error(err, std::generic_category(), "Cannot lock shared memory " + name);
+    }
+    if((size_t)st.st_size < size && ::ftruncate(fd, size) != 0)
+    {
+        int err = errno;
+        release(fd);
+        throw std::system_error(err, std::generic_category(), "Cannot size shared memory " + name);
+    }
+
+    void* map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED)
+    {
+        int err = errno;
+        release(fd);
+        throw std::system_error(err, std::generic_category(), "Cannot map shared memory " + name);
+    }
+
+    segment* seg = static_cast<segment*>(map);
+    const uint32_t magic = seg->magic.load(std::memory_order_acquire);
+    if(magic == 0)
+    {
+        seg = construct(map, _version, node, clock_seq);
+    }
+    release(fd);
+    if(magic != 0 && magic != segment_magic)
+    {
+        ::munmap(map, size);
+        throw std::invalid_argument("Not a UUID dispenser segment: " + name);
+    }
+    if(seg->format_version != segment_format_version || seg->version != (uint8_t)_version)
+    {
+        ::munmap(map, size);
+        throw std::invalid_argument("UUID dispenser segment " + name + " is of another version");
+    }
+    _segment = seg;
+    _map_size = size;
+}
+
+bool uuid_dispenser::unlink(const std::string& name)
+{
+    return ::shm_unlink(name.c_str()) == 0;
+}
+
+uint64_t uuid_dispenser::node() const noexcept
+{
+    return _segment->node;
+}
+
+uint16_t uuid_dispenser::clock_seq() const noexcept
+{
+    return _segment->clock_seq;
+}
+
+uint64_t uuid_dispenser::now()
+{
+    const uint64_t ns = _clock->now();
+    if(_version == uuid::version_t::version_unix_time_based)
+    {
+        // Milliseconds, then a 12 bits counter.
+        return uuid_clock::unix_ms(ns) << 12;
+    }
+    return uuid_clock::gregorian_ticks(ns);
+}
+
+uint64_t uuid_dispenser::reserve(size_t count)
+{
+    const uint64_t time = now();
+    std::atomic<uint64_t>& next = _segment->next;
+    uint64_t current = next.load(std::memory_order_relaxed);
+    for(;;)
+    {
+        const uint64_t first = current > time ? current : time;
+        if(next.compare_exchange_weak(current, first + count, std::memory_order_relaxed))
+        {
+            return first;
+        }
+    }
+}
+
+size_t uuid_dispenser::reserve_block(size_t count, uint64_t& first)
+{
+    const uint64_t time = now();
+    std::atomic<uint64_t>& next = _segment->next;
+    uint64_t current = next.load(std::memory_order_relaxed);
+    for(;;)
+    {
+        first = current > time ? current : time;
+        size_t reserved = count;
+        if(_version == uuid::version_t::version_unix_time_based)
+        {
+            // Counter values left in the millisecond.
+            const uint64_t left = ((first | 0xFFF) + 1) - first;
+            reserved = left < count ? (size_t)left : count;
+        }
+        if(next.compare_exchange_weak(current, first + reserved, std::memory_order_relaxed))
+        {
+            return reserved;
+        }
+    }
+}
+
+uuid uuid_dispenser::make(uint64_t position)
+{
+    switch(_version)
+    {
+    case uuid::version_t::version_time_based:
+        return uuid::version1(position, _segment->clock_seq, _segment->node);
+    case uuid::version_t::version_reordered_time_based:
+        return uuid::version6(position, _segment->clock_seq, _segment->node);
+    default:
+        return uuid::version7(position >> 12, position & 0xFFF, random_engine()());
+    }
+}
+
+uuid uuid_dispenser::take()
+{
+    uuid id;
+    take(&id, 1);
+    return id;
+}
+
+void uuid_dispenser::take(uuid* out, size_t count)
+{
+    if(count == 0)
+    {
+        return;
+    }
+    uint64_t position = reserve(count);
+    switch(_version)
+    {
+    case uuid::version_t::version_time_based:
+        for(size_t n=0; n<count; ++n)
+        {
+            out[n] = uuid::version1(position++, _segment->clock_seq, _segment->node);
+        }
+        break;
+    case uuid::version_t::version_reordered_time_based:
+        for(size_t n=0; n<count; ++n)
+        {
+            out[n] = uuid::version6(position++, _segment->clock_seq, _segment->node);
+        }
+        break;
+    default:
+    {
+        std::mt19937_64& engine = random_engine();
+        for(size_t n=0; n<count; ++n, ++position)
+        {
+            out[n] = uuid::version7(position >> 12, position & 0xFFF, engine());
+        }
+        break;
+    }
+    }
+}
+
+void uuid_dispenser_cursor::refill()
+{
+    uint64_t first;
+    const size_t count = _dispenser.reserve_block(_block, first);
+    _next = first;
+    _end = first + count;
+    ++_refills;
+}
@@ -0,0 +1,231 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-dispenser.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_DISPENSER_HPP_
+#define _UUIDPP_DISPENSER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "uuidpp.hpp"
+#include "uuidpp-clock.hpp"
+
+/**
+ * Dispenser of unique time based UUIDs (versions 1, 6 and 7) shared by
+ * threads, and optionally by processes of a host.
+ *
+ * UUIDs are positions of a monotonic stream: 100ns ticks since the
+ * Gregorian epoch for versions 1 and 6, Unix milliseconds followed by a
+ * 12 bits counter for version 7. Taking UUIDs reserves the next positions
+ * of the stream with one compare-and-swap, a position never being before
+ * the current time; when UUIDs are taken faster than the clock runs, the
+ * stream runs ahead of it. UUIDs are then built by the taking thread, so
+ * that take(n) costs a single atomic operation for n UUIDs.
+ *
+ * In shared mode the stream position lives in a POSIX shared memory
+ * segment mapped by every process: taking UUIDs needs no system call
+ * and all processes draw from the same stream. The node and clock
+ * sequence of versions 1 and 6 are those of the process creating the
+ * segment. Segments are created under a file lock: one left uninitialized
+ * by a creator which died is initialized by the next process opening it.
+ *
+ * A private dispenser is not fork-safe: a forked process would take the
+ * same positions, hence the same UUIDs, as its parent. Forked processes
+ * must create their own dispenser, or share one through a segment.
+ *
+ * To read the clock once for many UUIDs, threads can take them through
+ * their own uuid_dispenser_cursor.
+ *
+ * Versions 1 and 6 UUIDs are distinct for a node and clock sequence,
+ * version 7 UUIDs are distinct whatever their random bits. Versions 6 and 7
+ * UUIDs taken by a thread are increasing.
+ */
+class uuid_dispenser
+{
+public:
+    /**
+     * Create a dispenser private to the process, with the node of the host
+     * (see uuid_node::host()) and a random clock sequence.
+     * @param version Version of dispensed UUIDs: time based, reordered time based or Unix time based.
+     * @param clock Source of time.
+     * @throw std::invalid_argument if the version is not time based.
+     */
+    explicit uuid_dispenser(uuid::version_t version, uuid_clock& clock = uuid_clock::system());
+
+    /**
+     * Create a dispenser private to the process.
+     * @param version Version of dispensed UUIDs: time based, reordered time based or Unix time based.
+     * @param node Node of versions 1 and 6 UUIDs (48 least significant bits).
+     * @param clock_seq Clock sequence of versions 1 and 6 UUIDs (14 least significant bits).
+     * @param clock Source of time.
+     * @throw std::invalid_argument if the version is not time based.
+     */
+    uuid_dispenser(uuid::version_t version, uint64_t node, uint16_t clock_seq, uuid_clock& clock = uuid_clock::system());
+
+    /**
+     * Create or open a dispenser shared through a POSIX shared memory segment.
+     * If the segment does not exist, it is created with the node of the host and a random clock sequence.
+     * @param name Name of the segment, "/name" as for shm_open.
+     * @param version Version of dispensed UUIDs, must be the one of the segment if it exists.
+     * @param clock Source of time of this process.
+     * @throw std::invalid_argument if the version is not time based, or not the one of the segment.
+     * @throw std::system_error if the segment cannot be created, opened or mapped.
+     */
+    uuid_dispenser(const std::string& name, uuid::version_t version, uuid_clock& clock = uuid_clock::system());
+
+    /**
+     * Create or open a dispenser shared through a POSIX shared memory segment.
+     * @param name Name of the segment, "/name" as for shm_open.
+     * @param version Version of dispensed UUIDs, must be the one of the segment if it exists.
+     * @param node Node of versions 1 and 6 UUIDs, used only if the segment is created.
+     * @param clock_seq Clock sequence of versions 1 and 6 UUIDs, used only if the segment is created.
+     * @param clock Source of time of this process.
+     * @throw std::invalid_argument if the version is not time based, or not the one of the segment.
+     * @throw std::system_error if the segment cannot be created, opened or mapped.
+     */
+    uuid_dispenser(const std::string& name, uuid::version_t version, uint64_t node, uint16_t clock_seq,
+                   uuid_clock& clock = uuid_clock::system());
+
+    uuid_dispenser(const uuid_dispenser&) = delete;
+    uuid_dispenser& operator=(const uuid_dispenser&) = delete;
+
+    /** Unmap the shared segment, which remains for other processes. */
+    ~uuid_dispenser();
+
+    /**
+     * Remove a shared segment. Mapping processes keep using it, new
+     * dispensers of the name create another one.
+     * @param name Name of the segment.
+     * @return True if the segment existed.
+     */
+    static bool unlink(const std::string& name);
+
+    /** Take a UUID. */
+    uuid take();
+
+    /**
+     * Take consecutive UUIDs with a single atomic operation.
+     * @param out Output array of count UUIDs.
+     * @param count Number of UUIDs to take.
+     */
+    void take(uuid* out, size_t count);
+
+    /** Version of dispensed UUIDs. */
+    uuid::version_t version() const noexcept {return _version;}
+
+    /** Node of versions 1 and 6 UUIDs. */
+    uint64_t node() const noexcept;
+
+    /** Clock sequence of versions 1 and 6 UUIDs. */
+    uint16_t clock_seq() const noexcept;
+
+    /** True if the dispenser is shared through a memory segment. */
+    bool shared() const noexcept {return _map_size != 0;}
+
+    /** Segment layout, mapped in shared mode. */
+    struct segment;
+
+private:
+    friend class uuid_dispenser_cursor;
+
+    void init_private(uint64_t node, uint16_t clock_seq);
+    void init_shared(const std::string& name, uint64_t node, uint16_t clock_seq);
+    /** Reserve count consecutive stream positions, returning the first one. */
+    uint64_t reserve(size_t count);
+    /**
+     * Reserve up to count consecutive stream positions, not past the current
+     * millisecond for version 7.
+     * @param count Maximum number of positions.
+     * @param first First reserved position.
+     * @return Number of reserved positions.
+     */
+    size_t reserve_block(size_t count, uint64_t& first);
+    /** Build the UUID of a stream position. */
+    uuid make(uint64_t position);
+    /** Current time, as a stream position. */
+    uint64_t now();
+
+    uuid::version_t _version;
+    uuid_clock* _clock;
+    segment* _segment = nullptr;
+    size_t _map_size = 0;
+};
+
+/**
+ * Block of stream positions of a dispenser, owned by one thread, so that
+ * the clock is read and the shared position updated once per block.
+ *
+ * A block is reserved when the previous one is exhausted: up to the block
+ * size, and for version 7 not past the millisecond of the reservation (at
+ * most 4096 UUIDs), so that version 7 UUIDs keep the time of the clock as
+ * long as fewer than 4096 are taken per millisecond. UUIDs taken from a
+ * cursor are increasing for versions 6 and 7, and distinct from all other
+ * UUIDs of the dispenser.
+ *
+ * UUIDs carry the time of the reservation of their block: a cursor left
+ * idle should be reset() before taking UUIDs again.
+ */
+class uuid_dispenser_cursor
+{
+public:
+    /** Default maximum number of UUIDs per block. */
+    static constexpr size_t default_block = 256;
+
+    /**
+     * Create a cursor, with an empty block.
+     * @param dispenser Dispenser of UUIDs, outliving the cursor.
+     * @param block Maximum number of UUIDs per block, at least 1.
+     */
+    explicit uuid_dispenser_cursor(uuid_dispenser& dispenser, size_t block = default_block) noexcept:
+    _dispenser(dispenser), _block(block != 0 ? block : 1)
+    {
+    }
+
+    uuid_dispenser_cursor(const uuid_dispenser_cursor&) = delete;
+    uuid_dispenser_cursor& operator=(const uuid_dispenser_cursor&) = delete;
+
+    /** Take a UUID, from the owning thread only. */
+    uuid take()
+    {
+        if(_next == _end)
+        {
+            refill();
+        }
+        return _dispenser.make(_next++);
+    }
+
+    /** Drop the rest of the block: next UUIDs carry the time of a new reservation. */
+    void reset() noexcept {_next = _end;}
+
+    /** Number of reserved blocks, that is of clock reads. */
+    uint64_t refills() const noexcept {return _refills;}
+
+private:
+    void refill();
+
+    uuid_dispenser& _dispenser;
+    size_t _block;
+    uint64_t _next = 0;
+    uint64_t _end = 0;
+    uint64_t _refills = 0;
+};
+
+#endif // _UUIDPP_DISPENSER_HPP_
@@ -0,0 +1,133 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-endian.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_ENDIAN_HPP_
+#define _UUIDPP_ENDIAN_HPP_
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Loads and stores of integers at any address in a given byte order.
+ *
+ * Accesses go through memcpy, never through casted pointers, so they are
+ * defined whatever the alignment and do not break strict aliasing: the
+ * compiler still turns them into single (byte swapped) moves.
+ */
+namespace uuid_endian
+{
+
+#if defined(__BYTE_ORDER__)
+    /** True if the host is little endian. */
+    constexpr bool little = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+#else
+    constexpr bool little = true;
+#endif
+
+#if defined(__GNUC__)
+    constexpr uint16_t bswap(uint16_t v) { return __builtin_bswap16(v); }
+    constexpr uint32_t bswap(uint32_t v) { return __builtin_bswap32(v); }
+    constexpr uint64_t bswap(uint64_t v) { return __builtin_bswap64(v); }
+#else
+    constexpr uint16_t bswap(uint16_t v) { return (uint16_t)(v << 8 | v >> 8); }
+    constexpr uint32_t bswap(uint32_t v) { return (uint32_t)bswap((uint16_t)v) << 16 | bswap((uint16_t)(v >> 16)); }
+    constexpr uint64_t bswap(uint64_t v) { return (uint64_t)bswap((uint32_t)v) << 32 | bswap((uint32_t)(v >> 32)); }
+#endif
+
+    /** Convert between host and big endian order. */
+    template<class T>
+    constexpr T be(T v) { return little ? bswap(v) : v; }
+
+    /** Convert between host and little endian order. */
+    template<class T>
+    constexpr T le(T v) { return little ? v : bswap(v); }
+
+    /** Read an integer in host order. */
+    template<class T>
+    inline T load(const void* ptr)
+    {
+        T v;
+        std::memcpy(&v, ptr, sizeof(v));
+        return v;
+    }
+
+    /** Write an integer in host order. */
+    template<class T>
+    inline void store(void* ptr, T v)
+    {
+        std::memcpy(ptr, &v, sizeof(v));
+    }
+
+    inline uint16_t load_be16(const void* ptr) { return be(load<uint16_t>(ptr)); }
+    inline uint32_t load_be32(const void* ptr) { return be(load<uint32_t>(ptr)); }
+    inline uint64_t load_be64(const void* ptr) { return be(load<uint64_t>(ptr)); }
+    inline uint32_t load_le32(const void* ptr) { return le(load<uint32_t>(ptr)); }
+    inline uint64_t load_le64(const void* ptr) { return le(load<uint64_t>(ptr)); }
+
+    inline void store_be16(void* ptr, uint16_t v) { store(ptr, be(v)); }
+    inline void store_be32(void* ptr, uint32_t v) { store(ptr, be(v)); }
+    inline void store_be64(void* ptr, uint64_t v) { store(ptr, be(v)); }
+    inline void store_le32(void* ptr, uint32_t v) { store(ptr, le(v)); }
+    inline void store_le64(void* ptr, uint64_t v) { store(ptr, le(v)); }
+
+    /** Read a 48 bits big endian integer (a MAC address), without reading past it. */
+    inline uint64_t load_be48(const void* ptr)
+    {
+        return (uint64_t)load_be16(ptr) << 32 | load_be32(static_cast<const uint8_t*>(ptr) + 2);
+    }
+
+    /** Bytes of two words in big endian order, by shifts: usable in constant expressions. */
+    constexpr std::array<uint8_t, 16> be_bytes_shifted(uint64_t hi, uint64_t lo)
+    {
+        return std::array<uint8_t, 16>{{
+            (uint8_t)(hi >> 56), (uint8_t)(hi >> 48), (uint8_t)(hi >> 40), (uint8_t)(hi >> 32),
+            (uint8_t)(hi >> 24), (uint8_t)(hi >> 16), (uint8_t)(hi >> 8), (uint8_t)hi,
+            (uint8_t)(lo >> 56), (uint8_t)(lo >> 48), (uint8_t)(lo >> 40), (uint8_t)(lo >> 32),
+            (uint8_t)(lo >> 24), (uint8_t)(lo >> 16), (uint8_t)(lo >> 8), (uint8_t)lo}};
+    }
+
+    /** Bytes of two words in big endian order, by stores. */
+    inline std::array<uint8_t, 16> be_bytes_stored(uint64_t hi, uint64_t lo)
+    {
+        std::array<uint8_t, 16> bytes;
+        store_be64(bytes.data(), hi);
+        store_be64(bytes.data() + 8, lo);
+        return bytes;
+    }
+
+    /**
+     * Bytes of two words in big endian order.
+     * Compilers do not merge the 16 byte stores of the shifted form once
+     * inlined in loops: it is kept for constants and for compilers without
+     * __builtin_constant_p.
+     */
+    constexpr std::array<uint8_t, 16> be_bytes(uint64_t hi, uint64_t lo)
+    {
+#if defined(__GNUC__)
+        return __builtin_constant_p(hi) && __builtin_constant_p(lo) ? be_bytes_shifted(hi, lo) : be_bytes_stored(hi, lo);
+#else
+        return be_bytes_shifted(hi, lo);
+#endif
+    }
+
+} // namespace uuid_endian
+
+#endif // _UUIDPP_ENDIAN_HPP_
@@ -0,0 +1,320 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-file.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-file.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "uuidpp-endian.hpp"
+
+constexpr size_t uuid_index_file::npos;
+constexpr uint32_t uuid_index_file::format_version;
+
+namespace
+{
+
+constexpr char magic[4] = {'U', 'U', 'I', 'X'};
+
+constexpr size_t header_size = 64;
+
+/** Position of header fields. */
+enum header_field : size_t
+{
+    count_field = 8,
+    payload_size_field = 16,
+    hi_field = 24,
+    lo_field = 32,
+    tree_field = 40,
+    payloads_field = 48,
+    file_size_field = 56
+};
+
+using uuid_endian::load_be64;
+using uuid_endian::load_le64;
+using uuid_endian::store_le64;
+
+inline uint64_t align(uint64_t offset)
+{
+    return (offset + 63) & ~(uint64_t)63;
+}
+
+/** Offsets of file sections, all derived from the UUID and tree key counts. */
+struct sections
+{
+    uint64_t hi, lo, tree, payloads, file_size;
+
+    sections(uint64_t count, uint64_t tree_keys, uint64_t payload_size)
+    {
+        hi = header_size;
+        lo = align(hi + count * 8);
+        tree = align(lo + count * 8);
+        uint64_t end = tree + tree_keys * 8;
+        payloads = payload_size != 0 ? align(end) : 0;
+        file_size = payload_size != 0 ? payloads + count * payload_size : end;
+    }
+};
+
+/** Write all bytes to a file descriptor, the write position being at offset. */
+void write_all(int fd, const std::string& path, uint64_t& offset, const void* data, size_t size)
+{
+    const uint8_t* ptr = static_cast<const uint8_t*>(data);
+    while(size > 0)
+    {
+        ssize_t written = ::write(fd, ptr, size);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Cannot write " + path);
+        }
+        ptr += written;
+        size -= written;
+        offset += written;
+    }
+}
+
+/** Write zeros up to an offset. */
+void pad_to(int fd, const std::string& path, uint64_t& offset, uint64_t target)
+{
+    static const uint8_t zeros[64] = {};
+    write_all(fd, path, offset, zeros, target - offset);
+}
+
+/** Write an array of integers in little endian, by chunks. */
+template<class T>
+void write_le64(int fd, const std::string& path, uint64_t& offset, const T* values, size_t count)
+{
+    uint8_t chunk[4096];
+    for(size_t begin=0; begin<count; begin+=sizeof(chunk)/8)
+    {
+        size_t size = std::min(sizeof(chunk)/8, count - begin);
+        for(size_t n=0; n<size; ++n)
+        {
+            store_le64(chunk + n * 8, (uint64_t)values[begin + n]);
+        }
+        write_all(fd, path, offset, chunk, size * 8);
+    }
+}
+
+} // anonymous namespace
+
+void uuid_index_file::write(const std::string& path, const uuid* ids, size_t count,
+                            const void* payloads, size_t payload_size)
+{
+    std::vector<uint64_t> hi(count), lo(count);
+    for(size_t n=0; n<count; ++n)
+    {
+        hi[n] = load_be64(ids[n].data());
+        lo[n] = load_be64(ids[n].data() + 8);
+    }
+    std::vector<size_t> layers;
+    std::vector<int64_t> tree(uuid_index_view::layout(count, layers));
+    uuid_index_view::build_tree(count, hi.data(), layers.data(), layers.size(), tree.data());
+
+    const sections offsets(count, tree.size(), payload_size);
+    uint8_t header[header_size] = {};
+    std::memcpy(header, magic, sizeof(magic));
+    uuid_endian::store_le32(header + 4, format_version);
+    store_le64(header + count_field, count);
+    store_le64(header + payload_size_field, payload_size);
+    store_le64(header + hi_field, offsets.hi);
+    store_le64(header + lo_field, offsets.lo);
+    store_le64(header + tree_field, offsets.tree);
+    store_le64(header + payloads_field, offsets.payloads);
+    store_le64(header + file_size_field, offsets.file_size);
+
+    // Build the file aside and rename it over the target, so that readers
+    // mapping the old file never see it truncated or half written.
+    const std::string temp = path + ".tmp." + std::to_string(::getpid());
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot create " + temp);
+    }
+    try
+    {
+        uint64_t offset = 0;
+        write_all(fd, temp, offset, header, header_size);
+        write_le64(fd, temp, offset, hi.data(), count);
+        pad_to(fd, temp, offset, offsets.lo);
+        write_le64(fd, temp, offset, lo.data(), count);
+        pad_to(fd, temp, offset, offsets.tree);
+        write_le64(fd, temp, offset, tree.data(), tree.size());
+        if(payload_size != 0)
+        {
+            pad_to(fd, temp, offset, offsets.payloads);
+            write_all(fd, temp, offset, payloads, count * payload_size);
+        }
+        if(::fsync(fd) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "Cannot write " + temp);
+        }
+    }
+    catch(...)
+    {
+        ::close(fd);
+        ::unlink(temp.c_str());
+        throw;
+    }
+    if(::close(fd) != 0)
+    {
+        int err = errno;
+        ::unlink(temp.c_str());
+        throw std::system_error(err, std::generic_category(), "Cannot write " + temp);
+    }
+    if(::rename(temp.c_str(), path.c_str()) != 0)
+    {
+        int err = errno;
+        ::unlink(temp.c_str());
+        throw std::system_error(err, std::generic_category(), "Cannot replace " + path);
+    }
+}
+
+uuid_index_file::uuid_index_file(const std::string& path)
+{
+    if(!uuid_endian::little)
+    {
+        throw std::invalid_argument("UUID index files can only be mapped on little endian hosts");
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+    }
+    struct stat st;
+    if(::fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "Cannot stat " + path);
+    }
+    if((uint64_t)st.st_size < header_size)
+    {
+        ::close(fd);
+        throw std::invalid_argument("Not a UUID index file: " + path);
+    }
+    _map_size = st.st_size;
+    _map = ::mmap(nullptr, _map_size, PROT_READ, MAP_SHARED, fd, 0);
+    int err = errno;
+    ::close(fd);
+    if(_map == MAP_FAILED)
+    {
+        _map = nullptr;
+        throw std::system_error(err, std::generic_category(), "Cannot map " + path);
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(_map);
+    const uint64_t count = load_le64(data + count_field);
+    const uint64_t payload_size = load_le64(data + payload_size_field);
+    // Bound counts by the file size before computing offsets, so that they cannot overflow.
+    bool valid = std::memcmp(data, magic, sizeof(magic)) == 0
+              && uuid_endian::load_le32(data + 4) == format_version
+              && count <= _map_size / 16
+              && (count == 0 || payload_size <= _map_size / count);
+    if(valid)
+    {
+        const sections offsets(count, uuid_index_view::layout(count, _layers), payload_size);
+        valid = load_le64(data + hi_field) == offsets.hi
+             && load_le64(data + lo_field) == offsets.lo
+             && load_le64(data + tree_field) == offsets.tree
+             && load_le64(data + payloads_field) == offsets.payloads
+             && load_le64(data + file_size_field) == offsets.file_size
+             && offsets.file_size == _map_size;
+        if(valid)
+        {
+            _count = count;
+            _payload_size = payload_size;
+            _hi = reinterpret_cast<const uint64_t*>(data + offsets.hi);
+            _lo = reinterpret_cast<const uint64_t*>(data + offsets.lo);
+            _tree = reinterpret_cast<const int64_t*>(data + offsets.tree);
+            _payloads = payload_size != 0 ? data + offsets.payloads : nullptr;
+
+            // Leaves and keys are accessed at random, upper tree layers are hot.
+            ::madvise(_map, _map_size, MADV_RANDOM);
+            if(_layers.size() > 1)
+            {
+                uint64_t begin = (offsets.tree + _layers[1] * 8) & ~(uint64_t)(sysconf(_SC_PAGESIZE) - 1);
+                ::madvise(static_cast<uint8_t*>(_map) + begin, offsets.payloads != 0 ? offsets.payloads - begin : _map_size - begin, MADV_WILLNEED);
+            }
+        }
+    }
+    if(!valid)
+    {
+        close();
+        throw std::invalid_argument("Not a valid UUID index file: " + path);
+    }
+}
+
+uuid_index_file::uuid_index_file(uuid_index_file&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+uuid_index_file& uuid_index_file::operator=(uuid_index_file&& other) noexcept
+{
+    if(this != &other)
+    {
+        close();
+        std::swap(_map, other._map);
+        std::swap(_map_size, other._map_size);
+        std::swap(_count, other._count);
+        std::swap(_payload_size, other._payload_size);
+        std::swap(_hi, other._hi);
+        std::swap(_lo, other._lo);
+        std::swap(_tree, other._tree);
+        std::swap(_payloads, other._payloads);
+        _layers.swap(other._layers);
+    }
+    return *this;
+}
+
+uuid_index_file::~uuid_index_file()
+{
+    close();
+}
+
+void uuid_index_file::close() noexcept
+{
+    if(_map != nullptr)
+    {
+        ::munmap(_map, _map_size);
+    }
+    _map = nullptr;
+    _map_size = 0;
+    _count = 0;
+    _payload_size = 0;
+    _hi = _lo = nullptr;
+    _tree = nullptr;
+    _payloads = nullptr;
+    _layers.clear();
+}
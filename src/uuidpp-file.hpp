@@ -0,0 +1,193 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-file.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_FILE_HPP_
+#define _UUIDPP_FILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "uuidpp.hpp"
+#include "uuidpp-iterator.hpp"
+#include "uuidpp-index.hpp"
+
+/**
+ * Immutable on-disk index of UUIDs, searched in place through a read-only
+ * memory mapping, with no deserialization.
+ *
+ * File format, all integers being little endian, sections being 64 bytes aligned:
+ * - 64 bytes header: "UUIX" magic, format version on 4 bytes, UUID count,
+ *   payload size, offsets of high words, low words, tree and payloads
+ *   sections, and file size, on 8 bytes each,
+ * - sorted high 64 bits of UUIDs,
+ * - low 64 bits of UUIDs,
+ * - static B+ tree of high words, as laid out by uuid_index_view,
+ * - optional fixed size payloads, one per UUID, in key order.
+ *
+ * Files can be written on any host but are only opened on little endian ones.
+ */
+class uuid_index_file
+{
+public:
+    /** Position returned when a UUID is not found. */
+    static constexpr size_t npos = uuid_index_view::npos;
+
+    /** Version of the file format. */
+    static constexpr uint32_t format_version = 1;
+
+    /** Random access iterator building UUIDs on the fly from mapped keys. */
+    typedef uuid_split_iterator<uuid_index_file> const_iterator;
+
+    /**
+     * Write an index file.
+     * @param path Path of the file, atomically replaced if it exists: the
+     * content is written and synced to a temporary file which is renamed
+     * over path, so files already mapped keep their content.
+     * @param ids Sorted array of UUIDs.
+     * @param count Number of UUIDs.
+     * @param payloads Array of count payloads of payload_size bytes, in the
+     * order of ids, or null when payload_size is 0.
+     * @param payload_size Size of each payload in bytes.
+     * @throw std::system_error if the file cannot be written.
+     */
+    static void write(const std::string& path, const uuid* ids, size_t count,
+                      const void* payloads = nullptr, size_t payload_size = 0);
+
+    /** Construct a closed file, with no UUID. */
+    uuid_index_file() = default;
+
+    /**
+     * Open and map an index file.
+     * @param path Path of the file.
+     * @throw std::system_error if the file cannot be opened or mapped.
+     * @throw std::invalid_argument if the file is not a valid index file.
+     */
+    explicit uuid_index_file(const std::string& path);
+
+    uuid_index_file(uuid_index_file&& other) noexcept;
+    uuid_index_file& operator=(uuid_index_file&& other) noexcept;
+    uuid_index_file(const uuid_index_file&) = delete;
+    uuid_index_file& operator=(const uuid_index_file&) = delete;
+
+    /** Unmap the file. */
+    ~uuid_index_file();
+
+    /** Search view over the mapped keys, valid while the file is mapped. */
+    uuid_index_view view() const noexcept
+    {
+        return uuid_index_view(_count, _hi, _lo, _tree, _layers.data(), _layers.size());
+    }
+
+    /** Number of UUIDs. */
+    size_t size() const noexcept {return _count;}
+
+    /** Test if there is no UUID. */
+    bool empty() const noexcept {return _count == 0;}
+
+    /** Size of each payload in bytes, 0 if there is none. */
+    size_t payload_size() const noexcept {return _payload_size;}
+
+    /** Retrieve the UUID at a position, less than size(). */
+    uuid operator[](size_t pos) const
+    {
+        return uuid(_hi[pos], _lo[pos]);
+    }
+
+    /**
+     * Retrieve the payload of the UUID at a position.
+     * @param pos Position, less than size().
+     * @return Mapped payload of payload_size() bytes, null if there is no payload.
+     */
+    const uint8_t* payload(size_t pos) const noexcept
+    {
+        return _payloads != nullptr ? _payloads + pos * _payload_size : nullptr;
+    }
+
+    const_iterator begin() const {return const_iterator(this, 0);}
+    const_iterator end() const {return const_iterator(this, size());}
+
+    /**
+     * Look for the first UUID not less than a given one.
+     * @param id UUID to look for.
+     * @return Position of the first UUID not less than id, size() if none.
+     */
+    size_t lower_bound(const uuid& id) const
+    {
+        return view().lower_bound(id);
+    }
+
+    /**
+     * Look for a UUID.
+     * @param id UUID to look for.
+     * @return Position of the first occurrence of id, npos if not present.
+     */
+    size_t find(const uuid& id) const
+    {
+        return view().find(id);
+    }
+
+    /** Test if a UUID is present. */
+    bool contains(const uuid& id) const
+    {
+        return find(id) != npos;
+    }
+
+    /**
+     * Look for the first UUIDs not less than a batch of UUIDs.
+     * @param ids UUIDs to look for.
+     * @param count Number of UUIDs to look for.
+     * @param results Array of count positions, filled as lower_bound() does.
+     */
+    void lower_bound(const uuid* ids, size_t count, size_t* results) const
+    {
+        view().lower_bound(ids, count, results);
+    }
+
+    /**
+     * Look for a batch of UUIDs.
+     * @param ids UUIDs to look for.
+     * @param count Number of UUIDs to look for.
+     * @param results Array of count positions, filled as find() does.
+     */
+    void find(const uuid* ids, size_t count, size_t* results) const
+    {
+        view().find(ids, count, results);
+    }
+
+private:
+    void close() noexcept;
+
+    /** Mapping of the whole file. */
+    void* _map = nullptr;
+    size_t _map_size = 0;
+
+    size_t _count = 0;
+    size_t _payload_size = 0;
+    const uint64_t* _hi = nullptr;
+    const uint64_t* _lo = nullptr;
+    const int64_t* _tree = nullptr;
+    const uint8_t* _payloads = nullptr;
+    /** Offsets of tree layers, recomputed from the UUID count. */
+    std::vector<size_t> _layers;
+};
+
+#endif // _UUIDPP_FILE_HPP_
@@ -0,0 +1,337 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-host.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-host.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "uuidpp-node.hpp"
+
+constexpr unsigned uuid_host_state::slot_bits;
+constexpr unsigned uuid_host_state::max_slots;
+
+namespace
+{
+
+/** Bits of the clock sequence counted by a slot. */
+constexpr unsigned seq_bits = 14 - uuid_host_state::slot_bits;
+constexpr uint32_t seq_mask = (1u << seq_bits) - 1;
+
+/** Steps of timestamps published to slots: 1ms. */
+constexpr uint64_t publish_ahead = 10000;
+
+/** Clock set back by more than 10s: restart from the clock with another sequence. */
+constexpr uint64_t max_ahead = 100000000;
+
+/** Identifier of the current boot, empty if unknown. */
+std::string boot_id()
+{
+    std::string id;
+    std::ifstream("/proc/sys/kernel/random/boot_id") >> id;
+    return id.substr(0, 36);
+}
+
+/** Unlock and close a state file: mappings keep the lock of the file description otherwise. */
+void release(int fd)
+{
+    ::flock(fd, LOCK_UN);
+    ::close(fd);
+}
+
+bool alive(int32_t pid)
+{
+    return pid != 0 && (::kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+/** Number of forks in the history of the process, counted by children. */
+std::atomic<unsigned> fork_count{0};
+
+void count_fork()
+{
+    fork_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+/** Count forks from now on. */
+void watch_forks()
+{
+    static const int registered = ::pthread_atfork(nullptr, nullptr, count_fork);
+    (void)registered;
+}
+
+} // anonymous namespace
+
+struct uuid_host_state::file_state
+{
+    /** "UUIH" */
+    static constexpr uint32_t file_magic = 0x48495555;
+    static constexpr uint32_t file_format_version = 1;
+
+    /** Slot of a process, alone in its cache line. */
+    struct alignas(64) slot_state
+    {
+        /** Process owning the slot, 0 if free. */
+        std::atomic<int32_t> pid;
+        /** Low bits of the clock sequence. */
+        uint32_t seq;
+        /** No timestamp from this one on was used with the slot. */
+        std::atomic<uint64_t> reserved;
+    };
+
+    uint32_t magic;
+    uint32_t format_version;
+    /** Boot of the last attachment, to detect reboots. */
+    char boot_id[36];
+    slot_state slots[max_slots];
+};
+
+uuid_host_state::uuid_host_state(const std::string& path, uuid_clock& clock):
+uuid_host_state(path, uuid_node::host(), clock)
+{
+}
+
+uuid_host_state::uuid_host_state(const std::string& path, uint64_t node, uuid_clock& clock):
+_clock(&clock), _path(path), _node(node & 0xFFFFFFFFFFFFull)
+{
+    watch_forks();
+    _forks.store(fork_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    _claim.store(_forks.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    attach();
+}
+
+void uuid_host_state::attach()
+{
+    const std::string& path = _path;
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if(fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+    }
+    // Attachments are serialized, only the slot owner writes it afterwards.
+    struct stat st;
+    if(::flock(fd, LOCK_EX) != 0 || ::fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        release(fd);
+        throw std::system_error(err, std::generic_category(), "Cannot lock " + path);
+    }
+    const bool created = st.st_size == 0;
+    if(created && ::ftruncate(fd, sizeof(file_state)) != 0)
+    {
+        int err = errno;
+        release(fd);
+        throw std::system_error(err, std::generic_category(), "Cannot size " + path);
+    }
+    if(!created && (size_t)st.st_size != sizeof(file_state))
+    {
+        release(fd);
+        throw std::invalid_argument("Not a UUID state file: " + path);
+    }
+    void* map = ::mmap(nullptr, sizeof(file_state), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED)
+    {
+        int err = errno;
+        release(fd);
+        throw std::system_error(err, std::generic_category(), "Cannot map " + path);
+    }
+    _state = static_cast<file_state*>(map);
+    _map_size = sizeof(file_state);
+
+    file_state& state = *_state;
+    if(created)
+    {
+        // Mapped file pages are zeroed: slots are free, sequences start at random.
+        std::random_device random;
+        state.magic = file_state::file_magic;
+        state.format_version = file_state::file_format_version;
+        for(file_state::slot_state& slot : state.slots)
+        {
+            slot.seq = random() & seq_mask;
+        }
+    }
+    else if(state.magic != file_state::file_magic || state.format_version != file_state::file_format_version)
+    {
+        ::munmap(map, _map_size);
+        _state = nullptr;
+        release(fd);
+        throw std::invalid_argument("Not a UUID state file: " + path);
+    }
+
+    // After a reboot, no slot is in use and the last reserved timestamps may be lost.
+    const std::string boot = boot_id();
+    const bool rebooted = !boot.empty() && boot.compare(0, boot.size(), state.boot_id, sizeof(state.boot_id)) != 0;
+    if(rebooted)
+    {
+        for(file_state::slot_state& slot : state.slots)
+        {
+            slot.pid.store(0, std::memory_order_relaxed);
+            slot.seq = (slot.seq + 1) & seq_mask;
+        }
+        std::memcpy(state.boot_id, boot.data(), std::min(boot.size(), sizeof(state.boot_id)));
+    }
+
+    unsigned index = 0;
+    while(index < max_slots && alive(state.slots[index].pid.load(std::memory_order_relaxed)))
+    {
+        ++index;
+    }
+    if(index == max_slots)
+    {
+        ::munmap(map, _map_size);
+        _state = nullptr;
+        release(fd);
+        throw std::system_error(EBUSY, std::generic_category(), "No free slot in " + path);
+    }
+    file_state::slot_state& slot = state.slots[index];
+    const uint64_t time = uuid_clock::gregorian_ticks(_clock->now());
+    uint64_t reserved = slot.reserved.load(std::memory_order_relaxed);
+    if(boot.empty() || reserved > time + max_ahead)
+    {
+        // Unknown boot: the state may be stale. Clock set back: do not run ahead of it for long.
+        slot.seq = (slot.seq + 1) & seq_mask;
+        reserved = time;
+    }
+    _next.store(reserved > time ? reserved : time, std::memory_order_relaxed);
+    slot.reserved.store(_next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    slot.pid.store(::getpid(), std::memory_order_release);
+    _reserved = &slot.reserved;
+    _clock_seq = (uint16_t)((index << seq_bits) | slot.seq);
+
+    // The new sequence must be on disk before it is used.
+    ::msync(map, _map_size, MS_SYNC);
+    release(fd);
+}
+
+uuid_host_state::~uuid_host_state()
+{
+    if(_state != nullptr)
+    {
+        // A forked process which did not attach again must leave the slot of its parent.
+        if(_forks.load(std::memory_order_relaxed) == fork_count.load(std::memory_order_relaxed))
+        {
+            _state->slots[slot()].pid.store(0, std::memory_order_release);
+        }
+        ::munmap(_state, _map_size);
+    }
+}
+
+void uuid_host_state::reattach()
+{
+    // One thread of the child attaches, others wait for it.
+    const unsigned forks = fork_count.load(std::memory_order_relaxed);
+    while(_forks.load(std::memory_order_acquire) != forks)
+    {
+        unsigned claimed = _claim.load(std::memory_order_relaxed);
+        if(claimed == forks || !_claim.compare_exchange_weak(claimed, forks, std::memory_order_relaxed))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        try
+        {
+            if(_state != nullptr)
+            {
+                ::munmap(_state, _map_size);
+                _state = nullptr;
+            }
+            attach();
+        }
+        catch(...)
+        {
+            _claim.store(claimed, std::memory_order_relaxed);
+            throw;
+        }
+        _forks.store(forks, std::memory_order_release);
+    }
+}
+
+uint64_t uuid_host_state::reserve(size_t count)
+{
+    if(_forks.load(std::memory_order_acquire) != fork_count.load(std::memory_order_relaxed))
+    {
+        reattach();
+    }
+    const uint64_t time = uuid_clock::gregorian_ticks(_clock->now());
+    uint64_t current = _next.load(std::memory_order_relaxed);
+    for(;;)
+    {
+        const uint64_t first = current > time ? current : time;
+        if(_next.compare_exchange_weak(current, first + count, std::memory_order_relaxed))
+        {
+            if(first + count > _reserved->load(std::memory_order_relaxed))
+            {
+                publish(first + count);
+            }
+            return first;
+        }
+    }
+}
+
+void uuid_host_state::publish(uint64_t end)
+{
+    uint64_t current = _reserved->load(std::memory_order_relaxed);
+    while(current < end && !_reserved->compare_exchange_weak(current, end + publish_ahead, std::memory_order_relaxed))
+    {
+    }
+}
+
+uuid uuid_host_state::version1()
+{
+    // Reserve first: a forked process changes its clock sequence.
+    const uint64_t timestamp = reserve(1);
+    return uuid::version1(timestamp, _clock_seq, _node);
+}
+
+uuid uuid_host_state::version6()
+{
+    const uint64_t timestamp = reserve(1);
+    return uuid::version6(timestamp, _clock_seq, _node);
+}
+
+void uuid_host_state::version1(uuid* out, size_t count)
+{
+    uint64_t timestamp = reserve(count);
+    for(size_t n=0; n<count; ++n)
+    {
+        out[n] = uuid::version1(timestamp++, _clock_seq, _node);
+    }
+}
+
+void uuid_host_state::version6(uuid* out, size_t count)
+{
+    uint64_t timestamp = reserve(count);
+    for(size_t n=0; n<count; ++n)
+    {
+        out[n] = uuid::version6(timestamp++, _clock_seq, _node);
+    }
+}
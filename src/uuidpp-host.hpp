@@ -0,0 +1,158 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-host.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_HOST_HPP_
+#define _UUIDPP_HOST_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "uuidpp.hpp"
+#include "uuidpp-clock.hpp"
+
+/**
+ * Time based UUIDs (versions 1 and 6) generated by many processes of a
+ * host, with the host node, without any coordination per UUID.
+ *
+ * Processes share a small state file, mapped in memory. Each process
+ * attaching to it is given a slot, whose index makes the high bits of its
+ * clock sequence: processes then never generate the same UUIDs, even with
+ * the same timestamps, and each one counts its own timestamps with one
+ * atomic operation per call, like uuid_dispenser.
+ *
+ * A slot keeps the highest timestamp reserved by its process, published
+ * ahead by steps of 1ms, and the low bits of its clock sequence. Slots of
+ * exited or crashed processes are taken over by new processes, which start
+ * after that timestamp. As the state is a mapped file, it survives
+ * crashes; after a reboot (which may lose its last writes) or a clock set
+ * back by more than 10s, the clock sequence of slots is incremented, as
+ * RFC 4122 requires when the state may be stale.
+ *
+ * Slots are told free by process ids: processes sharing a file must share
+ * a pid namespace. The file is in host byte order.
+ *
+ * A state can be used across fork(), by pre-forking servers notably: the
+ * first UUID generated by a child process attaches it to the file again,
+ * taking another slot, so that children never reuse the slot of their
+ * parent.
+ */
+class uuid_host_state
+{
+public:
+    /** Number of bits of the clock sequence given by the slot. */
+    static constexpr unsigned slot_bits = 8;
+
+    /** Maximum number of processes attached to a state file. */
+    static constexpr unsigned max_slots = 1u << slot_bits;
+
+    /**
+     * Attach to a state file, creating it if needed, and take a free slot,
+     * with the node of the host (see uuid_node::host()).
+     * @param path Path of the state file.
+     * @param clock Source of time.
+     * @throw std::invalid_argument if the file is not a state file.
+     * @throw std::system_error if the file cannot be created, opened or mapped, or if all slots are taken (EBUSY).
+     */
+    explicit uuid_host_state(const std::string& path, uuid_clock& clock = uuid_clock::system());
+
+    /**
+     * Attach to a state file, creating it if needed, and take a free slot.
+     * @param path Path of the state file.
+     * @param node Node of UUIDs, typically a MAC address of the host (48 least significant bits).
+     * @param clock Source of time.
+     * @throw std::invalid_argument if the file is not a state file.
+     * @throw std::system_error if the file cannot be created, opened or mapped, or if all slots are taken (EBUSY).
+     */
+    uuid_host_state(const std::string& path, uint64_t node, uuid_clock& clock = uuid_clock::system());
+
+    uuid_host_state(const uuid_host_state&) = delete;
+    uuid_host_state& operator=(const uuid_host_state&) = delete;
+
+    /** Free the slot. */
+    ~uuid_host_state();
+
+    /**
+     * Generate a version 1 UUID.
+     * @throw std::system_error if a forked process cannot attach to the state file again.
+     */
+    uuid version1();
+
+    /**
+     * Generate a version 6 UUID.
+     * @throw std::system_error if a forked process cannot attach to the state file again.
+     */
+    uuid version6();
+
+    /**
+     * Generate version 1 UUIDs of consecutive timestamps.
+     * @param out Output array of count UUIDs.
+     * @param count Number of UUIDs to generate.
+     * @throw std::system_error if a forked process cannot attach to the state file again.
+     */
+    void version1(uuid* out, size_t count);
+
+    /**
+     * Generate version 6 UUIDs of consecutive timestamps, increasing.
+     * @param out Output array of count UUIDs.
+     * @param count Number of UUIDs to generate.
+     * @throw std::system_error if a forked process cannot attach to the state file again.
+     */
+    void version6(uuid* out, size_t count);
+
+    /** Node of generated UUIDs. */
+    uint64_t node() const noexcept {return _node;}
+
+    /** Clock sequence of generated UUIDs, slot in the high bits; changes when a forked process attaches again. */
+    uint16_t clock_seq() const noexcept {return _clock_seq;}
+
+    /** Slot of the process. */
+    unsigned slot() const noexcept {return _clock_seq >> (14 - slot_bits);}
+
+    /** State file layout. */
+    struct file_state;
+
+private:
+    /** Open and map the state file, and take a free slot. */
+    void attach();
+    /** Take a slot of its own in a forked process. */
+    void reattach();
+    /** Reserve count consecutive timestamps, returning the first one. */
+    uint64_t reserve(size_t count);
+    /** Publish a reserved timestamp to the slot. */
+    void publish(uint64_t end);
+
+    uuid_clock* _clock;
+    std::string _path;
+    file_state* _state = nullptr;
+    size_t _map_size = 0;
+    std::atomic<uint64_t>* _reserved = nullptr;
+    uint64_t _node;
+    uint16_t _clock_seq;
+    /** Next timestamp of the process. */
+    std::atomic<uint64_t> _next{0};
+    /** Number of forks of the process history when the slot was taken. */
+    std::atomic<unsigned> _forks{0};
+    /** Number of forks for which a thread is taking a slot. */
+    std::atomic<unsigned> _claim{0};
+};
+
+#endif // _UUIDPP_HOST_HPP_
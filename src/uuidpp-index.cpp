@@ -0,0 +1,385 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-index.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-index.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "uuidpp-cpu.hpp"
+
+#if defined(UUIDPP_CPU_X86)
+#include <immintrin.h>
+#endif
+
+#include "uuidpp-endian.hpp"
+
+constexpr size_t uuid_index_view::npos;
+constexpr size_t uuid_index_view::node_size;
+constexpr size_t uuid_index::npos;
+constexpr size_t uuid_index::node_size;
+
+namespace
+{
+
+/** Number of children of an internal tree node. */
+constexpr size_t fanout = uuid_index_view::node_size + 1;
+
+/** Value of padding keys, never less than a searched key. */
+constexpr int64_t pad_key = std::numeric_limits<int64_t>::max();
+
+using uuid_endian::load_be64;
+
+/** Flip the sign bit so that unsigned order becomes signed order. */
+inline int64_t bias(uint64_t key)
+{
+    return static_cast<int64_t>(key ^ 0x8000000000000000ull);
+}
+
+/*
+ * Node ranking: count keys of a cache line aligned node of 8 keys strictly
+ * less than a biased searched key, one policy per instruction set.
+ */
+
+struct rank_scalar
+{
+    static size_t rank(const int64_t* node, int64_t key)
+    {
+        size_t rank = 0;
+        for(size_t n=0; n<uuid_index_view::node_size; ++n)
+        {
+            rank += node[n] < key;
+        }
+        return rank;
+    }
+};
+
+#if defined(UUIDPP_CPU_X86)
+
+struct rank_sse4_2
+{
+    __attribute__((target("sse4.2")))
+    static size_t rank(const int64_t* node, int64_t key)
+    {
+        __m128i k = _mm_set1_epi64x(key);
+        const __m128i* vec = reinterpret_cast<const __m128i*>(node);
+        unsigned mask = 0;
+        for(int n=0; n<4; ++n)
+        {
+            __m128i lt = _mm_cmpgt_epi64(k, _mm_load_si128(vec + n));
+            mask |= _mm_movemask_pd(_mm_castsi128_pd(lt)) << (2 * n);
+        }
+        return __builtin_popcount(mask);
+    }
+};
+
+struct rank_avx2
+{
+    __attribute__((target("avx2")))
+    static size_t rank(const int64_t* node, int64_t key)
+    {
+        __m256i k = _mm256_set1_epi64x(key);
+        __m256i lt0 = _mm256_cmpgt_epi64(k, _mm256_load_si256(reinterpret_cast<const __m256i*>(node)));
+        __m256i lt1 = _mm256_cmpgt_epi64(k, _mm256_load_si256(reinterpret_cast<const __m256i*>(node + 4)));
+        unsigned mask = _mm256_movemask_pd(_mm256_castsi256_pd(lt0))
+                     | (_mm256_movemask_pd(_mm256_castsi256_pd(lt1)) << 4);
+        return __builtin_popcount(mask);
+    }
+};
+
+#endif
+
+/** Tree of an index, as seen by search kernels. */
+struct tree_view
+{
+    const int64_t* tree;
+    const size_t* layers;
+    size_t layer_count;
+    const uint64_t* hi;
+    const uint64_t* lo;
+};
+
+/** Descend the tree, return the position of the first key not less than a biased key. */
+template<class Rank>
+size_t descend(const tree_view& t, int64_t key)
+{
+    size_t node = 0;
+    for(size_t layer=t.layer_count-1; layer>0; --layer)
+    {
+        node = node * fanout + Rank::rank(&t.tree[t.layers[layer] + node * uuid_index_view::node_size], key);
+    }
+    // Low words of the leaf are only needed on high word ties, fetch them meanwhile.
+    __builtin_prefetch(&t.lo[node * uuid_index_view::node_size]);
+    return node * uuid_index_view::node_size + Rank::rank(&t.tree[node * uuid_index_view::node_size], key);
+}
+
+/**
+ * Descend the tree with a group of biased keys, level by level, each search
+ * prefetching its next node while the others are ranked.
+ */
+template<class Rank>
+void descend_group(const tree_view& t, const int64_t* key, size_t size, size_t* pos)
+{
+    constexpr size_t node_size = uuid_index_view::node_size;
+    std::fill(pos, pos + size, 0);
+    for(size_t layer=t.layer_count-1; layer>0; --layer)
+    {
+        const int64_t* nodes = &t.tree[t.layers[layer]];
+        const int64_t* children = &t.tree[t.layers[layer-1]];
+        for(size_t g=0; g<size; ++g)
+        {
+            pos[g] = pos[g] * fanout + Rank::rank(nodes + pos[g] * node_size, key[g]);
+            __builtin_prefetch(children + pos[g] * node_size);
+            if(layer == 1)
+            {
+                __builtin_prefetch(&t.hi[pos[g] * node_size]);
+                __builtin_prefetch(&t.lo[pos[g] * node_size]);
+            }
+        }
+    }
+    for(size_t g=0; g<size; ++g)
+    {
+        pos[g] = pos[g] * node_size + Rank::rank(&t.tree[pos[g] * node_size], key[g]);
+    }
+}
+
+/** Search kernels of an instruction set. */
+struct search_kernels
+{
+    size_t (*descend)(const tree_view& t, int64_t key);
+    void (*descend_group)(const tree_view& t, const int64_t* key, size_t size, size_t* pos);
+};
+
+#if defined(UUIDPP_CPU_X86)
+
+UUIDPP_TARGET("sse4.2")
+size_t descend_sse4_2(const tree_view& t, int64_t key)
+{
+    return descend<rank_sse4_2>(t, key);
+}
+
+UUIDPP_TARGET("sse4.2")
+void descend_group_sse4_2(const tree_view& t, const int64_t* key, size_t size, size_t* pos)
+{
+    descend_group<rank_sse4_2>(t, key, size, pos);
+}
+
+UUIDPP_TARGET("avx2")
+size_t descend_avx2(const tree_view& t, int64_t key)
+{
+    return descend<rank_avx2>(t, key);
+}
+
+UUIDPP_TARGET("avx2")
+void descend_group_avx2(const tree_view& t, const int64_t* key, size_t size, size_t* pos)
+{
+    descend_group<rank_avx2>(t, key, size, pos);
+}
+
+#endif
+
+/** Kernels of the active instruction set. */
+const search_kernels& kernels()
+{
+    static const search_kernels scalar = {descend<rank_scalar>, descend_group<rank_scalar>};
+#if defined(UUIDPP_CPU_X86)
+    static const search_kernels sse4_2 = {descend_sse4_2, descend_group_sse4_2};
+    static const search_kernels avx2 = {descend_avx2, descend_group_avx2};
+    if(uuid_cpu::has(uuid_cpu::avx2))
+    {
+        return avx2;
+    }
+    if(uuid_cpu::has(uuid_cpu::sse4_2))
+    {
+        return sse4_2;
+    }
+#endif
+    return scalar;
+}
+
+} // anonymous namespace
+
+size_t uuid_index_view::layout(size_t count, std::vector<size_t>& layers)
+{
+    // Layer sizes in nodes, from the leaves up to a single root.
+    std::vector<size_t> nodes(1, (count + node_size - 1) / node_size);
+    while(nodes.back() > 1)
+    {
+        nodes.push_back((nodes.back() + fanout - 1) / fanout);
+    }
+    layers.clear();
+    size_t total = 0;
+    for(size_t layer_nodes : nodes)
+    {
+        layers.push_back(total);
+        total += layer_nodes * node_size;
+    }
+    return total;
+}
+
+void uuid_index_view::build_tree(size_t count, const uint64_t* hi,
+                                 const size_t* layers, size_t layer_count, int64_t* tree)
+{
+    for(size_t n=0; n<count; ++n)
+    {
+        tree[n] = bias(hi[n]);
+    }
+    size_t leaves = (count + node_size - 1) / node_size * node_size;
+    std::fill(tree + count, tree + leaves, pad_key);
+
+    // Key j of an internal node is the smallest key of its child j+1.
+    size_t leaves_per_child = 1;
+    for(size_t layer=1; layer<layer_count; ++layer)
+    {
+        int64_t* keys = tree + layers[layer];
+        size_t nodes = ((layer + 1 < layer_count ? layers[layer + 1] : layers[layer] + node_size) - layers[layer]) / node_size;
+        for(size_t node=0; node<nodes; ++node)
+        {
+            for(size_t j=0; j<node_size; ++j)
+            {
+                size_t first = (node * fanout + j + 1) * leaves_per_child * node_size;
+                keys[node * node_size + j] = first < count ? bias(hi[first]) : pad_key;
+            }
+        }
+        leaves_per_child *= fanout;
+    }
+}
+
+uuid_index::uuid_index(const uuid* ids, size_t count):
+_count(count),
+_hi(count),
+_lo(count)
+{
+    for(size_t n=0; n<count; ++n)
+    {
+        _hi[n] = load_be64(ids[n].data());
+        _lo[n] = load_be64(ids[n].data() + 8);
+    }
+    _tree.resize(uuid_index_view::layout(count, _layers));
+    uuid_index_view::build_tree(count, _hi.data(), _layers.data(), _layers.size(), _tree.data());
+}
+
+size_t uuid_index_view::lower_bound(uint64_t hi, uint64_t lo) const
+{
+    if(_count == 0)
+    {
+        return 0;
+    }
+    const tree_view t{_tree, _layers, _layer_count, _hi, _lo};
+    return resolve_ties(kernels().descend(t, bias(hi)), hi, lo);
+}
+
+size_t uuid_index_view::resolve_ties(size_t pos, uint64_t hi, uint64_t lo) const
+{
+    if(pos == _count || _hi[pos] != hi || _lo[pos] >= lo)
+    {
+        return pos;
+    }
+
+    // Several keys share the high word, gallop then bisect on full keys.
+    auto less = [&](size_t n)
+    {
+        return _hi[n] < hi || (_hi[n] == hi && _lo[n] < lo);
+    };
+    size_t first = pos + 1, last = first, step = 1;
+    while(last < _count && less(last))
+    {
+        first = last + 1;
+        last += step;
+        step *= 2;
+    }
+    last = std::min(last, _count);
+    while(first < last)
+    {
+        size_t mid = first + (last - first) / 2;
+        if(less(mid))
+        {
+            first = mid + 1;
+        }
+        else
+        {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+size_t uuid_index_view::lower_bound(const uuid& id) const
+{
+    return lower_bound(load_be64(id.data()), load_be64(id.data() + 8));
+}
+
+size_t uuid_index_view::find(const uuid& id) const
+{
+    uint64_t hi = load_be64(id.data()), lo = load_be64(id.data() + 8);
+    size_t pos = lower_bound(hi, lo);
+    return pos < _count && _hi[pos] == hi && _lo[pos] == lo ? pos : npos;
+}
+
+template<bool Find>
+void uuid_index_view::batch_search(const uuid* ids, size_t count, size_t* results) const
+{
+    if(_count == 0)
+    {
+        std::fill(results, results + count, Find ? npos : 0);
+        return;
+    }
+
+    // Group prefetching: a group of searches descends the tree level by level.
+    constexpr size_t group = 16;
+    uint64_t hi[group], lo[group];
+    int64_t key[group];
+    size_t pos[group];
+    const tree_view t{_tree, _layers, _layer_count, _hi, _lo};
+    const search_kernels& kernel = kernels();
+
+    for(size_t begin=0; begin<count; begin+=group)
+    {
+        const size_t size = std::min(group, count - begin);
+        for(size_t g=0; g<size; ++g)
+        {
+            hi[g] = load_be64(ids[begin + g].data());
+            lo[g] = load_be64(ids[begin + g].data() + 8);
+            key[g] = bias(hi[g]);
+        }
+
+        kernel.descend_group(t, key, size, pos);
+
+        for(size_t g=0; g<size; ++g)
+        {
+            size_t found = resolve_ties(pos[g], hi[g], lo[g]);
+            if(Find)
+            {
+                found = found < _count && _hi[found] == hi[g] && _lo[found] == lo[g] ? found : npos;
+            }
+            results[begin + g] = found;
+        }
+    }
+}
+
+void uuid_index_view::lower_bound(const uuid* ids, size_t count, size_t* results) const
+{
+    batch_search<false>(ids, count, results);
+}
+
+void uuid_index_view::find(const uuid* ids, size_t count, size_t* results) const
+{
+    batch_search<true>(ids, count, results);
+}
@@ -0,0 +1,261 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-index.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_INDEX_HPP_
+#define _UUIDPP_INDEX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "uuidpp.hpp"
+#include "uuidpp-aligned.hpp"
+
+/**
+ * Search over a static B+ tree of UUIDs held in memory owned by someone else,
+ * an uuid_index or a mapped uuid_index_file.
+ *
+ * High 64 bits of keys are laid out in a static B+ tree whose nodes are
+ * exactly one cache line (8 keys), searched with SIMD comparisons.
+ * Low 64 bits are only read to break ties between equal high words.
+ * Positions returned are positions in the sorted array of keys.
+ */
+class uuid_index_view
+{
+public:
+    /** Position returned when a UUID is not found. */
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    /** Number of keys per tree node. */
+    static constexpr size_t node_size = 8;
+
+    /** Construct an empty view. */
+    uuid_index_view() = default;
+
+    /**
+     * Construct a view over existing arrays.
+     * @param count Number of keys.
+     * @param hi Sorted high words of keys, as native integers.
+     * @param lo Low words of keys, as native integers.
+     * @param tree Cache line aligned tree, as built by build_tree().
+     * @param layers Offsets of tree layers, as computed by layout().
+     * @param layer_count Number of tree layers.
+     */
+    uuid_index_view(size_t count, const uint64_t* hi, const uint64_t* lo,
+                    const int64_t* tree, const size_t* layers, size_t layer_count):
+    _count(count), _hi(hi), _lo(lo), _tree(tree), _layers(layers), _layer_count(layer_count)
+    {}
+
+    /**
+     * Compute the tree layout for a number of keys.
+     * @param count Number of keys.
+     * @param layers Filled with offsets of each tree layer, from the leaves up.
+     * @return Number of tree keys, padding included.
+     */
+    static size_t layout(size_t count, std::vector<size_t>& layers);
+
+    /**
+     * Fill a tree.
+     * @param count Number of keys.
+     * @param hi Sorted high words of keys.
+     * @param layers Offsets of tree layers, as computed by layout().
+     * @param layer_count Number of tree layers.
+     * @param tree Output array of as many keys as returned by layout().
+     */
+    static void build_tree(size_t count, const uint64_t* hi,
+                           const size_t* layers, size_t layer_count, int64_t* tree);
+
+    /** Number of keys. */
+    size_t size() const noexcept {return _count;}
+
+    /** Test if there is no key. */
+    bool empty() const noexcept {return _count == 0;}
+
+    /** Retrieve the key at a position, less than size(). */
+    uuid operator[](size_t pos) const
+    {
+        return uuid(_hi[pos], _lo[pos]);
+    }
+
+    /** Sorted high words of keys. */
+    const uint64_t* hi() const noexcept {return _hi;}
+
+    /** Low words of keys. */
+    const uint64_t* lo() const noexcept {return _lo;}
+
+    /**
+     * Look for the first key not less than a given UUID.
+     * @param id UUID to look for.
+     * @return Position of the first key not less than id, size() if none.
+     */
+    size_t lower_bound(const uuid& id) const;
+
+    /**
+     * Look for a UUID.
+     * @param id UUID to look for.
+     * @return Position of the first occurrence of id, npos if not present.
+     */
+    size_t find(const uuid& id) const;
+
+    /**
+     * Look for the first keys not less than a batch of UUIDs.
+     * @param ids UUIDs to look for.
+     * @param count Number of UUIDs to look for.
+     * @param results Array of count positions, filled as lower_bound() does.
+     */
+    void lower_bound(const uuid* ids, size_t count, size_t* results) const;
+
+    /**
+     * Look for a batch of UUIDs.
+     * @param ids UUIDs to look for.
+     * @param count Number of UUIDs to look for.
+     * @param results Array of count positions, filled as find() does.
+     */
+    void find(const uuid* ids, size_t count, size_t* results) const;
+
+private:
+    size_t lower_bound(uint64_t hi, uint64_t lo) const;
+    size_t resolve_ties(size_t pos, uint64_t hi, uint64_t lo) const;
+    template<bool Find>
+    void batch_search(const uuid* ids, size_t count, size_t* results) const;
+
+    size_t _count = 0;
+    const uint64_t* _hi = nullptr;
+    const uint64_t* _lo = nullptr;
+    const int64_t* _tree = nullptr;
+    const size_t* _layers = nullptr;
+    size_t _layer_count = 0;
+};
+
+/**
+ * Static search index over a sorted array of UUIDs.
+ *
+ * Keys are copied and laid out as described in uuid_index_view.
+ * Positions returned by the index are positions in the sorted source array.
+ */
+class uuid_index
+{
+public:
+    /** Position returned when a UUID is not found. */
+    static constexpr size_t npos = uuid_index_view::npos;
+
+    /** Number of keys per tree node. */
+    static constexpr size_t node_size = uuid_index_view::node_size;
+
+    /** Construct an empty index. */
+    uuid_index() = default;
+
+    /**
+     * Build an index from a sorted array of UUIDs.
+     * @param ids Sorted array of UUIDs, it is copied and can be released afterward.
+     * @param count Number of UUIDs.
+     */
+    uuid_index(const uuid* ids, size_t count);
+
+    /** Search view over the index, valid while the index is neither modified nor destroyed. */
+    uuid_index_view view() const noexcept
+    {
+        return uuid_index_view(_count, _hi.data(), _lo.data(), _tree.data(), _layers.data(), _layers.size());
+    }
+
+    /** Number of indexed UUIDs. */
+    size_t size() const noexcept {return _count;}
+
+    /** Test if the index is empty. */
+    bool empty() const noexcept {return _count == 0;}
+
+    /**
+     * Retrieve an indexed UUID.
+     * @param pos Position of the UUID, less than size().
+     * @return The UUID at this position.
+     */
+    uuid operator[](size_t pos) const
+    {
+        return uuid(_hi[pos], _lo[pos]);
+    }
+
+    /**
+     * Look for the first indexed UUID not less than a given one.
+     * @param id UUID to look for.
+     * @return Position of the first UUID not less than id, size() if none.
+     */
+    size_t lower_bound(const uuid& id) const
+    {
+        return view().lower_bound(id);
+    }
+
+    /**
+     * Look for a UUID.
+     * @param id UUID to look for.
+     * @return Position of the first occurrence of id, npos if not present.
+     */
+    size_t find(const uuid& id) const
+    {
+        return view().find(id);
+    }
+
+    /**
+     * Test if a UUID is indexed.
+     * @param id UUID to look for.
+     * @return True if id is present.
+     */
+    bool contains(const uuid& id) const
+    {
+        return find(id) != npos;
+    }
+
+    /**
+     * Look for the first indexed UUIDs not less than a batch of UUIDs.
+     * Lookups are interleaved and their memory accesses prefetched, to overlap
+     * cache misses of independent searches.
+     * @param ids UUIDs to look for.
+     * @param count Number of UUIDs to look for.
+     * @param results Array of count positions, filled as lower_bound() does.
+     */
+    void lower_bound(const uuid* ids, size_t count, size_t* results) const
+    {
+        view().lower_bound(ids, count, results);
+    }
+
+    /**
+     * Look for a batch of UUIDs.
+     * Lookups are interleaved and their memory accesses prefetched, to overlap
+     * cache misses of independent searches.
+     * @param ids UUIDs to look for.
+     * @param count Number of UUIDs to look for.
+     * @param results Array of count positions, filled as find() does.
+     */
+    void find(const uuid* ids, size_t count, size_t* results) const
+    {
+        view().find(ids, count, results);
+    }
+
+private:
+    /** Number of indexed keys. */
+    size_t _count = 0;
+    /** Sorted high and low words of keys. */
+    uuid_aligned_vector<uint64_t> _hi, _lo;
+    /** Tree nodes layer after layer, high words biased to compare as signed integers. */
+    uuid_aligned_vector<int64_t> _tree;
+    /** Offsets of each layer in _tree, from the leaves up. */
+    std::vector<size_t> _layers;
+};
+
+#endif // _UUIDPP_INDEX_HPP_
@@ -0,0 +1,102 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-inline.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+/*
+ * Definitions of the small functions of uuid declared UUIDPP_INLINE.
+ * Compiled in the library, or included by uuidpp.hpp in every translation
+ * unit, the library's ones included, when UUIDPP_HEADER_INLINE is defined.
+ * Not to be included directly.
+ */
+
+#ifndef _UUIDPP_INLINE_HPP_
+#define _UUIDPP_INLINE_HPP_
+
+#include "uuidpp.hpp"
+
+#include "uuidpp-endian.hpp"
+
+UUIDPP_INLINE int uuid::compare(uuid const & other) const
+{
+    // Compare as two big-endian 64 bits words, same as lexicographic byte order.
+    uint64_t l = uuid_endian::load_be64(data()), r = uuid_endian::load_be64(other.data());
+    if(l == r)
+    {
+        l = uuid_endian::load_be64(data() + 8);
+        r = uuid_endian::load_be64(other.data() + 8);
+    }
+    return (l > r) - (l < r);
+}
+
+UUIDPP_INLINE uuid uuid::version1(uint64_t timestamp, uint16_t clock_seq, uint64_t mac_address)
+{
+    return uuid(timestamp, version_t::version_time_based, clock_seq, mac_address);
+}
+
+UUIDPP_INLINE uuid uuid::version6(uint64_t timestamp, uint16_t clock_seq, uint64_t node)
+{
+    uint64_t msb = ((timestamp << 4) & 0xFFFFFFFFFFFF0000ull) // time_high and time_mid
+                 | ((uint64_t)version_t::version_reordered_time_based << 12)
+                 | (timestamp & 0x0FFF); // time_low
+    uint64_t lsb = ((uint64_t)((clock_seq & 0x3FFF) | 0x8000) << 48) | (node & 0xFFFFFFFFFFFFull);
+    return uuid(msb, lsb);
+}
+
+UUIDPP_INLINE uuid uuid::version7(uint64_t unix_ts_ms, uint16_t rand_a, uint64_t rand_b)
+{
+    uint64_t msb = (unix_ts_ms << 16)
+                 | ((uint64_t)version_t::version_unix_time_based << 12)
+                 | (rand_a & 0x0FFF);
+    uint64_t lsb = (rand_b & 0x3FFFFFFFFFFFFFFFull) | 0x8000000000000000ull;
+    return uuid(msb, lsb);
+}
+
+UUIDPP_INLINE uuid uuid::version8(uint64_t custom_a, uint16_t custom_b, uint64_t custom_c)
+{
+    uint64_t msb = ((custom_a & 0xFFFFFFFFFFFFull) << 16)
+                 | ((uint64_t)version_t::version_custom << 12)
+                 | (custom_b & 0x0FFF);
+    uint64_t lsb = (custom_c & 0x3FFFFFFFFFFFFFFFull) | 0x8000000000000000ull;
+    return uuid(msb, lsb);
+}
+
+UUIDPP_INLINE std::string uuid::to_hex() const
+{
+    std::string res(16*2, 0);
+    to_hex_chars(&res[0]);
+    return res;
+}
+
+UUIDPP_INLINE std::string uuid::to_string() const
+{
+    std::string res(16*2+4, 0);
+    to_chars(&res[0]);
+    return res;
+}
+
+UUIDPP_INLINE std::string uuid::to_msguid() const
+{
+    std::string res(16*2+4+2, 0);
+    res[0]  = '{';
+    to_chars(&res[1]);
+    res[37] = '}';
+    return res;
+}
+
+#endif // _UUIDPP_INLINE_HPP_
@@ -0,0 +1,72 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-iterator.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_ITERATOR_HPP_
+#define _UUIDPP_ITERATOR_HPP_
+
+#include <cstddef>
+#include <iterator>
+
+#include "uuidpp.hpp"
+
+/**
+ * Random access iterator over a container storing UUIDs as separate high
+ * and low halves, building UUIDs on the fly with the container operator[].
+ * @tparam Container Type of container, with a uuid operator[](size_t).
+ */
+template<class Container>
+class uuid_split_iterator
+{
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef uuid value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const uuid* pointer;
+    typedef uuid reference;
+
+    uuid_split_iterator() = default;
+    uuid_split_iterator(const Container* container, size_t pos): _container(container), _pos(pos) {}
+
+    uuid operator*() const {return (*_container)[_pos];}
+    uuid operator[](difference_type n) const {return (*_container)[_pos + n];}
+
+    uuid_split_iterator& operator++() {++_pos; return *this;}
+    uuid_split_iterator operator++(int) {uuid_split_iterator it(*this); ++_pos; return it;}
+    uuid_split_iterator& operator--() {--_pos; return *this;}
+    uuid_split_iterator operator--(int) {uuid_split_iterator it(*this); --_pos; return it;}
+    uuid_split_iterator& operator+=(difference_type n) {_pos += n; return *this;}
+    uuid_split_iterator& operator-=(difference_type n) {_pos -= n; return *this;}
+    uuid_split_iterator operator+(difference_type n) const {return uuid_split_iterator(_container, _pos + n);}
+    uuid_split_iterator operator-(difference_type n) const {return uuid_split_iterator(_container, _pos - n);}
+    difference_type operator-(const uuid_split_iterator& other) const {return (difference_type)(_pos - other._pos);}
+
+    bool operator==(const uuid_split_iterator& other) const {return _pos == other._pos;}
+    bool operator!=(const uuid_split_iterator& other) const {return _pos != other._pos;}
+    bool operator<(const uuid_split_iterator& other) const {return _pos < other._pos;}
+    bool operator>(const uuid_split_iterator& other) const {return _pos > other._pos;}
+    bool operator<=(const uuid_split_iterator& other) const {return _pos <= other._pos;}
+    bool operator>=(const uuid_split_iterator& other) const {return _pos >= other._pos;}
+
+private:
+    const Container* _container = nullptr;
+    size_t _pos = 0;
+};
+
+#endif // _UUIDPP_ITERATOR_HPP_
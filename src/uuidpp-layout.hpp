@@ -0,0 +1,287 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-layout.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_LAYOUT_HPP_
+#define _UUIDPP_LAYOUT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "uuidpp.hpp"
+#include "uuidpp-endian.hpp"
+
+/** Smallest unsigned integer of at least Width bits. */
+template<unsigned Width>
+using uuid_field_type = typename std::conditional<Width <= 8, uint8_t,
+                        typename std::conditional<Width <= 16, uint16_t,
+                        typename std::conditional<Width <= 32, uint32_t, uint64_t>::type>::type>::type;
+
+/**
+ * Field of a version 8 UUID layout, to derive from to name it:
+ * @code
+ * struct shard : uuid_field<16> {};
+ * @endcode
+ * @tparam Width Number of bits, from 1 to 64.
+ * @tparam T Type of values, by default the smallest unsigned integer holding them.
+ */
+template<unsigned Width, class T = uuid_field_type<Width>>
+struct uuid_field
+{
+    static_assert(Width >= 1 && Width <= 64, "UUID fields have 1 to 64 bits");
+
+    static constexpr unsigned width = Width;
+    typedef T value_type;
+};
+
+namespace uuid_layout_detail
+{
+
+    constexpr unsigned max(unsigned a, unsigned b) { return a > b ? a : b; }
+    constexpr unsigned min(unsigned a, unsigned b) { return a < b ? a : b; }
+
+    /** Position in the UUID, from its most significant bit, of a custom bit: custom bits skip version and variant. */
+    constexpr unsigned position(unsigned bit) { return bit < 48 ? bit : bit < 60 ? bit + 4 : bit + 6; }
+
+    /**
+     * Part of a field of custom bits [Offset, Offset + Width) in a run of
+     * contiguous custom bits [Begin, End) of one 64 bits half.
+     */
+    template<unsigned Offset, unsigned Width, unsigned Begin, unsigned End>
+    struct part
+    {
+        static constexpr unsigned first = max(Offset, Begin);
+        static constexpr unsigned last = min(Offset + Width, End);
+        static constexpr bool used = first < last;
+        static constexpr unsigned size = used ? last - first : 0;
+        /** Shift of the part in the field value. */
+        static constexpr unsigned value_shift = used ? Offset + Width - last : 0;
+        /** Shift of the part in its half. */
+        static constexpr unsigned half_shift = used ? 64 - position(first) % 64 - size : 0;
+        static constexpr bool low = position(Begin) >= 64;
+        static constexpr uint64_t mask = ((uint64_t)1 << size) - 1;
+
+        static void deposit(uint64_t& msb, uint64_t& lsb, uint64_t value) noexcept
+        {
+            if(used)
+            {
+                (low ? lsb : msb) |= ((value >> value_shift) & mask) << half_shift;
+            }
+        }
+
+        static uint64_t extract(uint64_t msb, uint64_t lsb) noexcept
+        {
+            return used ? (((low ? lsb : msb) >> half_shift) & mask) << value_shift : 0;
+        }
+    };
+
+    /** Custom bits [Offset, Offset + Width), split in the three runs of custom bits: before version, between version and variant, after variant. */
+    template<unsigned Offset, unsigned Width>
+    struct bits
+    {
+        typedef part<Offset, Width, 0, 48> a;
+        typedef part<Offset, Width, 48, 60> b;
+        typedef part<Offset, Width, 60, 122> c;
+
+        static void deposit(uint64_t& msb, uint64_t& lsb, uint64_t value) noexcept
+        {
+            a::deposit(msb, lsb, value);
+            b::deposit(msb, lsb, value);
+            c::deposit(msb, lsb, value);
+        }
+
+        static uint64_t extract(uint64_t msb, uint64_t lsb) noexcept
+        {
+            return a::extract(msb, lsb) | b::extract(msb, lsb) | c::extract(msb, lsb);
+        }
+    };
+
+    /** Total width of fields. */
+    template<class... Fields>
+    struct width;
+
+    template<>
+    struct width<>
+    {
+        static constexpr unsigned value = 0;
+    };
+
+    template<class Field, class... Fields>
+    struct width<Field, Fields...>
+    {
+        static constexpr unsigned value = Field::width + width<Fields...>::value;
+    };
+
+    /** Offset of a field in custom bits, fields being laid out from the most significant bits. */
+    template<class Field, class... Fields>
+    struct offset;
+
+    template<class Field, class... Fields>
+    struct offset<Field, Field, Fields...>
+    {
+        static constexpr unsigned value = 0;
+    };
+
+    template<class Field, class Other, class... Fields>
+    struct offset<Field, Other, Fields...>
+    {
+        static constexpr unsigned value = Other::width + offset<Field, Fields...>::value;
+    };
+
+} // namespace uuid_layout_detail
+
+/**
+ * Layout of version 8 UUIDs: fields packed in their 122 custom bits, from
+ * the most significant ones (so that UUIDs sort by the first fields), around
+ * the version and variant bits. Unused bits are zero.
+ *
+ * Positions are known at compile time: packing and unpacking compile to
+ * shifts and masks.
+ * @code
+ * struct timestamp : uuid_field<48> {};
+ * struct shard : uuid_field<16> {};
+ * struct entity : uuid_field<8> {};
+ * struct sequence : uuid_field<50> {};
+ * typedef uuid_layout<timestamp, shard, entity, sequence> order_id;
+ *
+ * uuid id = order_id::encode(ms, 12, 3, n);
+ * uint16_t s = order_id::get<shard>(id);
+ * @endcode
+ * @tparam Fields Distinct field types, deriving from uuid_field.
+ */
+template<class... Fields>
+class uuid_layout
+{
+public:
+    /** Number of custom bits used by fields. */
+    static constexpr unsigned width = uuid_layout_detail::width<Fields...>::value;
+    static_assert(width <= 122, "Version 8 UUIDs have 122 custom bits");
+
+    /** Offset of a field, in custom bits from the most significant one. */
+    template<class Field>
+    static constexpr unsigned offset()
+    {
+        return uuid_layout_detail::offset<Field, Fields...>::value;
+    }
+
+    /**
+     * Build a UUID.
+     * @param values Values of fields, in layout order. Only the field width least significant bits are used.
+     */
+    static uuid encode(typename Fields::value_type... values) noexcept
+    {
+        uint64_t msb = version_bits, lsb = variant_bits;
+        const int unused[] = {0, (deposit<Fields>(msb, lsb, values), 0)...};
+        (void)unused;
+        return uuid(msb, lsb);
+    }
+
+    /**
+     * Read all fields of a UUID.
+     * @param id UUID of the layout.
+     * @param values Values of fields, in layout order.
+     */
+    static void decode(const uuid& id, typename Fields::value_type&... values) noexcept
+    {
+        const uint64_t msb = uuid_endian::load_be64(id.data()), lsb = uuid_endian::load_be64(id.data() + 8);
+        const int unused[] = {0, (values = extract<Fields>(msb, lsb), 0)...};
+        (void)unused;
+    }
+
+    /** Read a field of a UUID. */
+    template<class Field>
+    static typename Field::value_type get(const uuid& id) noexcept
+    {
+        return extract<Field>(uuid_endian::load_be64(id.data()), uuid_endian::load_be64(id.data() + 8));
+    }
+
+    /** Change a field of a UUID. Only the field width least significant bits of the value are used. */
+    template<class Field>
+    static void set(uuid& id, typename Field::value_type value) noexcept
+    {
+        typedef uuid_layout_detail::bits<offset<Field>(), Field::width> bits;
+        uint64_t msb = uuid_endian::load_be64(id.data()), lsb = uuid_endian::load_be64(id.data() + 8);
+        uint64_t clear_msb = 0, clear_lsb = 0;
+        bits::deposit(clear_msb, clear_lsb, ~(uint64_t)0);
+        msb &= ~clear_msb;
+        lsb &= ~clear_lsb;
+        bits::deposit(msb, lsb, value);
+        uuid_endian::store_be64(id.data(), msb);
+        uuid_endian::store_be64(id.data() + 8, lsb);
+    }
+
+    /** Test if a UUID is of version 8 and RFC variant, as built by encode(). */
+    static bool valid(const uuid& id) noexcept
+    {
+        return id.version() == uuid::version_t::version_custom && id.variant() == uuid::variant_t::variant_rfc4122;
+    }
+
+    /**
+     * Build UUIDs from columns of field values.
+     * @param out Output array of count UUIDs.
+     * @param count Number of UUIDs.
+     * @param columns Arrays of count values of each field, in layout order.
+     */
+    static void encode(uuid* out, size_t count, const typename Fields::value_type*... columns) noexcept
+    {
+        for(size_t n=0; n<count; ++n)
+        {
+            uint64_t msb = version_bits, lsb = variant_bits;
+            const int unused[] = {0, (deposit<Fields>(msb, lsb, columns[n]), 0)...};
+            (void)unused;
+            uuid_endian::store_be64(out[n].data(), msb);
+            uuid_endian::store_be64(out[n].data() + 8, lsb);
+        }
+    }
+
+    /**
+     * Read fields of UUIDs into columns.
+     * @param in Array of count UUIDs of the layout.
+     * @param count Number of UUIDs.
+     * @param columns Output arrays of count values of each field, in layout order.
+     */
+    static void decode(const uuid* in, size_t count, typename Fields::value_type*... columns) noexcept
+    {
+        for(size_t n=0; n<count; ++n)
+        {
+            const uint64_t msb = uuid_endian::load_be64(in[n].data()), lsb = uuid_endian::load_be64(in[n].data() + 8);
+            const int unused[] = {0, (columns[n] = extract<Fields>(msb, lsb), 0)...};
+            (void)unused;
+        }
+    }
+
+private:
+    static constexpr uint64_t version_bits = (uint64_t)uuid::version_t::version_custom << 12;
+    static constexpr uint64_t variant_bits = 0x8000000000000000ull;
+
+    template<class Field>
+    static void deposit(uint64_t& msb, uint64_t& lsb, typename Field::value_type value) noexcept
+    {
+        uuid_layout_detail::bits<offset<Field>(), Field::width>::deposit(msb, lsb, (uint64_t)value);
+    }
+
+    template<class Field>
+    static typename Field::value_type extract(uint64_t msb, uint64_t lsb) noexcept
+    {
+        return static_cast<typename Field::value_type>(uuid_layout_detail::bits<offset<Field>(), Field::width>::extract(msb, lsb));
+    }
+};
+
+#endif // _UUIDPP_LAYOUT_HPP_
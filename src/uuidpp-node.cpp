@@ -0,0 +1,177 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-node.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-node.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <random>
+
+#if defined(__linux__)
+#include <dirent.h>
+#endif
+
+namespace
+{
+
+/** Node of the host and how it was found. */
+struct host_node
+{
+    uint64_t node;
+    bool hardware;
+};
+
+host_node probe() noexcept
+{
+    host_node found{0, false};
+#if defined(__linux__)
+    try
+    {
+        found.hardware = uuid_node::discover("/sys/class/net", found.node);
+    }
+    catch(...)
+    {
+    }
+#endif
+    if(!found.hardware)
+    {
+        try
+        {
+            found.node = uuid_node::random();
+        }
+        catch(...)
+        {
+            // No random device: a node still unlikely to be shared.
+            std::mt19937_64 engine(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+            found.node = (engine() & 0xFFFFFFFFFFFFull) | uuid_node::multicast;
+        }
+    }
+    return found;
+}
+
+const host_node& probed() noexcept
+{
+    static const host_node node = probe();
+    return node;
+}
+
+/** Read the first word of a file. */
+std::string read_word(const std::string& path)
+{
+    std::string word;
+    std::ifstream(path) >> word;
+    return word;
+}
+
+int hex_digit(char c) noexcept
+{
+    return c >= '0' && c <= '9' ? c - '0'
+         : c >= 'a' && c <= 'f' ? c - 'a' + 10
+         : c >= 'A' && c <= 'F' ? c - 'A' + 10
+         : -1;
+}
+
+} // anonymous namespace
+
+namespace uuid_node
+{
+
+uint64_t host() noexcept
+{
+    return probed().node;
+}
+
+bool hardware() noexcept
+{
+    return probed().hardware;
+}
+
+uint64_t random()
+{
+    std::random_device device;
+    return ((((uint64_t)device() << 32) | device()) & 0xFFFFFFFFFFFFull) | multicast;
+}
+
+bool parse(const std::string& str, uint64_t& node) noexcept
+{
+    if(str.size() != 17)
+    {
+        return false;
+    }
+    uint64_t value = 0;
+    for(size_t n=0; n<17; n+=3)
+    {
+        int high = hex_digit(str[n]), low = hex_digit(str[n + 1]);
+        if(high < 0 || low < 0 || (n + 2 < 17 && str[n + 2] != ':'))
+        {
+            return false;
+        }
+        value = (value << 8) | (unsigned)((high << 4) | low);
+    }
+    node = value;
+    return true;
+}
+
+bool discover(const std::string& path, uint64_t& node)
+{
+#if defined(__linux__)
+    DIR* dir = ::opendir(path.c_str());
+    if(dir == nullptr)
+    {
+        return false;
+    }
+    // Best candidate: universally administered first, then lowest interface name.
+    std::string best_name;
+    uint64_t best = 0;
+    bool found = false;
+    while(struct dirent* entry = ::readdir(dir))
+    {
+        const std::string name = entry->d_name;
+        const std::string interface = path + "/" + name;
+        uint64_t address;
+        // Type 1 is ARPHRD_ETHER, which excludes loopback and tunnels.
+        if(name[0] == '.' || read_word(interface + "/type") != "1"
+           || !parse(read_word(interface + "/address"), address)
+           || address == 0 || (address & multicast) != 0)
+        {
+            continue;
+        }
+        const bool local = (address & 0x020000000000ull) != 0;
+        const bool best_local = (best & 0x020000000000ull) != 0;
+        if(!found || local < best_local || (local == best_local && name < best_name))
+        {
+            best_name = name;
+            best = address;
+            found = true;
+        }
+    }
+    ::closedir(dir);
+    if(found)
+    {
+        node = best;
+    }
+    return found;
+#else
+    (void)path;
+    (void)node;
+    return false;
+#endif
+}
+
+} // namespace uuid_node
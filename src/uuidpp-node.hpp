@@ -0,0 +1,71 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-node.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_NODE_HPP_
+#define _UUIDPP_NODE_HPP_
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Node of time based UUIDs (versions 1 and 6) of the host.
+ *
+ * The node is discovered once per process: the hardware address of an
+ * Ethernet interface read from sysfs on Linux, or else a random node with
+ * the multicast bit set, which cannot be a hardware address (RFC 4122,
+ * section 4.5). Generating UUIDs then never costs a system call for the node.
+ */
+namespace uuid_node
+{
+
+    /** Multicast bit of a node, set by random nodes. */
+    constexpr uint64_t multicast = 0x010000000000ull;
+
+    /** Node of the host, discovered on first call. */
+    uint64_t host() noexcept;
+
+    /** True if the node of the host is a hardware address, false if random. */
+    bool hardware() noexcept;
+
+    /** A new random node, with the multicast bit set. */
+    uint64_t random();
+
+    /**
+     * Find the hardware address of an Ethernet interface in a sysfs network
+     * class directory. Universally administered addresses are preferred to
+     * locally administered ones (as of virtual interfaces), then interfaces
+     * are taken by name, so that the same address is found by all processes.
+     * @param path Directory of interfaces, "/sys/class/net" on Linux.
+     * @param node Found address.
+     * @return True if an address is found.
+     */
+    bool discover(const std::string& path, uint64_t& node);
+
+    /**
+     * Parse a MAC address.
+     * @param str Address as six hexadecimal bytes separated by colons, "00:1a:2b:3c:4d:5e".
+     * @param node Parsed address.
+     * @return True if the address is valid.
+     */
+    bool parse(const std::string& str, uint64_t& node) noexcept;
+
+} // namespace uuid_node
+
+#endif // _UUIDPP_NODE_HPP_
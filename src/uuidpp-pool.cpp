@@ -0,0 +1,404 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-pool.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+
+//
+// Latency histogram
+//
+
+namespace
+{
+
+/** Bucket of a latency: exact below 16, then 16 buckets per power of two. */
+inline size_t bucket_of(uint64_t ns)
+{
+    if(ns < 16)
+    {
+        return ns;
+    }
+    unsigned exponent = 63 - __builtin_clzll(ns);
+    return (exponent - 3) * 16 + ((ns >> (exponent - 4)) & 15);
+}
+
+/** Highest latency of a bucket. */
+inline uint64_t bucket_upper(size_t bucket)
+{
+    if(bucket < 16)
+    {
+        return bucket;
+    }
+    unsigned shift = bucket / 16 - 1;
+    uint64_t lower = (uint64_t)(16 + bucket % 16) << shift;
+    return lower + ((uint64_t)1 << shift) - 1;
+}
+
+} // anonymous namespace
+
+constexpr size_t uuid_latency_histogram::sub_buckets;
+constexpr size_t uuid_latency_histogram::buckets;
+
+void uuid_latency_histogram::record(uint64_t ns) noexcept
+{
+    ++_counts[bucket_of(ns)];
+    ++_count;
+    _max = std::max(_max, ns);
+}
+
+uint64_t uuid_latency_histogram::percentile(double p) const noexcept
+{
+    if(_count == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)(p * _count + 0.5));
+    uint64_t seen = 0;
+    for(size_t n=0; n<buckets; ++n)
+    {
+        seen += _counts[n];
+        if(seen >= rank)
+        {
+            return std::min(bucket_upper(n), _max);
+        }
+    }
+    return _max;
+}
+
+void uuid_latency_histogram::merge(const uuid_latency_histogram& other) noexcept
+{
+    for(size_t n=0; n<buckets; ++n)
+    {
+        _counts[n] += other._counts[n];
+    }
+    _count += other._count;
+    _max = std::max(_max, other._max);
+}
+
+void uuid_latency_histogram::reset() noexcept
+{
+    _counts.fill(0);
+    _count = 0;
+    _max = 0;
+}
+
+//
+// Background refill
+//
+
+/**
+ * Thread refilling the background pools which asked for it.
+ * The mutex is not held during refills, so that a consumer asking for a
+ * refill is never blocked by the refill of another pool.
+ *
+ * All pools are registered, bulk ones too, so that a forked process can
+ * empty the rings it inherited: they hold the next UUIDs of the parent.
+ * The thread is started on the first refill request, again in a forked
+ * process.
+ */
+class uuid_pool_refiller
+{
+public:
+    static uuid_pool_refiller& instance()
+    {
+        static uuid_pool_refiller refiller;
+        return refiller;
+    }
+
+    void add(uuid_pool* pool)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pools.push_back(pool);
+    }
+
+    /** Remove a pool, waiting for its refill to end if running. */
+    void remove(uuid_pool* pool)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _filled.wait(lock, [&]{return _filling != pool;});
+        _pools.erase(std::remove(_pools.begin(), _pools.end(), pool), _pools.end());
+    }
+
+    void wake()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending = true;
+            if(!_thread.joinable())
+            {
+                _thread = std::thread(&uuid_pool_refiller::run, this);
+            }
+        }
+        _wake.notify_one();
+    }
+
+private:
+    uuid_pool_refiller()
+    {
+        static const int registered = ::pthread_atfork(prepare_fork, parent_fork, child_fork);
+        (void)registered;
+        current = this;
+    }
+
+    ~uuid_pool_refiller()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+            current = nullptr;
+        }
+        _wake.notify_one();
+        if(_thread.joinable())
+        {
+            _thread.join();
+        }
+    }
+
+    /** Keep the pool list consistent across fork(). */
+    static void prepare_fork()
+    {
+        if(current != nullptr)
+        {
+            current->_mutex.lock();
+        }
+    }
+
+    static void parent_fork()
+    {
+        if(current != nullptr)
+        {
+            current->_mutex.unlock();
+        }
+    }
+
+    /**
+     * In the child, only the forking thread runs: the refill thread and its
+     * waits are gone, so the synchronization objects are built again over the
+     * inherited ones, which cannot be destroyed (a joinable thread, condition
+     * variables with waiters). Rings are emptied, to be refilled with the
+     * generator of the child.
+     */
+    static void child_fork()
+    {
+        uuid_pool_refiller* refiller = current;
+        if(refiller == nullptr)
+        {
+            return;
+        }
+        new(&refiller->_mutex) std::mutex;
+        new(&refiller->_wake) std::condition_variable;
+        new(&refiller->_filled) std::condition_variable;
+        new(&refiller->_thread) std::thread;
+        refiller->_filling = nullptr;
+        refiller->_pending = false;
+        for(uuid_pool* pool : refiller->_pools)
+        {
+            pool->empty();
+        }
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        for(;;)
+        {
+            _wake.wait(lock, [this]{return _stop || _pending;});
+            if(_stop)
+            {
+                return;
+            }
+            _pending = false;
+            // Pools may be added or removed during refills: scan until none asks.
+            bool refilled = true;
+            while(refilled)
+            {
+                refilled = false;
+                for(size_t n=0; n<_pools.size(); ++n)
+                {
+                    uuid_pool* pool = _pools[n];
+                    if(pool->_requested.exchange(false, std::memory_order_acquire))
+                    {
+                        _filling = pool;
+                        lock.unlock();
+                        pool->fill();
+                        lock.lock();
+                        _filling = nullptr;
+                        _filled.notify_all();
+                        refilled = true;
+                    }
+                }
+            }
+        }
+    }
+
+    /** Refiller of the fork handlers, null once destroyed. */
+    static uuid_pool_refiller* current;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _filled;
+    std::vector<uuid_pool*> _pools;
+    uuid_pool* _filling = nullptr;
+    bool _pending = false;
+    bool _stop = false;
+    std::thread _thread;
+};
+
+uuid_pool_refiller* uuid_pool_refiller::current = nullptr;
+
+//
+// Pool
+//
+
+constexpr size_t uuid_pool::default_capacity;
+
+uuid_pool::uuid_pool(size_t capacity, refill_mode mode):
+_mode(mode)
+{
+    size_t size = 2;
+    while(size < capacity)
+    {
+        size *= 2;
+    }
+    _ring.resize(size);
+    _mask = size - 1;
+    _half = size / 2;
+    fill();
+    _tail_seen = _tail.load(std::memory_order_relaxed);
+    uuid_pool_refiller::instance().add(this);
+}
+
+uuid_pool::~uuid_pool()
+{
+    uuid_pool_refiller::instance().remove(this);
+}
+
+uuid_pool& uuid_pool::local()
+{
+    static thread_local uuid_pool pool;
+    return pool;
+}
+
+void uuid_pool::fill()
+{
+    // Only the producer moves the tail, the consumer only frees slots meanwhile.
+    const uint64_t tail = _tail.load(std::memory_order_relaxed);
+    const uint64_t head = _head.load(std::memory_order_acquire);
+    const uint64_t free = capacity() - (tail - head);
+    const uint64_t first = tail & _mask;
+    const uint64_t before_wrap = std::min<uint64_t>(free, capacity() - first);
+    uuid::version4(&_ring[first], before_wrap);
+    uuid::version4(&_ring[0], free - before_wrap);
+    _tail.store(tail + free, std::memory_order_release);
+}
+
+void uuid_pool::empty() noexcept
+{
+    const uint64_t tail = _tail.load(std::memory_order_relaxed);
+    _head.store(tail, std::memory_order_relaxed);
+    _tail_seen = tail;
+    _requested.store(false, std::memory_order_relaxed);
+}
+
+void uuid_pool::request_refill()
+{
+    _tail_seen = _tail.load(std::memory_order_acquire);
+    if(_tail_seen - _head.load(std::memory_order_relaxed) > _half)
+    {
+        return;
+    }
+    if(_mode == refill_mode::bulk)
+    {
+        fill();
+        _tail_seen = _tail.load(std::memory_order_relaxed);
+    }
+    else if(!_requested.exchange(true, std::memory_order_release))
+    {
+        uuid_pool_refiller::instance().wake();
+    }
+}
+
+uuid uuid_pool::take_slow()
+{
+    request_refill();
+    const uint64_t head = _head.load(std::memory_order_relaxed);
+    if(head != _tail_seen)
+    {
+        const uuid id = _ring[head & _mask];
+        _head.store(head + 1, std::memory_order_release);
+        return id;
+    }
+    // Background refill late: do not wait for it.
+    ++_misses;
+    uuid id;
+    uuid::version4(&id, 1);
+    return id;
+}
+
+uuid uuid_pool::next_measured()
+{
+    auto start = std::chrono::steady_clock::now();
+    const uuid id = take();
+    auto end = std::chrono::steady_clock::now();
+    _latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    return id;
+}
+
+void uuid_pool::next(uuid* out, size_t count)
+{
+    while(count > 0)
+    {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        if(head == _tail_seen)
+        {
+            request_refill();
+            if(head == _tail_seen)
+            {
+                _misses += count;
+                uuid::version4(out, count);
+                return;
+            }
+        }
+        const uint64_t first = head & _mask;
+        const size_t taken = std::min<uint64_t>({count, _tail_seen - head, capacity() - first});
+        std::memcpy(out, &_ring[first], taken * sizeof(uuid));
+        _head.store(head + taken, std::memory_order_release);
+        out += taken;
+        count -= taken;
+        if(_tail_seen - (head + taken) <= _half)
+        {
+            request_refill();
+        }
+    }
+}
+
+size_t uuid_pool::available() const noexcept
+{
+    return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_relaxed);
+}
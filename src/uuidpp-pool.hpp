@@ -0,0 +1,202 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-pool.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_POOL_HPP_
+#define _UUIDPP_POOL_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "uuidpp.hpp"
+#include "uuidpp-aligned.hpp"
+
+/**
+ * Distribution of latencies in nanoseconds.
+ * Values are counted exactly up to 16 ns, then in 16 buckets per power of
+ * two (about 6% precision).
+ */
+class uuid_latency_histogram
+{
+public:
+    /** Record a latency. */
+    void record(uint64_t ns) noexcept;
+
+    /** Number of recorded latencies. */
+    uint64_t count() const noexcept {return _count;}
+
+    /** Highest recorded latency. */
+    uint64_t max() const noexcept {return _max;}
+
+    /**
+     * Latency not exceeded by a fraction of the records.
+     * @param p Fraction, 0.5 for the median, 0.99 for the 99th percentile.
+     * @return Upper bound of the bucket of the percentile, 0 if nothing recorded.
+     */
+    uint64_t percentile(double p) const noexcept;
+
+    /** Add the records of another histogram, for example of another thread. */
+    void merge(const uuid_latency_histogram& other) noexcept;
+
+    /** Forget all records. */
+    void reset() noexcept;
+
+private:
+    static constexpr size_t sub_buckets = 16;
+    static constexpr size_t buckets = (64 - 3) * sub_buckets;
+
+    std::array<uint64_t, buckets> _counts = {};
+    uint64_t _count = 0;
+    uint64_t _max = 0;
+};
+
+/**
+ * Random UUIDs (version 4) pre-generated in a ring, so that taking one
+ * costs a few nanoseconds whatever the random generator.
+ *
+ * A pool belongs to one consumer thread. It is refilled either by a
+ * background thread shared by all pools, woken up when a pool is half
+ * empty, or in bulk by the consumer itself when half empty. Generator
+ * seeding and refills of background pools then never happen on the
+ * consumer thread; if a background pool runs empty anyway, UUIDs are
+ * generated directly, without waiting. Background refills need a spare
+ * core: on a saturated machine, bulk refills give steadier latencies.
+ *
+ * Latencies of next() can be recorded, to follow p50 and p99.
+ *
+ * Pools can be used across fork(): a forked process drops the UUIDs
+ * inherited in the rings, which its parent hands out too, and generates
+ * and refills with its own generator and background thread.
+ */
+class uuid_pool
+{
+public:
+    /** How the ring is refilled when half empty. */
+    enum class refill_mode
+    {
+        /** By the shared background thread. */
+        background,
+        /** By the consumer, on the fetch crossing half of the ring. */
+        bulk
+    };
+
+    /** Default number of UUIDs in the ring. */
+    static constexpr size_t default_capacity = 4096;
+
+    /**
+     * Create a pool, filled before returning.
+     * @param capacity Number of UUIDs in the ring, rounded up to a power of two, at least 2.
+     * @param mode How the ring is refilled.
+     */
+    explicit uuid_pool(size_t capacity = default_capacity, refill_mode mode = refill_mode::background);
+
+    uuid_pool(const uuid_pool&) = delete;
+    uuid_pool& operator=(const uuid_pool&) = delete;
+
+    /** Detach the pool from the background thread. */
+    ~uuid_pool();
+
+    /**
+     * Pool of the calling thread, refilled in background, created on first
+     * use and destroyed when the thread exits.
+     */
+    static uuid_pool& local();
+
+    /** Take a random UUID, from the owning thread only. */
+    uuid next()
+    {
+        return _measure ? next_measured() : take();
+    }
+
+    /**
+     * Take random UUIDs, from the owning thread only.
+     * @param out Output array of count UUIDs.
+     * @param count Number of UUIDs to take.
+     */
+    void next(uuid* out, size_t count);
+
+    /** Number of UUIDs in the ring. */
+    size_t capacity() const noexcept {return _mask + 1;}
+
+    /** Number of UUIDs ready in the ring. */
+    size_t available() const noexcept;
+
+    /** Number of UUIDs generated directly because the ring was empty. */
+    uint64_t misses() const noexcept {return _misses;}
+
+    /**
+     * Record latencies of next() from now on, or stop recording.
+     * Each record adds the cost of reading the clock.
+     */
+    void measure(bool enable) noexcept {_measure = enable;}
+
+    /** Recorded latencies of next(), from the owning thread only. */
+    const uuid_latency_histogram& latency() const noexcept {return _latency;}
+
+    /** Forget recorded latencies. */
+    void reset_latency() noexcept {_latency.reset();}
+
+private:
+    friend class uuid_pool_refiller;
+
+    uuid take()
+    {
+        const uint64_t head = _head.load(std::memory_order_relaxed);
+        if(head == _tail_seen)
+        {
+            return take_slow();
+        }
+        const uuid id = _ring[head & _mask];
+        _head.store(head + 1, std::memory_order_release);
+        if(_tail_seen - head == _half)
+        {
+            request_refill();
+        }
+        return id;
+    }
+
+    uuid take_slow();
+    uuid next_measured();
+    /** Ask for a refill if the ring is still half empty. */
+    void request_refill();
+    /** Fill free slots of the ring, from the producer side. */
+    void fill();
+    /** Drop the UUIDs of the ring, in a forked process. */
+    void empty() noexcept;
+
+    uuid_aligned_vector<uuid> _ring;
+    uint64_t _mask;
+    uint64_t _half;
+    refill_mode _mode;
+
+    /** Consumer side: next slot to take, and last seen producer position. */
+    alignas(64) std::atomic<uint64_t> _head{0};
+    uint64_t _tail_seen = 0;
+    bool _measure = false;
+    uint64_t _misses = 0;
+    uuid_latency_histogram _latency;
+
+    /** Producer side: next slot to fill, and pending refill request. */
+    alignas(64) std::atomic<uint64_t> _tail{0};
+    std::atomic<bool> _requested{false};
+};
+
+#endif // _UUIDPP_POOL_HPP_
@@ -0,0 +1,303 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-scan.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-scan.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "uuidpp-cpu.hpp"
+
+#if defined(UUIDPP_CPU_X86)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+typedef unsigned __int128 mask128;
+
+/** Bitmaps of hexadecimal digits and dashes of 64 bytes. */
+struct block_masks
+{
+    uint64_t hex, dash;
+};
+
+/*
+ * Classification of consecutive 64 bytes blocks, one function per instruction set.
+ * Hexadecimal digits are (c - '0') < 10 or ((c | 0x20) - 'a') < 6 as unsigned,
+ * tested with signed comparisons of biased bytes.
+ */
+typedef void (*classify_function)(const char* ptr, size_t blocks, block_masks* out);
+
+void classify_scalar(const char* ptr, size_t blocks, block_masks* out)
+{
+    for(size_t block=0; block<blocks; ++block, ptr+=64)
+    {
+        block_masks masks = {0, 0};
+        for(int n=0; n<64; ++n)
+        {
+            unsigned char c = ptr[n];
+            bool hex = (unsigned)(c - '0') < 10 || (unsigned)((c | 0x20) - 'a') < 6;
+            masks.hex |= (uint64_t)hex << n;
+            masks.dash |= (uint64_t)(c == '-') << n;
+        }
+        out[block] = masks;
+    }
+}
+
+#if defined(UUIDPP_CPU_X86)
+
+UUIDPP_TARGET("sse2")
+void classify_sse2(const char* ptr, size_t blocks, block_masks* out)
+{
+    const __m128i digit_bias = _mm_set1_epi8((char)(0x80 - '0'));
+    const __m128i digit_limit = _mm_set1_epi8((char)(-0x80 + 10));
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i letter_bias = _mm_set1_epi8((char)(0x80 - 'a'));
+    const __m128i letter_limit = _mm_set1_epi8((char)(-0x80 + 6));
+    const __m128i dash = _mm_set1_epi8('-');
+    for(size_t block=0; block<blocks; ++block, ptr+=64)
+    {
+        block_masks masks = {0, 0};
+        for(int quarter=0; quarter<4; ++quarter)
+        {
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + quarter * 16));
+            __m128i digit = _mm_cmplt_epi8(_mm_add_epi8(c, digit_bias), digit_limit);
+            __m128i letter = _mm_cmplt_epi8(_mm_add_epi8(_mm_or_si128(c, lower), letter_bias), letter_limit);
+            masks.hex |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_or_si128(digit, letter)) << (quarter * 16);
+            masks.dash |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, dash)) << (quarter * 16);
+        }
+        out[block] = masks;
+    }
+}
+
+UUIDPP_TARGET("avx2")
+void classify_avx2(const char* ptr, size_t blocks, block_masks* out)
+{
+    const __m256i digit_bias = _mm256_set1_epi8((char)(0x80 - '0'));
+    const __m256i digit_limit = _mm256_set1_epi8((char)(-0x80 + 10));
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    const __m256i letter_bias = _mm256_set1_epi8((char)(0x80 - 'a'));
+    const __m256i letter_limit = _mm256_set1_epi8((char)(-0x80 + 6));
+    const __m256i dash = _mm256_set1_epi8('-');
+    for(size_t block=0; block<blocks; ++block, ptr+=64)
+    {
+        block_masks masks = {0, 0};
+        for(int half=0; half<2; ++half)
+        {
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + half * 32));
+            __m256i digit = _mm256_cmpgt_epi8(digit_limit, _mm256_add_epi8(c, digit_bias));
+            __m256i letter = _mm256_cmpgt_epi8(letter_limit, _mm256_add_epi8(_mm256_or_si256(c, lower), letter_bias));
+            masks.hex |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(digit, letter)) << (half * 32);
+            masks.dash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(c, dash)) << (half * 32);
+        }
+        out[block] = masks;
+    }
+}
+
+UUIDPP_TARGET("avx512f,avx512bw")
+void classify_avx512(const char* ptr, size_t blocks, block_masks* out)
+{
+    // Byte comparisons yield 64 bits masks directly, unsigned comparisons need no bias.
+    const __m512i zero = _mm512_set1_epi8('0');
+    const __m512i ten = _mm512_set1_epi8(10);
+    const __m512i lower = _mm512_set1_epi8(0x20);
+    const __m512i a = _mm512_set1_epi8('a');
+    const __m512i six = _mm512_set1_epi8(6);
+    const __m512i dash = _mm512_set1_epi8('-');
+    for(size_t block=0; block<blocks; ++block, ptr+=64)
+    {
+        __m512i c = _mm512_loadu_si512(ptr);
+        __mmask64 digit = _mm512_cmplt_epu8_mask(_mm512_sub_epi8(c, zero), ten);
+        __mmask64 letter = _mm512_cmplt_epu8_mask(_mm512_sub_epi8(_mm512_or_si512(c, lower), a), six);
+        out[block].hex = digit | letter;
+        out[block].dash = _mm512_cmpeq_epi8_mask(c, dash);
+    }
+}
+
+#endif
+
+/** Classification function of the active instruction set. */
+classify_function classifier()
+{
+#if defined(UUIDPP_CPU_X86)
+    if(uuid_cpu::has(uuid_cpu::avx512))
+    {
+        return classify_avx512;
+    }
+    if(uuid_cpu::has(uuid_cpu::avx2))
+    {
+        return classify_avx2;
+    }
+    if(uuid_cpu::has(uuid_cpu::sse2))
+    {
+        return classify_sse2;
+    }
+#endif
+    return classify_scalar;
+}
+
+/** Number of blocks classified at once, 4KiB of text. */
+constexpr size_t classify_batch = 64;
+
+/**
+ * Sequential classification of the blocks of a text, by batches of blocks
+ * to amortize kernel calls. Bytes past the end of the text are neither
+ * digits nor dashes.
+ */
+class block_classifier
+{
+public:
+    block_classifier(const char* text, size_t size):
+    _text(text), _size(size), _classify(classifier())
+    {}
+
+    /** Masks of a block, blocks being requested in order. */
+    block_masks get(size_t block)
+    {
+        if(block * 64 >= _size)
+        {
+            return block_masks{0, 0};
+        }
+        if(block >= _end)
+        {
+            fill(block);
+        }
+        return _masks[block - _begin];
+    }
+
+private:
+    void fill(size_t block)
+    {
+        const size_t offset = block * 64;
+        size_t full = std::min(classify_batch, (_size - offset) / 64);
+        _classify(_text + offset, full, _masks);
+        if(full < classify_batch && offset + full * 64 < _size)
+        {
+            char tail[64] = {};
+            std::memcpy(tail, _text + offset + full * 64, _size - offset - full * 64);
+            _classify(tail, 1, _masks + full);
+            ++full;
+        }
+        _begin = block;
+        _end = block + full;
+    }
+
+    const char* _text;
+    size_t _size;
+    classify_function _classify;
+    size_t _begin = 0, _end = 0;
+    block_masks _masks[classify_batch];
+};
+
+/** Value of a character known to be an hexadecimal digit. */
+inline uint8_t digit_value(char c)
+{
+    return (c & 0x0F) + 9 * ((c >> 6) & 1);
+}
+
+/**
+ * Decode a UUID whose digits were already validated by classification.
+ * @param text First digit of the UUID.
+ * @param dashes True for the canonical format, false for the compact one.
+ */
+inline uuid decode(const char* text, bool dashes)
+{
+    static const uint8_t canonical[16] = {0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34};
+    static const uint8_t compact[16] = {0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30};
+    const uint8_t* offsets = dashes ? canonical : compact;
+    uuid id;
+    for(size_t n=0; n<16; ++n)
+    {
+        id[n] = (uint8_t)(digit_value(text[offsets[n]]) << 4 | digit_value(text[offsets[n] + 1]));
+    }
+    return id;
+}
+
+} // anonymous namespace
+
+size_t uuid_scanner::scan(const char* text, size_t size, match_function function, void* context) const
+{
+    size_t found = 0;
+    block_classifier blocks(text, size);
+    block_masks current = blocks.get(0);
+    bool previous_hex = false;
+    for(size_t base=0; base<size; base+=64)
+    {
+        // Candidates can extend up to 36 bytes past the block, look at the next one too.
+        block_masks next = blocks.get(base / 64 + 1);
+        const mask128 hex = (mask128)current.hex | (mask128)next.hex << 64;
+        const mask128 dash = (mask128)current.dash | (mask128)next.dash << 64;
+        const mask128 not_hex = ~hex;
+
+        // Bit n of hexN is set when N hexadecimal digits start at n.
+        const mask128 hex2 = hex & hex >> 1;
+        const mask128 hex4 = hex2 & hex2 >> 2;
+        const mask128 hex8 = hex4 & hex4 >> 4;
+        const mask128 hex12 = hex8 & hex4 >> 8;
+        const mask128 hex16 = hex8 & hex8 >> 8;
+        const mask128 hex32 = hex16 & hex16 >> 16;
+        const mask128 bounded = (not_hex << 1 | (mask128)!previous_hex);
+
+        const uint64_t canonical_at = (uint64_t)(hex8 & dash >> 8 & hex4 >> 9 & dash >> 13 & hex4 >> 14
+                & dash >> 18 & hex4 >> 19 & dash >> 23 & hex12 >> 24 & bounded & not_hex >> 36);
+        const uint64_t compact_at = (uint64_t)(hex32 & bounded & not_hex >> 32);
+
+        uint64_t candidates = canonical_at | compact_at;
+        while(candidates != 0)
+        {
+            const unsigned bit = __builtin_ctzll(candidates);
+            candidates &= candidates - 1;
+            const size_t pos = base + bit;
+
+            uuid_match match;
+            if((compact_at >> bit) & 1)
+            {
+                if(!(_formats & compact))
+                {
+                    continue;
+                }
+                match.offset = pos;
+                match.length = 32;
+            }
+            else if((_formats & braced) && pos > 0 && pos + 36 < size && text[pos - 1] == '{' && text[pos + 36] == '}')
+            {
+                match.offset = pos - 1;
+                match.length = 38;
+            }
+            else if(_formats & canonical)
+            {
+                match.offset = pos;
+                match.length = 36;
+            }
+            else
+            {
+                continue;
+            }
+            match.id = decode(text + pos, match.length != 32);
+            function(context, match);
+            ++found;
+        }
+
+        previous_hex = (current.hex >> 63) & 1;
+        current = next;
+    }
+    return found;
+}
@@ -0,0 +1,111 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-scan.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_SCAN_HPP_
+#define _UUIDPP_SCAN_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "uuidpp.hpp"
+
+/** UUID found in a text. */
+struct uuid_match
+{
+    /** Offset of the first character of the UUID text, opening brace included. */
+    size_t offset;
+    /** Length of the UUID text: 36 (canonical), 32 (compact) or 38 (braced). */
+    size_t length;
+    /** Decoded UUID. */
+    uuid id;
+};
+
+/**
+ * Scanner extracting UUIDs embedded in arbitrary text (logs, JSON, URLs...).
+ *
+ * Text is classified 64 bytes at a time into bitmaps of hexadecimal digits
+ * and dashes (with AVX-512, AVX2 or SSE2 when available), UUID candidates
+ * being found with bitwise operations on these bitmaps.
+ *
+ * A UUID is only recognized when it is not glued to other hexadecimal
+ * digits: "0123...cdef0" is not a UUID followed by "0".
+ */
+class uuid_scanner
+{
+public:
+    /** Recognized UUID text formats. */
+    enum format : unsigned
+    {
+        /** "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx" */
+        canonical = 1,
+        /** "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" */
+        compact = 2,
+        /** "{xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}" */
+        braced = 4,
+        all = canonical | compact | braced
+    };
+
+    /** Function receiving matches, with a user context. */
+    typedef void (*match_function)(void* context, const uuid_match& match);
+
+    /**
+     * Construct a scanner.
+     * @param formats Combination of recognized formats. A braced UUID is
+     * reported as braced when braced is recognized, as canonical otherwise.
+     */
+    explicit uuid_scanner(unsigned formats = all): _formats(formats) {}
+
+    /** Recognized formats. */
+    unsigned formats() const noexcept {return _formats;}
+
+    /**
+     * Extract UUIDs from a text.
+     * @param text Text to scan, not necessarily 0-terminated.
+     * @param size Size of the text in bytes.
+     * @param function Function called for each UUID, in text order.
+     * @param context Context passed to function.
+     * @return Number of UUIDs found.
+     */
+    size_t scan(const char* text, size_t size, match_function function, void* context) const;
+
+    /**
+     * Extract UUIDs from a text.
+     * @tparam Callback Function object callable with a const uuid_match&.
+     * @param text Text to scan, not necessarily 0-terminated.
+     * @param size Size of the text in bytes.
+     * @param callback Callback called for each UUID, in text order.
+     * @return Number of UUIDs found.
+     */
+    template<class Callback>
+    size_t scan(const char* text, size_t size, Callback&& callback) const
+    {
+        typedef typename std::remove_reference<Callback>::type callback_t;
+        return scan(text, size, [](void* context, const uuid_match& match)
+        {
+            (*static_cast<callback_t*>(context))(match);
+        }, const_cast<void*>(static_cast<const void*>(&callback)));
+    }
+
+private:
+    unsigned _formats;
+};
+
+#endif // _UUIDPP_SCAN_HPP_
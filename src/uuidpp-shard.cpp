@@ -0,0 +1,108 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-shard.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-shard.hpp"
+
+#include <vector>
+
+namespace
+{
+
+/** Weight of a shard, from the hash of the UUID and the mixed shard identifier. */
+inline uint64_t weight(uint64_t key, uint64_t mixed_shard) noexcept
+{
+    return uuid_shard::mix(key ^ mixed_shard);
+}
+
+/**
+ * Index of the highest weight among shards, the first one on ties.
+ * @param key Hash of the UUID.
+ * @param count Number of shards, at least 1.
+ * @param mixed_shard Functor giving the mixed identifier of a shard from its index.
+ */
+template<typename MixedShard>
+inline uint32_t highest(uint64_t key, uint32_t count, MixedShard mixed_shard) noexcept
+{
+    uint32_t best = 0;
+    uint64_t best_weight = weight(key, mixed_shard(0));
+    for(uint32_t n=1; n<count; ++n)
+    {
+        const uint64_t w = weight(key, mixed_shard(n));
+        if(w > best_weight)
+        {
+            best = n;
+            best_weight = w;
+        }
+    }
+    return best;
+}
+
+} // anonymous namespace
+
+namespace uuid_shard
+{
+
+uint32_t jump(uint64_t key, uint32_t buckets) noexcept
+{
+    // Follows the jumps of the key from bucket to bucket while the number of buckets grows.
+    int64_t b = -1, j = 0;
+    while(j < (int64_t)buckets)
+    {
+        b = j;
+        key = key * 2862933555777941757ull + 1;
+        j = (int64_t)((double)(b + 1) * ((double)(1ll << 31) / (double)((key >> 33) + 1)));
+    }
+    return (uint32_t)b;
+}
+
+uint32_t rendezvous(const uuid& id, const uint64_t* shards, uint32_t count) noexcept
+{
+    return highest(hash(id), count, [shards](uint32_t s) { return mix(shards[s]); });
+}
+
+void range(const uuid* ids, size_t count, uint32_t shards, uint32_t* out) noexcept
+{
+    for(size_t n=0; n<count; ++n)
+    {
+        out[n] = range(ids[n], shards);
+    }
+}
+
+void jump(const uuid* ids, size_t count, uint32_t shards, uint32_t* out) noexcept
+{
+    for(size_t n=0; n<count; ++n)
+    {
+        out[n] = jump(hash(ids[n]), shards);
+    }
+}
+
+void rendezvous(const uuid* ids, size_t count, const uint64_t* shards, uint32_t shard_count, uint32_t* out)
+{
+    std::vector<uint64_t> mixed(shard_count);
+    for(uint32_t n=0; n<shard_count; ++n)
+    {
+        mixed[n] = mix(shards[n]);
+    }
+    for(size_t n=0; n<count; ++n)
+    {
+        out[n] = highest(hash(ids[n]), shard_count, [&mixed](uint32_t s) { return mixed[s]; });
+    }
+}
+
+} // namespace uuid_shard
@@ -0,0 +1,148 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-shard.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_SHARD_HPP_
+#define _UUIDPP_SHARD_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "uuidpp.hpp"
+#include "uuidpp-endian.hpp"
+
+/**
+ * Routing of UUIDs to shards (partitions, nodes).
+ *
+ * UUIDs are first hashed on all their 128 bits with a mixing function, so
+ * that time based UUIDs, whose bits barely change from one to the next,
+ * spread as well as random ones. Hashes are then mapped to shards:
+ * - range(): by Lemire's fast range reduction, a multiplication instead of
+ *   a modulo; changing the number of shards moves most UUIDs;
+ * - jump(): by jump consistent hash (Lamping and Veach), in O(log n)
+ *   without memory; adding a shard only moves UUIDs to it, shards are
+ *   numbered from 0 and only the last one can be removed;
+ * - rendezvous(): by highest random weight, in O(n) over shards named by
+ *   64 bits identifiers; removing any shard only moves its UUIDs.
+ */
+namespace uuid_shard
+{
+
+    /** Mix the bits of a word (finalizer of MurmurHash3): each input bit changes each output bit with probability 1/2. */
+    inline uint64_t mix(uint64_t h) noexcept
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    /** Hash of all bits of a UUID. */
+    inline uint64_t hash(const uuid& id) noexcept
+    {
+        return mix(uuid_endian::load_be64(id.data()) ^ mix(uuid_endian::load_be64(id.data() + 8)));
+    }
+
+    /**
+     * Map a hash to [0, n) by Lemire's fast range reduction: the high
+     * word of the product of the hash by n, as fair as a modulo for
+     * uniform hashes, and without division.
+     */
+    inline uint32_t fast_range(uint64_t hash, uint32_t n) noexcept
+    {
+#if defined(__SIZEOF_INT128__)
+        return (uint32_t)(((unsigned __int128)hash * n) >> 64);
+#else
+        return (uint32_t)(((hash >> 32) * n) >> 32);
+#endif
+    }
+
+    /**
+     * Shard of a UUID among n, not consistent.
+     * @param id UUID to route.
+     * @param shards Number of shards.
+     * @return Shard, in [0, shards).
+     */
+    inline uint32_t range(const uuid& id, uint32_t shards) noexcept
+    {
+        return fast_range(hash(id), shards);
+    }
+
+    /**
+     * Bucket of a key by jump consistent hash.
+     * @param key Key, as an uniform 64 bits hash.
+     * @param buckets Number of buckets, at least 1.
+     * @return Bucket, in [0, buckets).
+     */
+    uint32_t jump(uint64_t key, uint32_t buckets) noexcept;
+
+    /**
+     * Shard of a UUID by jump consistent hash.
+     * @param id UUID to route.
+     * @param shards Number of shards, at least 1.
+     * @return Shard, in [0, shards).
+     */
+    inline uint32_t jump(const uuid& id, uint32_t shards) noexcept
+    {
+        return jump(hash(id), shards);
+    }
+
+    /**
+     * Shard of a UUID by rendezvous hashing: the shard of highest weight
+     * for the UUID, weights being hashes of the UUID and shard identifiers.
+     * @param id UUID to route.
+     * @param shards Identifiers of shards, distinct.
+     * @param count Number of shards, at least 1.
+     * @return Index of the shard in shards.
+     */
+    uint32_t rendezvous(const uuid& id, const uint64_t* shards, uint32_t count) noexcept;
+
+    /**
+     * Route UUIDs with range().
+     * @param ids UUIDs to route.
+     * @param count Number of UUIDs.
+     * @param shards Number of shards.
+     * @param out Output array of count shards.
+     */
+    void range(const uuid* ids, size_t count, uint32_t shards, uint32_t* out) noexcept;
+
+    /**
+     * Route UUIDs with jump().
+     * @param ids UUIDs to route.
+     * @param count Number of UUIDs.
+     * @param shards Number of shards, at least 1.
+     * @param out Output array of count shards.
+     */
+    void jump(const uuid* ids, size_t count, uint32_t shards, uint32_t* out) noexcept;
+
+    /**
+     * Route UUIDs with rendezvous(), hashing shard identifiers once.
+     * @param ids UUIDs to route.
+     * @param count Number of UUIDs.
+     * @param shards Identifiers of shards, distinct.
+     * @param shard_count Number of shards, at least 1.
+     * @param out Output array of count shard indexes.
+     */
+    void rendezvous(const uuid* ids, size_t count, const uint64_t* shards, uint32_t shard_count, uint32_t* out);
+
+} // namespace uuid_shard
+
+#endif // _UUIDPP_SHARD_HPP_
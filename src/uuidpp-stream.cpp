@@ -0,0 +1,225 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-stream.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+#include "uuidpp-stream.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr size_t uuid_extractor::default_chunk_size;
+constexpr size_t uuid_extractor::min_chunk_size;
+
+namespace
+{
+
+/**
+ * Bytes after the first digit of a UUID needed to decide it: 36 digits and
+ * dashes, then a closing brace or the character bounding the UUID.
+ */
+constexpr size_t lookahead = 37;
+
+/** Room before read chunks for the carried tail of the previous chunk, one cache line. */
+constexpr size_t carry_room = 64;
+
+} // anonymous namespace
+
+uuid_extractor::uuid_extractor(int fd, const uuid_scanner& scanner, size_t chunk_size):
+_fd(fd),
+_owns_fd(false),
+_scanner(scanner),
+_chunk_size(std::max(chunk_size, min_chunk_size))
+{
+    init();
+}
+
+uuid_extractor::uuid_extractor(const std::string& path, const uuid_scanner& scanner, size_t chunk_size):
+_fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC)),
+_owns_fd(true),
+_scanner(scanner),
+_chunk_size(std::max(chunk_size, min_chunk_size))
+{
+    if(_fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+    }
+    try
+    {
+        init();
+    }
+    catch(...)
+    {
+        ::close(_fd);
+        throw;
+    }
+}
+
+uuid_extractor::~uuid_extractor()
+{
+    if(_map != nullptr)
+    {
+        ::munmap(_map, _map_size);
+    }
+    if(_owns_fd)
+    {
+        ::close(_fd);
+    }
+}
+
+void uuid_extractor::init()
+{
+    struct stat st;
+    if(::fstat(_fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        // Map from the current position, as reading would.
+        off_t pos = ::lseek(_fd, 0, SEEK_CUR);
+        if(pos >= 0 && pos < st.st_size)
+        {
+            _map_size = st.st_size;
+            _map = ::mmap(nullptr, _map_size, PROT_READ, MAP_PRIVATE, _fd, 0);
+            if(_map == MAP_FAILED)
+            {
+                _map = nullptr;
+                throw std::system_error(errno, std::generic_category(), "Cannot map file");
+            }
+            ::madvise(_map, _map_size, MADV_SEQUENTIAL);
+            _data = static_cast<const char*>(_map) + pos;
+            _data_size = _map_size - pos;
+            return;
+        }
+    }
+    _buffer.resize(carry_room + _chunk_size);
+}
+
+size_t uuid_extractor::fill(char* buffer, size_t size)
+{
+    size_t filled = 0;
+    while(filled < size)
+    {
+        ssize_t count = ::read(_fd, buffer + filled, size - filled);
+        if(count < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Cannot read stream");
+        }
+        if(count == 0)
+        {
+            _eof = true;
+            break;
+        }
+        filled += count;
+    }
+    return filled;
+}
+
+void uuid_extractor::scan_window(const char* text, size_t size, uint64_t start, bool final)
+{
+    // A window holds the character preceding the first undecided digit, if any,
+    // and decides UUIDs whose digits start before its last lookahead bytes.
+    const uint64_t first = _next_digit;
+    const uint64_t last = final ? start + size : std::max(start + size - lookahead, first);
+    _pending.clear();
+    _pending_pos = 0;
+    _scanner.scan(text, size, [&](const uuid_match& match)
+    {
+        uint64_t digit = start + match.offset + (match.length == 38 ? 1 : 0);
+        if(digit >= first && digit < last)
+        {
+            _pending.push_back(match);
+            _pending.back().offset += start;
+        }
+    });
+    _next_digit = last;
+}
+
+bool uuid_extractor::next_window()
+{
+    if(_eof)
+    {
+        return false;
+    }
+    const uint64_t start = _next_digit > 0 ? _next_digit - 1 : 0;
+
+    if(_map != nullptr)
+    {
+        _end = std::min<uint64_t>(_end + _chunk_size, _data_size);
+        _eof = _end == _data_size;
+        scan_window(_data + start, _end - start, start, _eof);
+        return true;
+    }
+
+    // Move the undecided tail before the chunk, then read the chunk.
+    const size_t carry = _end - start;
+    if(carry > 0)
+    {
+        std::memmove(_buffer.data() + carry_room - carry, _buffer.data() + carry_room + _chunk_size - carry, carry);
+    }
+    size_t filled = fill(_buffer.data() + carry_room, _chunk_size);
+    _end += filled;
+    scan_window(_buffer.data() + carry_room - carry, carry + filled, start, _eof);
+    return true;
+}
+
+size_t uuid_extractor::read(uuid_match* out, size_t max)
+{
+    size_t count = 0;
+    while(count < max)
+    {
+        if(_pending_pos == _pending.size())
+        {
+            if(!next_window())
+            {
+                break;
+            }
+            continue;
+        }
+        size_t n = std::min(max - count, _pending.size() - _pending_pos);
+        std::copy(_pending.begin() + _pending_pos, _pending.begin() + _pending_pos + n, out + count);
+        _pending_pos += n;
+        count += n;
+    }
+    return count;
+}
+
+size_t uuid_extractor::read(uuid* out, size_t max)
+{
+    size_t count = 0;
+    while(count < max)
+    {
+        if(_pending_pos == _pending.size())
+        {
+            if(!next_window())
+            {
+                break;
+            }
+            continue;
+        }
+        out[count++] = _pending[_pending_pos++].id;
+    }
+    return count;
+}
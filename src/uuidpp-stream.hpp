@@ -0,0 +1,133 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * uuidpp-stream.hpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#ifndef _UUIDPP_STREAM_HPP_
+#define _UUIDPP_STREAM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "uuidpp.hpp"
+#include "uuidpp-aligned.hpp"
+#include "uuidpp-scan.hpp"
+
+/**
+ * Streaming extraction of UUIDs from a file or a pipe of any size.
+ *
+ * Regular files are memory mapped and read sequentially, other files
+ * (pipes, terminals, sockets) are read by large aligned chunks.
+ * Text is scanned window by window, consecutive windows overlapping by
+ * the size of a UUID so that UUIDs straddling chunk boundaries are found
+ * once and only once, exactly as if the whole stream was scanned at once.
+ *
+ * Extracted UUIDs are pulled with read(), at most one window of matches
+ * being buffered.
+ */
+class uuid_extractor
+{
+public:
+    /** Default size of chunks read at once. */
+    static constexpr size_t default_chunk_size = 1 << 20;
+
+    /** Smallest accepted chunk size. */
+    static constexpr size_t min_chunk_size = 4096;
+
+    /**
+     * Extract UUIDs from an open file descriptor.
+     * @param fd File descriptor, not closed by the extractor.
+     * @param scanner Scanner recognizing UUIDs.
+     * @param chunk_size Number of bytes read or scanned at once, at least min_chunk_size.
+     * @throw std::system_error if a regular file cannot be mapped.
+     */
+    explicit uuid_extractor(int fd, const uuid_scanner& scanner = uuid_scanner(),
+                            size_t chunk_size = default_chunk_size);
+
+    /**
+     * Extract UUIDs from a file.
+     * @param path Path of the file.
+     * @param scanner Scanner recognizing UUIDs.
+     * @param chunk_size Number of bytes read or scanned at once, at least min_chunk_size.
+     * @throw std::system_error if the file cannot be opened or mapped.
+     */
+    explicit uuid_extractor(const std::string& path, const uuid_scanner& scanner = uuid_scanner(),
+                            size_t chunk_size = default_chunk_size);
+
+    uuid_extractor(const uuid_extractor&) = delete;
+    uuid_extractor& operator=(const uuid_extractor&) = delete;
+
+    /** Release the mapping, close the file if opened by path. */
+    ~uuid_extractor();
+
+    /**
+     * Extract the next UUIDs.
+     * @param out Output array of max matches, offsets being offsets in the stream
+     * from its position when the extractor was created.
+     * @param max Maximum number of matches to extract.
+     * @return Number of extracted matches, less than max only at end of stream.
+     * @throw std::system_error on read error.
+     */
+    size_t read(uuid_match* out, size_t max);
+
+    /**
+     * Extract the next UUIDs.
+     * @param out Output array of max UUIDs.
+     * @param max Maximum number of UUIDs to extract.
+     * @return Number of extracted UUIDs, less than max only at end of stream.
+     * @throw std::system_error on read error.
+     */
+    size_t read(uuid* out, size_t max);
+
+    /** Number of bytes of the stream read or scanned so far. */
+    uint64_t bytes_read() const noexcept {return _end;}
+
+private:
+    void init();
+    bool next_window();
+    void scan_window(const char* text, size_t size, uint64_t start, bool final);
+    size_t fill(char* buffer, size_t size);
+
+    int _fd;
+    bool _owns_fd;
+    uuid_scanner _scanner;
+    size_t _chunk_size;
+
+    /** Mapping of a regular file, null when reading. */
+    void* _map = nullptr;
+    size_t _map_size = 0;
+    /** Mapped stream, from the file position when the extractor was created. */
+    const char* _data = nullptr;
+    size_t _data_size = 0;
+
+    /** Read buffer, chunk preceded by the carried tail of the previous one. */
+    uuid_aligned_vector<char> _buffer;
+
+    /** Stream offset after the last byte read or scanned. */
+    uint64_t _end = 0;
+    /** Stream offset of the first UUID digit not yet decided. */
+    uint64_t _next_digit = 0;
+    bool _eof = false;
+
+    std::vector<uuid_match> _pending;
+    size_t _pending_pos = 0;
+};
+
+#endif // _UUIDPP_STREAM_HPP_
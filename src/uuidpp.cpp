@@ -18,62 +18,73 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
  */
 #include "uuidpp.hpp"
+// Exported definitions, already included inline with UUIDPP_HEADER_INLINE.
+#include "uuidpp-inline.hpp"
 
+#include <atomic>
+#include <cstring>
 #include <random>
+#include <stdexcept>
 
-#include "portable-endian.h"
+#include <pthread.h>
+
+#include "uuidpp-endian.hpp"
 #include "md5.h"
 #include "sha1.h"
 
 static constexpr char const* const hex = "0123456789abcdef";
 
-uuid::uuid(uint64_t msb, uint64_t lsb)
+namespace
 {
-    *((uint64_t*)&at(0)) = htobe64(msb);
-    *((uint64_t*)&at(8)) = htobe64(lsb);
-}
 
-uuid::uuid(uint32_t time_low, uint16_t time_mid, uint16_t time_hi_and_version,
-         uint16_t clock_seq, uint64_t node)
-{
-    *((uint32_t*)&at(0)) = htobe32(time_low);
-    *((uint16_t*)&at(4)) = htobe16(time_mid);
-    *((uint16_t*)&at(6)) = htobe16(time_hi_and_version);
-    *((uint64_t*)&at(8)) = htobe64(node);
-    *((uint16_t*)&at(8)) = htobe16(clock_seq & 0x3FFF | 0x8000);
-}
+/** Number of forks in the history of the process, counted by children. */
+std::atomic<unsigned> fork_count{0};
 
-uuid::uuid(uint64_t time, version_t version, uint16_t clock_seq, uint64_t node):
-uuid(    time & 0xFFFFFFFF, // time_low
-        (time >> 32) & 0xFFFF, // time_mid
-        (time >> 48) & 0x0FFF | ((uint16_t)version << 12), // time_hi_and_version
-        clock_seq, // clock_seq
-        node
-    )
+void count_fork()
 {
+    fork_count.fetch_add(1, std::memory_order_relaxed);
 }
 
-int uuid::compare(uuid const & other) const
+/**
+ * Random engine of a thread for version 4 UUIDs, seeded again in forked
+ * processes: the child would repeat the UUIDs of its parent otherwise.
+ */
+class random_engine
 {
-    for(size_t n=0; n<16; ++n)
+public:
+    random_engine()
     {
-        if(at(n)!=other.at(n))
+        static const int registered = ::pthread_atfork(nullptr, nullptr, count_fork);
+        (void)registered;
+        seed();
+    }
+
+    std::mt19937_64& get()
+    {
+        if(_forks != fork_count.load(std::memory_order_relaxed))
         {
-            return at(n)<other.at(n) ? -n : n;
+            seed();
         }
+        return _gen;
     }
-    return 0;
-}
 
-uuid uuid::version1(uint64_t timestamp, uint16_t clock_seq, uint64_t mac_address)
-{
-    return uuid(timestamp, version_t::version_time_based, clock_seq, mac_address);
-}
+private:
+    void seed()
+    {
+        _forks = fork_count.load(std::memory_order_relaxed);
+        std::random_device device;
+        _gen.seed(((uint64_t)device() << 32) ^ device());
+    }
+
+    std::mt19937_64 _gen;
+    unsigned _forks = 0;
+};
+
+} // anonymous namespace
 
 uuid uuid::version1(uint64_t timestamp, uint16_t clock_seq, const std::array<uint8_t,6>& mac_address)
 {
-    uint64_t node = *(uint64_t*)mac_address.data() << 16;
-    return uuid(timestamp, version_t::version_time_based, clock_seq, be64toh(node));
+    return uuid(timestamp, version_t::version_time_based, clock_seq, uuid_endian::load_be48(mac_address.data()));
 }
 
 uuid uuid::version4()
@@ -94,6 +105,19 @@ uuid uuid::version4()
     return uuid(src);
 }
 
+void uuid::version4(uuid* out, size_t count)
+{
+    static thread_local random_engine engine;
+    std::mt19937_64& gen = engine.get();
+    for(size_t n=0; n<count; ++n)
+    {
+        uint64_t msb = gen(), lsb = gen();
+        msb = (msb & 0xFFFFFFFFFFFF0FFFull) | 0x4000; // version
+        lsb = (lsb & 0x3FFFFFFFFFFFFFFFull) | 0x8000000000000000ull; // variant
+        out[n] = uuid(msb, lsb);
+    }
+}
+
 uuid uuid::version3(uuid ns, const void* name, size_t name_len)
 {
     uuid res;
@@ -123,60 +147,121 @@ uuid uuid::version5(uuid ns, const void* name, size_t name_len)
 }
 
 
-std::string uuid::to_hex() const
+char* uuid::to_hex_chars(char* out) const noexcept
 {
-    std::string res(16*2, 0);
-    for(size_t n=0, m=0; n<16*2;)
+    for(size_t m=0; m<16; ++m)
     {
-        res[n]   = hex[(at(m)&0xF0u)>>4];
-        res[++n] = hex[(at(m)&0x0Fu)];
-        ++n;
-        ++m;
+        *out++ = hex[at(m) >> 4];
+        *out++ = hex[at(m) & 0x0F];
     }
-    return res;
+    return out;
 }
 
-std::string uuid::to_string() const
+char* uuid::to_chars(char* out) const noexcept
 {
-    std::string res(16*2+4, 0);
-    res[8] = res[13] = res[18] = res[23] = '-';
-
-    for(size_t n=0, m=0; n<16*2+4;)
+    for(size_t m=0; m<16; ++m)
     {
-        if (res[n] != '-')
+        if(m == 4 || m == 6 || m == 8 || m == 10)
         {
-            res[n]   = hex[(at(m)&0xF0u)>>4];
-            res[++n] = hex[(at(m)&0x0Fu)];
-            ++m;
+            *out++ = '-';
         }
-        ++n;
+        *out++ = hex[at(m) >> 4];
+        *out++ = hex[at(m) & 0x0F];
     }
-    return res;
+    return out;
 }
 
-std::string uuid::to_msguid() const
+std::string uuid::to_urn() const
 {
-    std::string res(16*2+4+2, 0);
-    res[8+1] = res[13+1] = res[18+1] = res[23+1] = '-';
-    res[0]  = '{';
-    res[37] = '}';
+    return "urn:uuid:" + to_string();
+}
 
-    for(size_t n=1, m=0; n<16*2+4+2-1;)
+/** Value of an hexadecimal digit, -1 if the character is not one. */
+static inline int hex_digit(char c)
+{
+    unsigned char u = c;
+    if((unsigned)(u - '0') < 10)
+    {
+        return u - '0';
+    }
+    u |= 0x20;
+    if((unsigned)(u - 'a') < 6)
     {
-        if (res[n] != '-')
+        return u - 'a' + 10;
+    }
+    return -1;
+}
+
+bool uuid::parse(const char* str, size_t len, uuid& out) noexcept
+{
+    static const char urn[] = "urn:uuid:";
+    if(len == 45)
+    {
+        for(size_t n=0; n<9; ++n)
         {
-            res[n]   = hex[(at(m)&0xF0u)>>4];
-            res[++n] = hex[(at(m)&0x0Fu)];
-            ++m;
+            if((str[n] | 0x20) != urn[n])
+            {
+                return false;
+            }
         }
-        ++n;
+        str += 9;
+        len = 36;
     }
-    return res;
+    else if(len == 38)
+    {
+        if(str[0] != '{' || str[37] != '}')
+        {
+            return false;
+        }
+        str += 1;
+        len = 36;
+    }
+
+    // Offsets of the digits of each byte, with or without dashes.
+    static const uint8_t canonical[16] = {0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34};
+    static const uint8_t compact[16] = {0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30};
+    const uint8_t* offsets;
+    if(len == 36)
+    {
+        if(str[8] != '-' || str[13] != '-' || str[18] != '-' || str[23] != '-')
+        {
+            return false;
+        }
+        offsets = canonical;
+    }
+    else if(len == 32)
+    {
+        offsets = compact;
+    }
+    else
+    {
+        return false;
+    }
+
+    uuid id;
+    int invalid = 0;
+    for(size_t n=0; n<16; ++n)
+    {
+        int high = hex_digit(str[offsets[n]]), low = hex_digit(str[offsets[n] + 1]);
+        invalid |= high | low;
+        id[n] = (uint8_t)(high << 4 | low);
+    }
+    if(invalid < 0)
+    {
+        return false;
+    }
+    out = id;
+    return true;
 }
 
-std::string uuid::to_urn() const
+uuid uuid::from_string(const std::string& str)
 {
-    return "urn:uuid:" + to_string();
+    uuid id;
+    if(!parse(str.data(), str.size(), id))
+    {
+        throw std::invalid_argument("Not a UUID: " + str);
+    }
+    return id;
 }
 
 
@@ -23,8 +23,31 @@
 
 #include <array>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include "uuidpp-endian.hpp"
+
+/*
+ * Define UUIDPP_HEADER_INLINE to define the small hot functions of uuid
+ * inline: compare(), time based generators and string formatting wrappers
+ * (integer constructors are always inline, being constexpr). Calls are then
+ * inlined at call sites (comparisons of sorts and containers notably)
+ * instead of going through the library.
+ *
+ * The macro must be defined consistently for a whole program, library
+ * included: a function cannot be inline in some translation units and not
+ * in others. The library built with the macro does not export these
+ * functions; programs built with it link such a library (libuuidpp-inline
+ * for the benchmarks and tests of this tree), programs built without it
+ * link libuuidpp.
+ */
+#if defined(UUIDPP_HEADER_INLINE)
+#define UUIDPP_INLINE inline
+#else
+#define UUIDPP_INLINE
+#endif
+
 /**
  * UUID - Universally Unique Identifier.
  * @see https://tools.ietf.org/html/rfc4122
@@ -44,6 +67,9 @@ public:
         version_name_based_md5  = 0x03,
         version_random          = 0x04,
         version_name_based_sha1 = 0x05,
+        version_reordered_time_based = 0x06,
+        version_unix_time_based = 0x07,
+        version_custom          = 0x08,
     };
 
     /** Variant of the UUID */
@@ -96,7 +122,9 @@ public:
      * @param msb Most significant bytes.
      * @param lsb Least significant bytes.
      */
-    uuid(uint64_t msb, uint64_t lsb);
+    constexpr uuid(uint64_t msb, uint64_t lsb):
+    parent_t(uuid_endian::be_bytes(msb, lsb))
+    {}
 
     /**
      * Construct a UUID from its layout decomposition.
@@ -108,8 +136,11 @@ public:
      * @param node The spatially unique node identifier.
      * Only least significant 48 bits are used.
      */
-    uuid(uint32_t time_low, uint16_t time_mid, uint16_t time_hi_and_version,
-         uint16_t clock_seq, uint64_t node);
+    constexpr uuid(uint32_t time_low, uint16_t time_mid, uint16_t time_hi_and_version,
+         uint16_t clock_seq, uint64_t node):
+    uuid(((uint64_t)time_low << 32) | ((uint64_t)time_mid << 16) | time_hi_and_version,
+         ((uint64_t)((clock_seq & 0x3FFF) | 0x8000) << 48) | (node & 0xFFFFFFFFFFFFull))
+    {}
     // TODO review types to adjust names to real considered sizes:
 
     /**
@@ -119,7 +150,14 @@ public:
      * @param clock_seq Clock sequence.
      * @param node Node content.
      */
-    uuid(uint64_t time, version_t version, uint16_t clock_seq, uint64_t node);
+    constexpr uuid(uint64_t time, version_t version, uint16_t clock_seq, uint64_t node):
+    uuid(   (uint32_t)(time & 0xFFFFFFFF), // time_low
+            (uint16_t)((time >> 32) & 0xFFFF), // time_mid
+            (uint16_t)(((time >> 48) & 0x0FFF) | ((uint16_t)version << 12)), // time_hi_and_version
+            clock_seq, // clock_seq
+            node
+        )
+    {}
 
     /**
      * Construct a UUID from a binary content through a couple of iterators.
@@ -160,7 +198,7 @@ public:
      * @param mac_address Mac address. (only the 6 least significant bytes are used)
      * @return The built UUID.
      */
-    static uuid version1(uint64_t timestamp, uint16_t clock_seq, uint64_t mac_address);
+    UUIDPP_INLINE static uuid version1(uint64_t timestamp, uint16_t clock_seq, uint64_t mac_address);
 
     /**
      * Build a UUID version 1 based on a timestamp a clock sequence and a mac address.
@@ -182,6 +220,48 @@ public:
      */
     static uuid version4();
 
+    /**
+     * Build random-based UUIDs version 4 in bulk, from a per-thread generator
+     * seeded again in forked processes.
+     * @param out Output array of count UUIDs.
+     * @param count Number of UUIDs to build.
+     */
+    static void version4(uuid* out, size_t count);
+
+    /**
+     * Build a UUID version 6, the field-compatible version of version 1 reordered
+     * so that UUIDs sort by timestamp.
+     * @see https://www.rfc-editor.org/rfc/rfc9562#section-5.6
+     * @param timestamp Timestamp to use. Number of 100ns since 00:00:00.00, 15 October 1582
+     * in UTC time. Only 60 least significant bits are used.
+     * @param clock_seq Clock sequence.
+     * @param node Node identifier. (only the 6 least significant bytes are used)
+     * @return The built UUID.
+     */
+    UUIDPP_INLINE static uuid version6(uint64_t timestamp, uint16_t clock_seq, uint64_t node);
+
+    /**
+     * Build a UUID version 7, based on a Unix Epoch timestamp.
+     * @see https://www.rfc-editor.org/rfc/rfc9562#section-5.7
+     * @param unix_ts_ms Number of milliseconds since the Unix Epoch.
+     * Only 48 least significant bits are used.
+     * @param rand_a Random or counter bits. Only 12 least significant bits are used.
+     * @param rand_b Random or counter bits. Only 62 least significant bits are used.
+     * @return The built UUID.
+     */
+    UUIDPP_INLINE static uuid version7(uint64_t unix_ts_ms, uint16_t rand_a, uint64_t rand_b);
+
+    /**
+     * Build a UUID version 8, of custom content.
+     * See uuid_layout to describe the content by fields.
+     * @see https://www.rfc-editor.org/rfc/rfc9562#section-5.8
+     * @param custom_a First 48 bits. Only 48 least significant bits are used.
+     * @param custom_b Next 12 bits. Only 12 least significant bits are used.
+     * @param custom_c Last 62 bits. Only 62 least significant bits are used.
+     * @return The built UUID.
+     */
+    UUIDPP_INLINE static uuid version8(uint64_t custom_a, uint16_t custom_b, uint64_t custom_c);
+
     /**
      * Build a MD5 hash based UUID from a namespace and a name.
      * @param ns Namespace to use.
@@ -321,7 +401,7 @@ public:
      * @param other Other UUID to compare.
      * @return Negative if this if less than other, 0 if equal, positive if greater.
      */
-    int compare(uuid const & other) const;
+    UUIDPP_INLINE int compare(uuid const & other) const;
 
     friend bool operator==(uuid const& l, uuid const& r)
     {
@@ -362,27 +442,65 @@ public:
      * Format a UUID as a string on the form "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx".
      * @return The formatted UUID.
      */
-    std::string to_string() const;
+    UUIDPP_INLINE std::string to_string() const;
 
     /**
      * Format a UUID as a string on the form "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx".
      * @return The formatted UUID.
      */
-    std::string to_hex() const;
+    UUIDPP_INLINE std::string to_hex() const;
+
+    /**
+     * Write a UUID on the form "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx", without allocation.
+     * @param out Output buffer of at least 36 characters, not 0-terminated.
+     * @return Pointer past the last written character.
+     */
+    char* to_chars(char* out) const noexcept;
+
+    /**
+     * Write a UUID on the form "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx", without allocation.
+     * @param out Output buffer of at least 32 characters, not 0-terminated.
+     * @return Pointer past the last written character.
+     */
+    char* to_hex_chars(char* out) const noexcept;
 
     /**
      * Format a UUID as a string on the form "{xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}".
      * @return The formatted UUID.
      */
-    std::string to_msguid() const;
+    UUIDPP_INLINE std::string to_msguid() const;
 
     /**
      * Format a UUID as a string on the form "urn:uuid:xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx".
      * @return The formatted UUID.
      */
     std::string to_urn() const;
+
+    /**
+     * Parse a UUID formatted by to_string(), to_hex(), to_msguid() or to_urn().
+     * Hexadecimal digits are case insensitive.
+     * @param str Text to parse, not necessarily 0-terminated.
+     * @param len Length of the text, the whole text must be the UUID.
+     * @param out Parsed UUID, left unchanged if the text is not a UUID.
+     * @return True if the text is a UUID.
+     */
+    static bool parse(const char* str, size_t len, uuid& out) noexcept;
+
+    /**
+     * Parse a UUID formatted by to_string(), to_hex(), to_msguid() or to_urn().
+     * @param str Text to parse.
+     * @return The parsed UUID.
+     * @throw std::invalid_argument if the text is not a UUID.
+     */
+    static uuid from_string(const std::string& str);
 };
 
+// Arrays of UUIDs are arrays of 16 bytes records, they can be reinterpreted from and to raw buffers.
+static_assert(sizeof(uuid) == 16, "uuid must be exactly 16 bytes");
+static_assert(alignof(uuid) == 1, "uuid must be byte aligned");
+static_assert(std::is_standard_layout<uuid>::value, "uuid must be standard layout");
+static_assert(std::is_trivially_copyable<uuid>::value, "uuid must be trivially copyable");
+
 namespace uuid_ns
 {
     /** DNS UUID namespace. */
@@ -404,4 +522,8 @@ namespace std
 
 }
 
+#if defined(UUIDPP_HEADER_INLINE)
+#include "uuidpp-inline.hpp"
+#endif
+
 #endif // _UUIDPP_HPP_
\ No newline at end of file
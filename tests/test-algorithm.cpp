@@ -0,0 +1,240 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-algorithm.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <algorithm>
+#include <random>
+
+#include "catch.hpp"
+#include "uuidpp-algorithm.hpp"
+
+namespace
+{
+
+std::vector<uuid> random_uuids(size_t count, uint64_t common_prefix_mask = 0)
+{
+    std::mt19937_64 gen(count);
+    std::vector<uuid> ids;
+    ids.reserve(count);
+    for(size_t n=0; n<count; ++n)
+    {
+        uint64_t msb = gen() & ~common_prefix_mask;
+        ids.emplace_back(msb, gen());
+    }
+    // Inject some duplicates.
+    for(size_t n=0; n<count/10; ++n)
+    {
+        ids[gen() % count] = ids[gen() % count];
+    }
+    return ids;
+}
+
+std::vector<uuid> reference_sort(std::vector<uuid> ids)
+{
+    std::sort(ids.begin(), ids.end(), [](const uuid& l, const uuid& r)
+    {
+        return static_cast<const uuid::parent_t&>(l) < static_cast<const uuid::parent_t&>(r);
+    });
+    return ids;
+}
+
+bool same_bytes(const std::vector<uuid>& l, const std::vector<uuid>& r)
+{
+    return l.size() == r.size()
+        && std::equal(l.begin(), l.end(), r.begin(), [](const uuid& a, const uuid& b)
+        {
+            return static_cast<const uuid::parent_t&>(a) == static_cast<const uuid::parent_t&>(b);
+        });
+}
+
+}
+
+TEST_CASE("UUID radix sort", "[algorithm]")
+{
+    for(size_t count : {0, 1, 50, 1000, 100000})
+    {
+        std::vector<uuid> ids = random_uuids(count);
+        std::vector<uuid> expected = reference_sort(ids);
+        uuid_algo::radix_sort(ids.data(), ids.size());
+        REQUIRE(same_bytes(ids, expected));
+    }
+}
+
+TEST_CASE("UUID radix sort with common prefix", "[algorithm]")
+{
+    std::vector<uuid> ids = random_uuids(10000, 0xFFFFFFFFFF000000ull);
+    std::vector<uuid> expected = reference_sort(ids);
+    uuid_algo::radix_sort(ids.data(), ids.size());
+    REQUIRE(same_bytes(ids, expected));
+}
+
+TEST_CASE("UUID radix sort permutation", "[algorithm]")
+{
+    std::vector<uuid> ids = random_uuids(5000);
+    std::vector<uuid> original = ids;
+    std::vector<size_t> permutation(ids.size());
+    uuid_algo::radix_sort(ids.data(), ids.size(), permutation.data());
+    REQUIRE(same_bytes(ids, reference_sort(original)));
+    for(size_t n=0; n<ids.size(); ++n)
+    {
+        REQUIRE(original[permutation[n]].to_hex() == ids[n].to_hex());
+    }
+}
+
+TEST_CASE("UUID parallel radix sort", "[algorithm]")
+{
+    for(uint64_t mask : {0ull, 0xFFFFFFFFFF000000ull})
+    {
+        std::vector<uuid> ids = random_uuids(300000, mask);
+        std::vector<uuid> original = ids;
+        std::vector<uuid> expected = reference_sort(ids);
+        uuid_algo::parallel_radix_sort(ids.data(), ids.size(), 4);
+        REQUIRE(same_bytes(ids, expected));
+
+        ids = original;
+        std::vector<size_t> permutation(ids.size());
+        uuid_algo::parallel_radix_sort(ids.data(), ids.size(), permutation.data(), 4);
+        REQUIRE(same_bytes(ids, expected));
+        for(size_t n=0; n<ids.size(); ++n)
+        {
+            REQUIRE(original[permutation[n]].to_hex() == ids[n].to_hex());
+        }
+    }
+}
+
+namespace
+{
+
+bool byte_less(const uuid& l, const uuid& r)
+{
+    return static_cast<const uuid::parent_t&>(l) < static_cast<const uuid::parent_t&>(r);
+}
+
+bool byte_equal(const uuid& l, const uuid& r)
+{
+    return static_cast<const uuid::parent_t&>(l) == static_cast<const uuid::parent_t&>(r);
+}
+
+/** Sorted UUIDs drawn from a small pool so that inputs share values. */
+std::vector<uuid> sorted_uuids(size_t count, uint64_t seed)
+{
+    std::mt19937_64 gen(seed);
+    std::vector<uuid> ids;
+    for(size_t n=0; n<count; ++n)
+    {
+        ids.emplace_back(gen() % 64, gen() % (count / 4 + 1));
+    }
+    std::sort(ids.begin(), ids.end(), byte_less);
+    return ids;
+}
+
+}
+
+TEST_CASE("UUID unique", "[algorithm]")
+{
+    for(size_t count : {0, 1, 1000, 200000})
+    {
+        std::vector<uuid> ids = sorted_uuids(count, 1);
+        std::vector<uuid> expected = ids;
+        expected.erase(std::unique(expected.begin(), expected.end(), byte_equal), expected.end());
+
+        std::vector<uuid> seq = ids;
+        seq.resize(uuid_algo::unique(seq.data(), seq.size()));
+        REQUIRE(same_bytes(seq, expected));
+
+        std::vector<uuid> par = ids;
+        par.resize(uuid_algo::parallel_unique(par.data(), par.size(), 4));
+        REQUIRE(same_bytes(par, expected));
+    }
+
+    std::vector<uuid> same(100000, uuid((uint64_t)1, (uint64_t)2));
+    REQUIRE(uuid_algo::parallel_unique(same.data(), same.size(), 4) == 1);
+}
+
+TEST_CASE("UUID merge", "[algorithm]")
+{
+    for(size_t count : {0, 10, 150000})
+    {
+        std::vector<uuid> a = sorted_uuids(count, 1), b = sorted_uuids(count / 2 + 3, 2);
+        std::vector<uuid> expected(a.size() + b.size());
+        std::merge(a.begin(), a.end(), b.begin(), b.end(), expected.begin(), byte_less);
+
+        std::vector<uuid> seq(a.size() + b.size());
+        uuid_algo::merge(a.data(), a.size(), b.data(), b.size(), seq.data());
+        REQUIRE(same_bytes(seq, expected));
+
+        std::vector<uuid> par(a.size() + b.size());
+        uuid_algo::parallel_merge(a.data(), a.size(), b.data(), b.size(), par.data(), 4);
+        REQUIRE(same_bytes(par, expected));
+    }
+}
+
+TEST_CASE("UUID k-way merge", "[algorithm]")
+{
+    std::vector<std::vector<uuid>> runs;
+    std::vector<const uuid*> ptrs;
+    std::vector<size_t> counts;
+    std::vector<uuid> expected;
+    for(size_t r=0; r<7; ++r)
+    {
+        runs.push_back(sorted_uuids(r == 3 ? 0 : 20000 * (r + 1), r));
+    }
+    for(const std::vector<uuid>& run : runs)
+    {
+        ptrs.push_back(run.data());
+        counts.push_back(run.size());
+        expected.insert(expected.end(), run.begin(), run.end());
+    }
+    std::stable_sort(expected.begin(), expected.end(), byte_less);
+
+    std::vector<uuid> seq(expected.size());
+    uuid_algo::kway_merge(ptrs.data(), counts.data(), runs.size(), seq.data());
+    REQUIRE(same_bytes(seq, expected));
+
+    std::vector<uuid> par(expected.size());
+    uuid_algo::parallel_kway_merge(ptrs.data(), counts.data(), runs.size(), par.data(), 4);
+    REQUIRE(same_bytes(par, expected));
+}
+
+TEST_CASE("UUID set operations", "[algorithm]")
+{
+    for(size_t count : {0, 10, 200000})
+    {
+        std::vector<uuid> a = sorted_uuids(count, 1), b = sorted_uuids(count, 2);
+
+        std::vector<uuid> inter;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(inter), byte_less);
+        std::vector<uuid> diff;
+        std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(diff), byte_less);
+
+        std::vector<uuid> out(a.size());
+        out.resize(uuid_algo::set_intersection(a.data(), a.size(), b.data(), b.size(), out.data()));
+        REQUIRE(same_bytes(out, inter));
+        out.resize(a.size());
+        out.resize(uuid_algo::parallel_set_intersection(a.data(), a.size(), b.data(), b.size(), out.data(), 4));
+        REQUIRE(same_bytes(out, inter));
+
+        out.resize(a.size());
+        out.resize(uuid_algo::set_difference(a.data(), a.size(), b.data(), b.size(), out.data()));
+        REQUIRE(same_bytes(out, diff));
+        out.resize(a.size());
+        out.resize(uuid_algo::parallel_set_difference(a.data(), a.size(), b.data(), b.size(), out.data(), 4));
+        REQUIRE(same_bytes(out, diff));
+    }
+}
@@ -0,0 +1,98 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-bytes.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+#include "catch.hpp"
+#include "uuidpp-bytes.hpp"
+
+TEST_CASE("UUID byte views", "[bytes]")
+{
+    // Unaligned network frame of three UUIDs.
+    std::vector<uint8_t> frame(1 + 3 * 16);
+    for(size_t n=0; n<frame.size(); ++n)
+    {
+        frame[n] = (uint8_t)n;
+    }
+    const uuid* ids = uuid_bytes::as_uuids(frame.data() + 1, 3 * 16);
+    REQUIRE(ids[0] == uuid((uint64_t)0x0102030405060708, (uint64_t)0x090A0B0C0D0E0F10));
+    REQUIRE(ids[2] == uuid((uint64_t)0x2122232425262728, (uint64_t)0x292A2B2C2D2E2F30));
+    REQUIRE(uuid_bytes::as_bytes(ids) == frame.data() + 1);
+
+    uuid* mutable_ids = uuid_bytes::as_uuids(frame.data() + 1, 3 * 16);
+    mutable_ids[1] = uuid();
+    REQUIRE(frame[17] == 0);
+    REQUIRE(frame[32] == 0);
+    REQUIRE(frame[33] == 33);
+
+    REQUIRE_THROWS_AS(uuid_bytes::as_uuids(frame.data(), 17), std::invalid_argument);
+}
+
+TEST_CASE("UUID GUID byte order", "[bytes]")
+{
+    // {00112233-4455-6677-8899-aabbccddeeff} as a Windows GUID structure.
+    const uuid id((uint64_t)0x0011223344556677, (uint64_t)0x8899AABBCCDDEEFF);
+    const std::array<uint8_t, 16> guid = {{0x33, 0x22, 0x11, 0x00, 0x55, 0x44, 0x77, 0x66,
+                                           0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF}};
+    REQUIRE(uuid_bytes::to_guid(id) == guid);
+    REQUIRE(uuid_bytes::from_guid(guid) == id);
+
+    std::mt19937_64 gen(0);
+    std::vector<uuid> ids;
+    for(size_t n=0; n<1000; ++n)
+    {
+        ids.emplace_back((uint64_t)gen(), (uint64_t)gen());
+    }
+    std::vector<uint8_t> guids(ids.size() * 16);
+    uuid_bytes::to_guid(ids.data(), ids.size(), guids.data());
+    for(size_t n=0; n<ids.size(); ++n)
+    {
+        std::array<uint8_t, 16> expected = uuid_bytes::to_guid(ids[n]);
+        REQUIRE(std::memcmp(guids.data() + n * 16, expected.data(), 16) == 0);
+    }
+
+    // In place round trip.
+    std::vector<uuid> copy = ids;
+    uuid_bytes::to_guid(copy.data(), copy.size(), uuid_bytes::as_bytes(copy.data()));
+    uuid_bytes::from_guid(uuid_bytes::as_bytes(copy.data()), copy.size(), copy.data());
+    REQUIRE(copy == ids);
+}
+
+TEST_CASE("UUID GUID view", "[bytes]")
+{
+    const std::array<uint8_t, 16> guid = {{0x33, 0x22, 0x11, 0x00, 0x55, 0x44, 0x77, 0x46,
+                                           0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF}};
+    uuid_bytes::guid_view view(guid.data());
+    REQUIRE(view.data1() == 0x00112233u);
+    REQUIRE(view.data2() == 0x4455u);
+    REQUIRE(view.data3() == 0x4677u);
+    REQUIRE(view.data4()[0] == 0x88);
+    REQUIRE(view.data4()[7] == 0xFF);
+    REQUIRE(view.version() == uuid::version_t::version_random);
+
+    const uuid id((uint64_t)0x0011223344554677, (uint64_t)0x8899AABBCCDDEEFF);
+    REQUIRE(view.to_uuid() == id);
+    REQUIRE(view == id);
+    REQUIRE(view != uuid());
+    REQUIRE(id == uuid(view.data1(), view.data2(), view.data3(),
+                       (uint16_t)(view.data4()[0] << 8 | view.data4()[1]), (uint64_t)0xAABBCCDDEEFF));
+}
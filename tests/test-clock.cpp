@@ -0,0 +1,177 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-clock.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "uuidpp-clock.hpp"
+#include "uuidpp-dispenser.hpp"
+#include "uuidpp-endian.hpp"
+#include "uuidpp-host.hpp"
+
+namespace
+{
+
+uint64_t distance(uint64_t a, uint64_t b)
+{
+    return a > b ? a - b : b - a;
+}
+
+/** Timestamp of a version 6 UUID, in 100ns. */
+uint64_t version6_ticks(const uuid& id)
+{
+    const uint64_t msb = uuid_endian::load_be64(id.data());
+    return ((msb >> 16) << 12) | (msb & 0xFFF);
+}
+
+/** System clock moved by a settable offset, as stepped by NTP. */
+class stepped_clock : public uuid_clock
+{
+public:
+    uint64_t now() noexcept override
+    {
+        return uuid_clock::system().now() + offset.load(std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> offset{0};
+};
+
+} // anonymous namespace
+
+TEST_CASE("OS clocks", "[clock]")
+{
+    const uint64_t chrono = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    const uint64_t system = uuid_clock::system().now();
+    REQUIRE(distance(system, chrono) < 1000000000ull);
+    REQUIRE(distance(uuid_clock::coarse().now(), uuid_clock::system().now()) < 50000000ull);
+    REQUIRE(distance(uuid_clock::tsc().now(), uuid_clock::system().now()) < 5000000ull);
+
+    REQUIRE(uuid_clock::gregorian_ticks(0) == 0x01B21DD213814000ull);
+    REQUIRE(uuid_clock::unix_ms(1500000000123456789ull) == 1500000000123ull);
+}
+
+TEST_CASE("Time stamp counter clock follows the system clock", "[clock]")
+{
+    uuid_tsc_clock clock(10000000);
+    REQUIRE(distance(clock.now(), uuid_clock::system().now()) < 5000000ull);
+    uint64_t last = clock.now();
+    for(int n=0; n<30; ++n)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        const uint64_t now = clock.now();
+        REQUIRE(distance(now, uuid_clock::system().now()) < 5000000ull);
+        REQUIRE(now + 1000000 > last);
+        last = now;
+    }
+    REQUIRE(clock.resyncs() > 0);
+}
+
+TEST_CASE("Time stamp counter clock keeps its rate over real time clock steps", "[clock]")
+{
+    stepped_clock reference;
+    uuid_tsc_clock clock(10000000, reference);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    clock.now();
+
+    // One hour forward: the clock jumps with the reference at the next resynchronization.
+    const uint64_t hour = 3600000000000ull;
+    reference.offset.store(hour);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(distance(clock.now(), reference.now()) < 5000000ull);
+
+    // Then runs at the rate of the counter, not 360 times faster.
+    for(int n=0; n<5; ++n)
+    {
+        const uint64_t start = clock.now(), system_start = uuid_clock::system().now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(8));
+        const uint64_t elapsed = clock.now() - start, system_elapsed = uuid_clock::system().now() - system_start;
+        REQUIRE(distance(elapsed, system_elapsed) < 2000000ull);
+        REQUIRE(distance(clock.now(), reference.now()) < 5000000ull);
+    }
+
+    // Back again.
+    reference.offset.store(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(distance(clock.now(), reference.now()) < 5000000ull);
+}
+
+TEST_CASE("Fake clock", "[clock]")
+{
+    uuid_fake_clock clock(1000, 10);
+    REQUIRE(clock.now() == 1000);
+    REQUIRE(clock.now() == 1010);
+    clock.set(5000);
+    REQUIRE(clock.now() == 5000);
+    clock.advance(-2000);
+    REQUIRE(clock.now() == 3010);
+
+    uuid_fake_clock fixed(42);
+    REQUIRE(fixed.now() == 42);
+    REQUIRE(fixed.now() == 42);
+}
+
+TEST_CASE("Generators read their clock", "[clock]")
+{
+    const uint64_t start = 1500000000000000000ull;
+    uuid_fake_clock clock(start);
+
+    SECTION("Version 7 dispenser")
+    {
+        uuid_dispenser dispenser(uuid::version_t::version_unix_time_based, clock);
+        uuid first = dispenser.take();
+        uuid second = dispenser.take();
+        REQUIRE(uuid_endian::load_be48(first.data()) == 1500000000000ull);
+        REQUIRE(uuid_endian::load_be48(second.data()) == 1500000000000ull);
+        REQUIRE(first < second);
+        // Clock set back: UUIDs keep increasing.
+        clock.set(start - 1000000000);
+        REQUIRE(second < dispenser.take());
+        clock.set(start + 5000000);
+        REQUIRE(uuid_endian::load_be48(dispenser.take().data()) == 1500000000005ull);
+    }
+    SECTION("Version 6 dispenser")
+    {
+        uuid_dispenser dispenser(uuid::version_t::version_reordered_time_based, 0x0123456789abull, 0x1234, clock);
+        uuid ids[3];
+        dispenser.take(ids, 3);
+        for(uint64_t n=0; n<3; ++n)
+        {
+            REQUIRE(version6_ticks(ids[n]) == uuid_clock::gregorian_ticks(start) + n);
+        }
+    }
+    SECTION("Host state")
+    {
+        const std::string path = "test-clock-" + std::to_string(::getpid()) + ".state";
+        std::remove(path.c_str());
+        {
+            uuid_host_state host(path, 0x0123456789abull, clock);
+            REQUIRE(version6_ticks(host.version6()) == uuid_clock::gregorian_ticks(start));
+            REQUIRE(version6_ticks(host.version6()) == uuid_clock::gregorian_ticks(start) + 1);
+        }
+        std::remove(path.c_str());
+    }
+}
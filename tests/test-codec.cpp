@@ -0,0 +1,145 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-codec.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+#include "catch.hpp"
+#include "uuidpp-codec.hpp"
+
+namespace
+{
+
+std::vector<uuid> random_uuids(size_t count, std::mt19937_64& gen)
+{
+    std::vector<uuid> ids;
+    for(size_t n=0; n<count; ++n)
+    {
+        ids.emplace_back((uint64_t)gen(), (uint64_t)gen());
+    }
+    return ids;
+}
+
+/** Version 7 UUIDs generated at 10 per millisecond. */
+std::vector<uuid> v7_uuids(size_t count, std::mt19937_64& gen)
+{
+    std::vector<uuid> ids;
+    for(size_t n=0; n<count; ++n)
+    {
+        ids.push_back(uuid::version7(0x017F22E279B0ull + n / 10, gen(), gen()));
+    }
+    return ids;
+}
+
+void check_round_trip(const std::vector<uuid>& ids)
+{
+    uuid_compressed_array array(ids.data(), ids.size());
+    REQUIRE(array.size() == ids.size());
+
+    std::vector<uuid> decoded(ids.size());
+    array.decode(decoded.data());
+    REQUIRE(decoded == ids);
+
+    uuid_compressed_array loaded = uuid_compressed_array::from_bytes(array.bytes().data(), array.bytes().size());
+    REQUIRE(loaded.size() == ids.size());
+    for(size_t n=0; n<ids.size(); n+=37)
+    {
+        REQUIRE(loaded.at(n) == ids[n]);
+    }
+}
+
+}
+
+TEST_CASE("UUID compressed array round trip", "[codec]")
+{
+    std::mt19937_64 gen(0);
+    for(size_t count : {0, 1, 2, 127, 128, 129, 5000})
+    {
+        std::vector<uuid> ids = random_uuids(count, gen);
+        check_round_trip(ids);
+        std::sort(ids.begin(), ids.end());
+        check_round_trip(ids);
+        check_round_trip(v7_uuids(count, gen));
+    }
+
+    std::vector<uuid> same(300, uuid_ns::dns);
+    check_round_trip(same);
+}
+
+TEST_CASE("UUID compressed array ratio", "[codec]")
+{
+    std::mt19937_64 gen(1);
+    std::vector<uuid> v4 = random_uuids(100000, gen);
+    std::sort(v4.begin(), v4.end());
+    std::vector<uuid> v7 = v7_uuids(100000, gen);
+    std::sort(v7.begin(), v7.end());
+    std::vector<uuid> v1;
+    for(size_t n=0; n<100000; ++n)
+    {
+        v1.push_back(uuid::version1(0x1EC9414C232AB00ull + n * 3, 0x33C8, 0x9F6BDECED846ull));
+    }
+
+    size_t raw = 100000 * 16;
+    REQUIRE(uuid_compressed_array(v4.data(), v4.size()).bytes().size() < raw * 0.92);
+    REQUIRE(uuid_compressed_array(v7.data(), v7.size()).bytes().size() < raw * 0.7);
+    REQUIRE(uuid_compressed_array(v1.data(), v1.size()).bytes().size() < raw * 0.2);
+}
+
+TEST_CASE("UUID compressed array blocks", "[codec]")
+{
+    std::mt19937_64 gen(2);
+    std::vector<uuid> ids = v7_uuids(1000, gen);
+    uuid_compressed_array array(ids.data(), ids.size());
+    REQUIRE(array.block_count() == 8);
+
+    std::vector<uuid> block(uuid_compressed_array::block_size);
+    REQUIRE(array.decode_block(7, block.data()) == 1000 - 7 * 128);
+    REQUIRE(std::equal(ids.begin() + 7 * 128, ids.end(), block.begin()));
+    REQUIRE_THROWS_AS(array.at(1000), std::out_of_range);
+}
+
+TEST_CASE("UUID compressed array invalid data", "[codec]")
+{
+    std::mt19937_64 gen(3);
+    std::vector<uuid> ids = random_uuids(300, gen);
+    std::vector<uint8_t> bytes = uuid_compressed_array(ids.data(), ids.size()).bytes();
+
+    REQUIRE_THROWS_AS(uuid_compressed_array::from_bytes(bytes.data(), 10), std::invalid_argument);
+    REQUIRE_THROWS_AS(uuid_compressed_array::from_bytes(bytes.data(), bytes.size() - 1), std::invalid_argument);
+
+    std::vector<uint8_t> bad = bytes;
+    bad[0] = 'X';
+    REQUIRE_THROWS_AS(uuid_compressed_array::from_bytes(bad.data(), bad.size()), std::invalid_argument);
+
+    bad = bytes;
+    bad[4] = 0xFF; // count
+    REQUIRE_THROWS_AS(uuid_compressed_array::from_bytes(bad.data(), bad.size()), std::invalid_argument);
+
+    // Header and padding only, with a count rounding up to 0 blocks.
+    bad.assign(bytes.begin(), bytes.begin() + 4);
+    bad.resize(4 + 8 + 8, 0xFF);
+    REQUIRE_THROWS_AS(uuid_compressed_array::from_bytes(bad.data(), bad.size()), std::invalid_argument);
+    for(size_t n=4; n<12; ++n)
+    {
+        bad[n] = 0;
+    }
+    REQUIRE(uuid_compressed_array::from_bytes(bad.data(), bad.size()).size() == 0);
+}
@@ -0,0 +1,173 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-column.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <algorithm>
+#include <random>
+
+#include "catch.hpp"
+#include "uuidpp-column.hpp"
+
+namespace
+{
+
+/** Mix of version 1, 6 and 7 UUIDs around a common time. */
+std::vector<uuid> time_uuids(size_t count)
+{
+    std::mt19937_64 gen(count);
+    std::vector<uuid> ids;
+    for(size_t n=0; n<count; ++n)
+    {
+        uint64_t time = 0x1EC9414C0000000ull + gen() % 0x100000;
+        switch(n % 3)
+        {
+        case 0:
+            ids.push_back(uuid::version1(time, gen(), gen()));
+            break;
+        case 1:
+            ids.push_back(uuid::version6(time, gen(), gen()));
+            break;
+        default:
+            ids.push_back(uuid::version7(0x017F22E279B0ull + gen() % 1000, gen(), gen()));
+            break;
+        }
+    }
+    return ids;
+}
+
+uint64_t timestamp(const uuid& id)
+{
+    uint64_t t = 0;
+    switch(id.version())
+    {
+    case uuid::version_t::version_time_based:
+        t = (uint64_t)(id[6] & 0x0F) << 56 | (uint64_t)id[7] << 48 | (uint64_t)id[4] << 40 | (uint64_t)id[5] << 32
+          | (uint64_t)id[0] << 24 | (uint64_t)id[1] << 16 | (uint64_t)id[2] << 8 | id[3];
+        break;
+    case uuid::version_t::version_reordered_time_based:
+        for(size_t n=0; n<6; ++n)
+        {
+            t = t << 8 | id[n];
+        }
+        t = t << 12 | (uint64_t)(id[6] & 0x0F) << 8 | id[7];
+        break;
+    default:
+        for(size_t n=0; n<6; ++n)
+        {
+            t = t << 8 | id[n];
+        }
+        break;
+    }
+    return t;
+}
+
+}
+
+TEST_CASE("UUID column storage", "[column]")
+{
+    std::vector<uuid> ids = time_uuids(1000);
+    uuid_column column(ids.data(), ids.size());
+    REQUIRE(column.size() == ids.size());
+    REQUIRE(std::equal(column.begin(), column.end(), ids.begin()));
+    REQUIRE(column.end() - column.begin() == (ptrdiff_t)ids.size());
+    REQUIRE(uuid(column.hi()[10], column.lo()[10]) == ids[10]);
+
+    std::vector<uuid> copy(ids.size());
+    column.copy_to(0, ids.size(), copy.data());
+    REQUIRE(copy == ids);
+
+    column.set(3, uuid_ns::dns);
+    column.push_back(uuid_ns::url);
+    REQUIRE(column[3] == uuid_ns::dns);
+    REQUIRE(column[ids.size()] == uuid_ns::url);
+    REQUIRE(column.size() == ids.size() + 1);
+}
+
+TEST_CASE("UUID column filters", "[column]")
+{
+    std::vector<uuid> ids = time_uuids(1003);
+    ids[500] = ids[17];
+    uuid_column column(ids.data(), ids.size());
+    std::vector<size_t> positions(ids.size());
+
+    size_t count = column.select_equal(ids[17], positions.data());
+    REQUIRE(count == 2);
+    REQUIRE(positions[0] == 17);
+    REQUIRE(positions[1] == 500);
+
+    uint64_t min_hi = column.hi()[100], max_hi = column.hi()[200];
+    if(min_hi > max_hi)
+    {
+        std::swap(min_hi, max_hi);
+    }
+    std::vector<size_t> expected;
+    for(size_t n=0; n<ids.size(); ++n)
+    {
+        if(column.hi()[n] >= min_hi && column.hi()[n] <= max_hi)
+        {
+            expected.push_back(n);
+        }
+    }
+    count = column.select_hi_range(min_hi, max_hi, positions.data());
+    REQUIRE(std::vector<size_t>(positions.begin(), positions.begin() + count) == expected);
+
+    std::vector<uint64_t> bitmap((ids.size() + 63) / 64);
+    REQUIRE(column.mask_hi_range(min_hi, max_hi, bitmap.data()) == expected.size());
+    for(size_t n : expected)
+    {
+        REQUIRE((bitmap[n / 64] >> (n % 64) & 1) == 1);
+    }
+    REQUIRE(column.select_hi_range(max_hi, min_hi - 1, positions.data()) == 0);
+}
+
+TEST_CASE("UUID column time filters", "[column]")
+{
+    std::vector<uuid> ids = time_uuids(3000);
+    uuid_column column(ids.data(), ids.size());
+    std::vector<size_t> positions(ids.size());
+
+    for(uuid::version_t version : {uuid::version_t::version_time_based,
+                                   uuid::version_t::version_reordered_time_based,
+                                   uuid::version_t::version_unix_time_based})
+    {
+        std::vector<uint64_t> times;
+        for(const uuid& id : ids)
+        {
+            if(id.version() == version)
+            {
+                times.push_back(timestamp(id));
+            }
+        }
+        std::sort(times.begin(), times.end());
+        uint64_t from = times[times.size() / 4], to = times[times.size() / 2];
+
+        std::vector<size_t> expected;
+        for(size_t n=0; n<ids.size(); ++n)
+        {
+            uint64_t t = timestamp(ids[n]);
+            if(ids[n].version() == version && t >= from && t <= to)
+            {
+                expected.push_back(n);
+            }
+        }
+        REQUIRE(expected.size() > 100);
+        size_t count = column.select_time_range(version, from, to, positions.data());
+        REQUIRE(std::vector<size_t>(positions.begin(), positions.begin() + count) == expected);
+    }
+}
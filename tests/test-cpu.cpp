@@ -0,0 +1,151 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-cpu.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "uuidpp-bytes.hpp"
+#include "uuidpp-codec.hpp"
+#include "uuidpp-column.hpp"
+#include "uuidpp-cpu.hpp"
+#include "uuidpp-index.hpp"
+#include "uuidpp-scan.hpp"
+
+namespace
+{
+
+/** Results of every dispatched kernel, to compare levels. */
+struct kernel_results
+{
+    std::vector<uint8_t> guids;
+    std::vector<uuid> scanned;
+    std::vector<size_t> found;
+    std::vector<size_t> selected;
+    std::vector<uuid> decoded;
+
+    bool operator==(const kernel_results& other) const
+    {
+        return guids == other.guids && scanned == other.scanned && found == other.found
+            && selected == other.selected && decoded == other.decoded;
+    }
+};
+
+kernel_results run_kernels(const std::vector<uuid>& ids, const std::string& text)
+{
+    kernel_results res;
+
+    res.guids.resize(ids.size() * 16);
+    uuid_bytes::to_guid(ids.data(), ids.size(), res.guids.data());
+
+    uuid_scanner().scan(text.data(), text.size(), [&](const uuid_match& match)
+    {
+        res.scanned.push_back(match.id);
+    });
+
+    std::vector<uuid> sorted(ids);
+    std::sort(sorted.begin(), sorted.end());
+    const uuid_index index(sorted.data(), sorted.size());
+    res.found.resize(ids.size());
+    index.find(ids.data(), ids.size(), res.found.data());
+    for(size_t n=0; n<ids.size(); n+=97)
+    {
+        res.found.push_back(index.lower_bound(ids[n]));
+    }
+
+    const uuid_column column(ids.data(), ids.size());
+    res.selected.resize(ids.size());
+    res.selected.resize(column.select_hi_range(0x4000000000000000ull, 0xBFFFFFFFFFFFFFFFull, res.selected.data()));
+    res.selected.resize(res.selected.size() + column.select_equal(ids[123], res.selected.data() + res.selected.size()));
+
+    const uuid_compressed_array array(sorted.data(), sorted.size());
+    res.decoded.resize(sorted.size());
+    array.decode(res.decoded.data());
+    return res;
+}
+
+} // anonymous namespace
+
+TEST_CASE("CPU level names", "[cpu]")
+{
+    for(unsigned n=uuid_cpu::scalar; n<=uuid_cpu::avx512; ++n)
+    {
+        uuid_cpu::level l;
+        REQUIRE(uuid_cpu::parse(uuid_cpu::name(static_cast<uuid_cpu::level>(n)), l));
+        REQUIRE(l == n);
+    }
+    uuid_cpu::level l;
+    REQUIRE_FALSE(uuid_cpu::parse("mmx", l));
+}
+
+TEST_CASE("CPU level selection", "[cpu]")
+{
+    const uuid_cpu::level initial = uuid_cpu::active();
+    REQUIRE(uuid_cpu::supported(initial));
+    REQUIRE(uuid_cpu::supported(uuid_cpu::scalar));
+    REQUIRE(uuid_cpu::supported(uuid_cpu::detected()));
+
+    REQUIRE(uuid_cpu::select(uuid_cpu::scalar) == uuid_cpu::scalar);
+    REQUIRE(uuid_cpu::active() == uuid_cpu::scalar);
+    REQUIRE(uuid_cpu::has(uuid_cpu::scalar));
+    REQUIRE_FALSE(uuid_cpu::has(uuid_cpu::sse2));
+
+    // Unsupported levels are lowered, never selected.
+    for(unsigned n=uuid_cpu::scalar; n<=uuid_cpu::avx512; ++n)
+    {
+        uuid_cpu::level selected = uuid_cpu::select(static_cast<uuid_cpu::level>(n));
+        REQUIRE(uuid_cpu::supported(selected));
+        REQUIRE(uuid_cpu::has(selected));
+    }
+    uuid_cpu::select(initial);
+}
+
+TEST_CASE("CPU kernels agree on every level", "[cpu]")
+{
+    std::mt19937_64 gen(7);
+    std::vector<uuid> ids(1000);
+    std::string text;
+    for(uuid& id : ids)
+    {
+        uint64_t hi = gen(), lo = gen();
+        id = uuid(hi, lo);
+        text += "id=" + id.to_string() + (gen() % 2 ? " " : ",") + id.to_hex() + "\n";
+    }
+    ids.push_back(ids[500]);
+
+    const uuid_cpu::level initial = uuid_cpu::active();
+    uuid_cpu::select(uuid_cpu::scalar);
+    const kernel_results reference = run_kernels(ids, text);
+    REQUIRE(reference.scanned.size() == 2000);
+
+    for(unsigned n=uuid_cpu::sse2; n<=uuid_cpu::avx512; ++n)
+    {
+        const uuid_cpu::level l = static_cast<uuid_cpu::level>(n);
+        if(uuid_cpu::supported(l))
+        {
+            INFO("level " << uuid_cpu::name(l));
+            uuid_cpu::select(l);
+            REQUIRE(run_kernels(ids, text) == reference);
+        }
+    }
+    uuid_cpu::select(initial);
+}
@@ -0,0 +1,284 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-dispenser.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "uuidpp-dispenser.hpp"
+#include "uuidpp-endian.hpp"
+#include "uuidpp-node.hpp"
+
+namespace
+{
+
+/** Take UUIDs one by one and in batches. */
+std::vector<uuid> take_some(uuid_dispenser& dispenser, size_t count)
+{
+    std::vector<uuid> ids;
+    uuid batch[13];
+    while(ids.size() < count)
+    {
+        ids.push_back(dispenser.take());
+        dispenser.take(batch, 13);
+        ids.insert(ids.end(), batch, batch + 13);
+    }
+    return ids;
+}
+
+/** Check UUIDs taken by a thread: version, variant and order. */
+void check_taken(const std::vector<uuid>& ids, uuid::version_t version)
+{
+    for(size_t n=0; n<ids.size(); ++n)
+    {
+        REQUIRE(ids[n].version() == version);
+        REQUIRE(ids[n].variant() == uuid::variant_t::variant_rfc4122);
+        if(n > 0 && version != uuid::version_t::version_time_based)
+        {
+            REQUIRE(ids[n - 1] < ids[n]);
+        }
+    }
+}
+
+/** Take UUIDs from several threads, checking they are all distinct. */
+void check_threads(uuid_dispenser& dispenser)
+{
+    std::vector<std::vector<uuid>> taken(4);
+    std::vector<std::thread> threads;
+    for(std::vector<uuid>& ids : taken)
+    {
+        threads.emplace_back([&dispenser, &ids]{ ids = take_some(dispenser, 5000); });
+    }
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    std::set<uuid> seen;
+    for(const std::vector<uuid>& ids : taken)
+    {
+        check_taken(ids, dispenser.version());
+        for(const uuid& id : ids)
+        {
+            REQUIRE(seen.insert(id).second);
+        }
+    }
+}
+
+} // anonymous namespace
+
+TEST_CASE("Dispensed UUIDs are distinct across threads", "[dispenser]")
+{
+    SECTION("Version 1")
+    {
+        uuid_dispenser dispenser(uuid::version_t::version_time_based, 0x0123456789abull, 0x1234);
+        REQUIRE_FALSE(dispenser.shared());
+        REQUIRE(dispenser.node() == 0x0123456789abull);
+        REQUIRE(dispenser.clock_seq() == 0x1234);
+        check_threads(dispenser);
+    }
+    SECTION("Version 6")
+    {
+        uuid_dispenser dispenser(uuid::version_t::version_reordered_time_based);
+        REQUIRE(dispenser.node() == uuid_node::host());
+        check_threads(dispenser);
+    }
+    SECTION("Version 7")
+    {
+        uuid_dispenser dispenser(uuid::version_t::version_unix_time_based);
+        check_threads(dispenser);
+    }
+}
+
+TEST_CASE("Dispensers only dispense time based UUIDs", "[dispenser]")
+{
+    REQUIRE_THROWS_AS(uuid_dispenser(uuid::version_t::version_random), std::invalid_argument);
+    REQUIRE_THROWS_AS(uuid_dispenser(uuid::version_t::version_name_based_sha1), std::invalid_argument);
+}
+
+TEST_CASE("Dispensers shared between processes", "[dispenser]")
+{
+    const std::string name = "/uuidpp-test-" + std::to_string(::getpid());
+    uuid_dispenser::unlink(name);
+
+    uuid_dispenser first(name, uuid::version_t::version_reordered_time_based, 0x0123456789abull, 0x1234);
+    REQUIRE(first.shared());
+    // Opening an existing segment keeps its node and clock sequence.
+    uuid_dispenser second(name, uuid::version_t::version_reordered_time_based, 0x0ba987654321ull, 0x0321);
+    REQUIRE(second.node() == 0x0123456789abull);
+    REQUIRE(second.clock_seq() == 0x1234);
+    REQUIRE_THROWS_AS(uuid_dispenser(name, uuid::version_t::version_unix_time_based), std::invalid_argument);
+
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    pid_t child = ::fork();
+    REQUIRE(child >= 0);
+    if(child == 0)
+    {
+        ::close(fds[0]);
+        uuid_dispenser dispenser(name, uuid::version_t::version_reordered_time_based);
+        uuid ids[1000];
+        dispenser.take(ids, 500);
+        for(size_t n=500; n<1000; ++n)
+        {
+            ids[n] = dispenser.take();
+        }
+        ssize_t written = ::write(fds[1], ids, sizeof(ids));
+        ::_exit(written == (ssize_t)sizeof(ids) ? 0 : 1);
+    }
+    ::close(fds[1]);
+
+    std::set<uuid> seen;
+    for(uuid_dispenser* dispenser : {&first, &second})
+    {
+        const std::vector<uuid> ids = take_some(*dispenser, 1000);
+        check_taken(ids, uuid::version_t::version_reordered_time_based);
+        for(const uuid& id : ids)
+        {
+            REQUIRE(seen.insert(id).second);
+        }
+    }
+
+    uuid ids[1000];
+    size_t size = 0;
+    while(size < sizeof(ids))
+    {
+        ssize_t got = ::read(fds[0], reinterpret_cast<char*>(ids) + size, sizeof(ids) - size);
+        REQUIRE(got > 0);
+        size += got;
+    }
+    ::close(fds[0]);
+    int status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+    for(const uuid& id : ids)
+    {
+        REQUIRE(id.version() == uuid::version_t::version_reordered_time_based);
+        REQUIRE(seen.insert(id).second);
+    }
+
+    REQUIRE(uuid_dispenser::unlink(name));
+    REQUIRE_FALSE(uuid_dispenser::unlink(name));
+}
+
+TEST_CASE("Dispenser segments left unpublished are recovered", "[dispenser]")
+{
+    const std::string name = "/uuidpp-test-" + std::to_string(::getpid());
+    uuid_dispenser::unlink(name);
+
+    // A creator which died before sizing, then before publishing the segment.
+    for(size_t size : {(size_t)0, (size_t)4096})
+    {
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        REQUIRE(fd >= 0);
+        REQUIRE(::ftruncate(fd, size) == 0);
+        ::close(fd);
+        uuid_dispenser dispenser(name, uuid::version_t::version_time_based, 0x0123456789abull, 0x1234);
+        REQUIRE(dispenser.node() == 0x0123456789abull);
+        REQUIRE(dispenser.clock_seq() == 0x1234);
+        check_taken(take_some(dispenser, 100), uuid::version_t::version_time_based);
+        REQUIRE(uuid_dispenser::unlink(name));
+    }
+
+    // Anything else is not a dispenser segment.
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    REQUIRE(fd >= 0);
+    REQUIRE(::write(fd, "not a segment", 13) == 13);
+    ::close(fd);
+    REQUIRE_THROWS_AS(uuid_dispenser(name, uuid::version_t::version_time_based), std::invalid_argument);
+    REQUIRE(uuid_dispenser::unlink(name));
+}
+
+TEST_CASE("Dispenser cursors read the clock once per block", "[dispenser]")
+{
+    uuid_fake_clock clock(1500000000000000000ull);
+
+    SECTION("Version 7 blocks end with the millisecond")
+    {
+        uuid_dispenser dispenser(uuid::version_t::version_unix_time_based, clock);
+        uuid_dispenser_cursor cursor(dispenser, 10000);
+        uuid last = cursor.take();
+        REQUIRE(cursor.refills() == 1);
+        for(int n=1; n<4096; ++n)
+        {
+            uuid id = cursor.take();
+            REQUIRE(uuid_endian::load_be48(id.data()) == 1500000000000ull);
+            REQUIRE(last < id);
+            last = id;
+        }
+        REQUIRE(cursor.refills() == 1);
+        // Counter exhausted, clock still in the same millisecond: run ahead.
+        uuid id = cursor.take();
+        REQUIRE(cursor.refills() == 2);
+        REQUIRE(uuid_endian::load_be48(id.data()) == 1500000000001ull);
+        REQUIRE(last < id);
+    }
+    SECTION("Blocks are shared out between cursors")
+    {
+        uuid_dispenser dispenser(uuid::version_t::version_reordered_time_based, 0x0123456789abull, 0x1234, clock);
+        std::vector<std::vector<uuid>> taken(4);
+        std::vector<std::thread> threads;
+        for(std::vector<uuid>& ids : taken)
+        {
+            threads.emplace_back([&dispenser, &ids]{
+                uuid_dispenser_cursor cursor(dispenser, 100);
+                for(int n=0; n<5000; ++n)
+                {
+                    ids.push_back(cursor.take());
+                }
+                ids.push_back(dispenser.take());
+            });
+        }
+        for(std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        std::set<uuid> seen;
+        for(const std::vector<uuid>& ids : taken)
+        {
+            check_taken(ids, uuid::version_t::version_reordered_time_based);
+            for(const uuid& id : ids)
+            {
+                REQUIRE(seen.insert(id).second);
+            }
+        }
+    }
+    SECTION("Reset cursors take a new block")
+    {
+        uuid_dispenser dispenser(uuid::version_t::version_time_based, clock);
+        uuid_dispenser_cursor cursor(dispenser, 0);
+        cursor.take();
+        cursor.take();
+        REQUIRE(cursor.refills() == 2);
+        uuid_dispenser_cursor big(dispenser);
+        big.take();
+        big.reset();
+        big.take();
+        REQUIRE(big.refills() == 2);
+    }
+}
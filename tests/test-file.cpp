@@ -0,0 +1,151 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-file.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "uuidpp-file.hpp"
+
+namespace
+{
+
+const std::string index_path = "test-file-" + std::to_string(::getpid()) + ".uuix";
+
+std::vector<uuid> sorted_uuids(size_t count, std::mt19937_64& gen)
+{
+    std::vector<uuid> ids;
+    for(size_t n=0; n<count; ++n)
+    {
+        ids.emplace_back((uint64_t)(gen() % (count * 4 + 1)), (uint64_t)gen());
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+}
+
+TEST_CASE("UUID index file lookups", "[file]")
+{
+    std::mt19937_64 gen(0);
+    for(size_t count : {0, 1, 9, 1000, 100000})
+    {
+        std::vector<uuid> ids = sorted_uuids(count, gen);
+        uuid_index_file::write(index_path, ids.data(), ids.size());
+        uuid_index_file file(index_path);
+        REQUIRE(file.size() == count);
+        REQUIRE(file.payload_size() == 0);
+        REQUIRE(file.payload(0) == nullptr);
+        REQUIRE(std::equal(file.begin(), file.end(), ids.begin()));
+
+        std::vector<uuid> queries = sorted_uuids(1000, gen);
+        for(size_t n=0; n<ids.size(); n+=13)
+        {
+            queries.push_back(ids[n]);
+        }
+        std::vector<size_t> found(queries.size());
+        file.find(queries.data(), queries.size(), found.data());
+        for(size_t n=0; n<queries.size(); ++n)
+        {
+            size_t expected = std::lower_bound(ids.begin(), ids.end(), queries[n]) - ids.begin();
+            REQUIRE(file.lower_bound(queries[n]) == expected);
+            bool present = expected < ids.size() && ids[expected] == queries[n];
+            REQUIRE(file.find(queries[n]) == (present ? expected : uuid_index_file::npos));
+            REQUIRE(found[n] == file.find(queries[n]));
+        }
+    }
+    std::remove(index_path.c_str());
+}
+
+TEST_CASE("UUID index file payloads", "[file]")
+{
+    std::mt19937_64 gen(1);
+    std::vector<uuid> ids = sorted_uuids(5000, gen);
+    std::vector<uint32_t> payloads(ids.size());
+    for(size_t n=0; n<ids.size(); ++n)
+    {
+        payloads[n] = (uint32_t)n * 7;
+    }
+    uuid_index_file::write(index_path, ids.data(), ids.size(), payloads.data(), sizeof(uint32_t));
+
+    uuid_index_file opened(index_path);
+    uuid_index_file file(std::move(opened));
+    REQUIRE(opened.size() == 0);
+    REQUIRE(file.payload_size() == sizeof(uint32_t));
+    for(size_t n=0; n<ids.size(); n+=11)
+    {
+        size_t pos = file.find(ids[n]);
+        REQUIRE(pos != uuid_index_file::npos);
+        uint32_t payload;
+        std::memcpy(&payload, file.payload(pos), sizeof(payload));
+        REQUIRE(payload == payloads[pos]);
+    }
+    std::remove(index_path.c_str());
+}
+
+TEST_CASE("UUID index file rewrite keeps mapped files", "[file]")
+{
+    std::mt19937_64 gen(3);
+    std::vector<uuid> first = sorted_uuids(1000, gen);
+    std::vector<uuid> second = sorted_uuids(2000, gen);
+    uuid_index_file::write(index_path, first.data(), first.size());
+    uuid_index_file old_file(index_path);
+
+    uuid_index_file::write(index_path, second.data(), second.size());
+    REQUIRE(old_file.size() == first.size());
+    REQUIRE(std::equal(old_file.begin(), old_file.end(), first.begin()));
+    uuid_index_file new_file(index_path);
+    REQUIRE(new_file.size() == second.size());
+    REQUIRE(std::equal(new_file.begin(), new_file.end(), second.begin()));
+    REQUIRE(::access((index_path + ".tmp." + std::to_string(::getpid())).c_str(), F_OK) != 0);
+    std::remove(index_path.c_str());
+}
+
+TEST_CASE("UUID index file errors", "[file]")
+{
+    REQUIRE_THROWS_AS(uuid_index_file("missing-file.uuix"), std::system_error);
+
+    std::mt19937_64 gen(2);
+    std::vector<uuid> ids = sorted_uuids(100, gen);
+    uuid_index_file::write(index_path, ids.data(), ids.size());
+    std::string content;
+    {
+        std::ifstream in(index_path, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Truncated file, then corrupted magic.
+    std::ofstream(index_path, std::ios::binary) << content.substr(0, content.size() - 8);
+    REQUIRE_THROWS_AS(uuid_index_file(index_path), std::invalid_argument);
+    std::ofstream(index_path, std::ios::binary) << content.substr(0, 32);
+    REQUIRE_THROWS_AS(uuid_index_file(index_path), std::invalid_argument);
+    content[0] = 'X';
+    std::ofstream(index_path, std::ios::binary) << content;
+    REQUIRE_THROWS_AS(uuid_index_file(index_path), std::invalid_argument);
+    std::remove(index_path.c_str());
+}
@@ -0,0 +1,213 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-host.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "uuidpp-host.hpp"
+
+namespace
+{
+
+const std::string state_path = "test-host-" + std::to_string(::getpid()) + ".state";
+
+const uint64_t node = 0x0123456789abull;
+
+} // anonymous namespace
+
+TEST_CASE("Host state gives distinct slots to attachments", "[host]")
+{
+    std::remove(state_path.c_str());
+    std::set<uuid> seen;
+    uuid last[uuid_host_state::max_slots];
+    {
+        uuid_host_state first(state_path, node);
+        uuid_host_state second(state_path, node);
+        REQUIRE(first.node() == node);
+        REQUIRE(second.node() == node);
+        REQUIRE(first.slot() != second.slot());
+        REQUIRE(first.clock_seq() != second.clock_seq());
+
+        std::vector<uuid> taken[4];
+        std::vector<std::thread> threads;
+        for(size_t n=0; n<4; ++n)
+        {
+            uuid_host_state& state = n % 2 ? first : second;
+            std::vector<uuid>& ids = taken[n];
+            threads.emplace_back([&state, &ids]{
+                uuid batch[16];
+                for(size_t i=0; i<500; ++i)
+                {
+                    ids.push_back(state.version6());
+                    state.version6(batch, 16);
+                    ids.insert(ids.end(), batch, batch + 16);
+                }
+            });
+        }
+        for(std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        for(const std::vector<uuid>& ids : taken)
+        {
+            for(size_t n=0; n<ids.size(); ++n)
+            {
+                REQUIRE(ids[n].version() == uuid::version_t::version_reordered_time_based);
+                REQUIRE(ids[n].variant() == uuid::variant_t::variant_rfc4122);
+                REQUIRE((n == 0 || ids[n - 1] < ids[n]));
+                REQUIRE(seen.insert(ids[n]).second);
+            }
+        }
+        last[first.slot()] = std::max(taken[1].back(), taken[3].back());
+        last[second.slot()] = std::max(taken[0].back(), taken[2].back());
+
+        uuid batch[16];
+        first.version1(batch, 16);
+        for(const uuid& id : batch)
+        {
+            REQUIRE(id.version() == uuid::version_t::version_time_based);
+            REQUIRE(seen.insert(id).second);
+        }
+        REQUIRE(first.version1().version() == uuid::version_t::version_time_based);
+    }
+
+    // Freed slots are taken again, after the timestamps used with them.
+    uuid_host_state again(state_path, node);
+    REQUIRE(again.slot() < 2);
+    REQUIRE(last[again.slot()] < again.version6());
+    std::remove(state_path.c_str());
+}
+
+TEST_CASE("Host state slots of crashed processes are taken over", "[host]")
+{
+    std::remove(state_path.c_str());
+    uuid_host_state parent(state_path, node);
+
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    pid_t child = ::fork();
+    REQUIRE(child >= 0);
+    if(child == 0)
+    {
+        ::close(fds[0]);
+        // Exit without detaching, as if crashed.
+        uuid_host_state* state = new uuid_host_state(state_path, node);
+        uuid ids[1000];
+        state->version6(ids, 1000);
+        ssize_t written = ::write(fds[1], ids, sizeof(ids));
+        ::_exit(written == (ssize_t)sizeof(ids) && state->slot() != parent.slot() ? 0 : 1);
+    }
+    ::close(fds[1]);
+    uuid ids[1000];
+    size_t size = 0;
+    while(size < sizeof(ids))
+    {
+        ssize_t got = ::read(fds[0], reinterpret_cast<char*>(ids) + size, sizeof(ids) - size);
+        REQUIRE(got > 0);
+        size += got;
+    }
+    ::close(fds[0]);
+    int status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+
+    uuid_host_state successor(state_path, node);
+    REQUIRE(successor.slot() != parent.slot());
+    REQUIRE(successor.clock_seq() == (((ids[0][8] & 0x3F) << 8) | ids[0][9]));
+    REQUIRE(ids[999] < successor.version6());
+    std::remove(state_path.c_str());
+}
+
+TEST_CASE("Host state takes another slot in forked processes", "[host]")
+{
+    std::remove(state_path.c_str());
+    uuid_host_state parent(state_path, node);
+    const unsigned parent_slot = parent.slot();
+    parent.version6();
+
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    pid_t child = ::fork();
+    REQUIRE(child >= 0);
+    if(child == 0)
+    {
+        ::close(fds[0]);
+        // Inherited state, same next timestamp as the parent.
+        uuid ids[1000];
+        ids[0] = parent.version6();
+        parent.version6(ids + 1, 999);
+        ssize_t written = ::write(fds[1], ids, sizeof(ids));
+        ::_exit(written == (ssize_t)sizeof(ids) && parent.slot() != parent_slot ? 0 : 1);
+    }
+    ::close(fds[1]);
+    std::set<uuid> seen;
+    uuid ids[1000];
+    parent.version6(ids, 1000);
+    seen.insert(ids, ids + 1000);
+    size_t size = 0;
+    while(size < sizeof(ids))
+    {
+        ssize_t got = ::read(fds[0], reinterpret_cast<char*>(ids) + size, sizeof(ids) - size);
+        REQUIRE(got > 0);
+        size += got;
+    }
+    ::close(fds[0]);
+    int status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+    for(const uuid& id : ids)
+    {
+        REQUIRE(seen.insert(id).second);
+    }
+    REQUIRE(parent.slot() == parent_slot);
+
+    // A child destroying the inherited state leaves the slot of its parent.
+    child = ::fork();
+    REQUIRE(child >= 0);
+    if(child == 0)
+    {
+        parent.~uuid_host_state();
+        ::_exit(0);
+    }
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    uuid_host_state other(state_path, node);
+    REQUIRE(other.slot() != parent.slot());
+    std::remove(state_path.c_str());
+}
+
+TEST_CASE("Host state files are checked", "[host]")
+{
+    std::ofstream(state_path, std::ios::binary) << "not a state file";
+    REQUIRE_THROWS_AS(uuid_host_state(state_path, node), std::invalid_argument);
+    std::remove(state_path.c_str());
+}
@@ -0,0 +1,98 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-index.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <algorithm>
+#include <random>
+
+#include "catch.hpp"
+#include "uuidpp-index.hpp"
+
+namespace
+{
+
+/** Sorted UUIDs, with many shared high words and duplicates. */
+std::vector<uuid> sorted_uuids(size_t count, std::mt19937_64& gen)
+{
+    std::vector<uuid> ids;
+    for(size_t n=0; n<count; ++n)
+    {
+        uint64_t hi = gen() % 4 == 0 ? 42 : gen() % (count * 8 + 1);
+        ids.emplace_back(hi, (uint64_t)(gen() % (count + 1)));
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+}
+
+TEST_CASE("UUID index lower bound and find", "[index]")
+{
+    std::mt19937_64 gen(0);
+    for(size_t count : {0, 1, 7, 8, 9, 72, 73, 81, 650, 100000})
+    {
+        std::vector<uuid> ids = sorted_uuids(count, gen);
+        uuid_index index(ids.data(), ids.size());
+        REQUIRE(index.size() == count);
+
+        for(size_t n=0; n<ids.size(); ++n)
+        {
+            REQUIRE(index[n] == ids[n]);
+        }
+
+        std::vector<uuid> queries = sorted_uuids(2000, gen);
+        queries.insert(queries.end(), ids.begin(), ids.end());
+        queries.emplace_back((uint64_t)0, (uint64_t)0);
+        queries.emplace_back(~(uint64_t)0, ~(uint64_t)0);
+        for(const uuid& query : queries)
+        {
+            size_t expected = std::lower_bound(ids.begin(), ids.end(), query) - ids.begin();
+            REQUIRE(index.lower_bound(query) == expected);
+            bool present = expected < ids.size() && ids[expected] == query;
+            REQUIRE(index.find(query) == (present ? expected : uuid_index::npos));
+            REQUIRE(index.contains(query) == present);
+        }
+    }
+}
+
+TEST_CASE("UUID index batch lookups", "[index]")
+{
+    std::mt19937_64 gen(1);
+    for(size_t count : {0, 5, 100, 100000})
+    {
+        std::vector<uuid> ids = sorted_uuids(count, gen);
+        uuid_index index(ids.data(), ids.size());
+
+        std::vector<uuid> queries = sorted_uuids(1000, gen);
+        for(size_t n=0; n<ids.size(); n+=7)
+        {
+            queries.push_back(ids[n]);
+        }
+        std::shuffle(queries.begin(), queries.end(), gen);
+
+        std::vector<size_t> bounds(queries.size()), found(queries.size());
+        index.lower_bound(queries.data(), queries.size(), bounds.data());
+        index.find(queries.data(), queries.size(), found.data());
+        for(size_t n=0; n<queries.size(); ++n)
+        {
+            REQUIRE(bounds[n] == index.lower_bound(queries[n]));
+            REQUIRE(found[n] == index.find(queries[n]));
+        }
+    }
+}
@@ -0,0 +1,59 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-inline.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+// Run with library definitions by test, with inline ones by test-inline.
+
+#include <algorithm>
+#include <vector>
+
+#include "catch.hpp"
+#include "uuidpp.hpp"
+#include "uuidpp-algorithm.hpp"
+
+TEST_CASE("Inline construction", "[inline]")
+{
+    uuid id{{0, 1, 2, 3, 4, 5, 6, 7, 0x88, 9, 10, 11, 12, 13, 14, 15}};
+    REQUIRE(uuid((uint64_t)0x0001020304050607ull, (uint64_t)0x88090A0B0C0D0E0Full) == id);
+    REQUIRE(uuid(0x00010203ul, 0x0405u, 0x0607u, 0x0809u, 0x0A0B0C0D0E0Full) == id);
+    REQUIRE(uuid(0x0607040500010203ull, uuid::version_t::version_unknown, 0x0809u, 0x0A0B0C0D0E0Full) == id);
+}
+
+TEST_CASE("Inline generators", "[inline]")
+{
+    REQUIRE(uuid::version1(0, 0, 0x0123456789ABull) == uuid::version1(0, 0, {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB}));
+    REQUIRE(uuid::version6(0x1EC9414C232AB00ull, 0x33C8, 0x9F6BDECED846ull).to_string() == "1ec9414c-232a-6b00-b3c8-9f6bdeced846");
+    REQUIRE(uuid::version7(0x017F22E279B0ull, 0xCC3, 0x18C4DC0C0C07398Full).to_msguid() == "{017f22e2-79b0-7cc3-98c4-dc0c0c07398f}");
+    REQUIRE(uuid::version7(0x017F22E279B0ull, 0xCC3, 0x18C4DC0C0C07398Full).to_hex() == "017f22e279b07cc398c4dc0c0c07398f");
+}
+
+TEST_CASE("Inline comparison sorts as the library", "[inline]")
+{
+    std::vector<uuid> ids(1000);
+    uuid::version4(ids.data(), ids.size());
+    ids.push_back(ids[10]);
+    std::vector<uuid> sorted(ids);
+    std::sort(sorted.begin(), sorted.end());
+    uuid_algo::radix_sort(ids.data(), ids.size());
+    REQUIRE(sorted == ids);
+    // The duplicate may sort first: compare the ends.
+    REQUIRE(sorted[0].compare(sorted[0]) == 0);
+    REQUIRE(sorted.front().compare(sorted.back()) < 0);
+    REQUIRE(sorted.back().compare(sorted.front()) > 0);
+}
@@ -0,0 +1,135 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-layout.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+#include "uuidpp-layout.hpp"
+
+namespace
+{
+
+struct timestamp : uuid_field<48> {};
+struct shard : uuid_field<16> {};
+struct entity : uuid_field<8> {};
+struct sequence : uuid_field<50> {};
+typedef uuid_layout<timestamp, shard, entity, sequence> order_id;
+
+static_assert(order_id::width == 122, "all custom bits");
+static_assert(order_id::offset<shard>() == 48, "after the timestamp");
+static_assert(order_id::offset<sequence>() == 72, "last");
+
+/** Fields of the three runs of custom bits of version 8. */
+struct custom_a : uuid_field<48> {};
+struct custom_b : uuid_field<12> {};
+struct custom_c : uuid_field<62> {};
+typedef uuid_layout<custom_a, custom_b, custom_c> runs;
+
+/** Field crossing the version, the 64 bits boundary and the variant. */
+struct head : uuid_field<40> {};
+struct straddling : uuid_field<64> {};
+typedef uuid_layout<head, straddling> crossing;
+
+} // anonymous namespace
+
+TEST_CASE("UUID version 8", "[layout]")
+{
+    uuid id = uuid::version8(0x123456789abcull, 0xdef, 0x0123456789abcdefull);
+    REQUIRE(id.version() == uuid::version_t::version_custom);
+    REQUIRE(id.variant() == uuid::variant_t::variant_rfc4122);
+    REQUIRE(id.to_string() == "12345678-9abc-8def-8123-456789abcdef");
+    // Extra bits are dropped.
+    REQUIRE(uuid::version8(0xFFFF123456789abcull, 0xFdef, 0xC123456789abcdefull) == id);
+}
+
+TEST_CASE("Layout fields are packed around version and variant", "[layout]")
+{
+    REQUIRE(runs::encode(0x123456789abcull, 0xdef, 0x0123456789abcdefull) == uuid::version8(0x123456789abcull, 0xdef, 0x0123456789abcdefull));
+
+    std::mt19937_64 engine(8);
+    for(int n=0; n<1000; ++n)
+    {
+        const uint64_t first = engine() & 0xFFFFFFFFFFull, second = engine();
+        uuid id = crossing::encode(first, second);
+        REQUIRE(crossing::valid(id));
+        REQUIRE(crossing::get<head>(id) == first);
+        REQUIRE(crossing::get<straddling>(id) == second);
+        uint64_t a = 0, b = 0;
+        crossing::decode(id, a, b);
+        REQUIRE(a == first);
+        REQUIRE(b == second);
+    }
+}
+
+TEST_CASE("Layout fields are read and changed by name", "[layout]")
+{
+    uuid id = order_id::encode(1500000000000ull, 0x1234, 0x56, 0x3FFFFFFFFFFFFull);
+    REQUIRE(order_id::valid(id));
+    REQUIRE_FALSE(order_id::valid(uuid::version7(1500000000000ull, 0, 0)));
+    REQUIRE(order_id::get<timestamp>(id) == 1500000000000ull);
+    REQUIRE(order_id::get<shard>(id) == 0x1234);
+    REQUIRE(order_id::get<entity>(id) == 0x56);
+    REQUIRE(order_id::get<sequence>(id) == 0x3FFFFFFFFFFFFull);
+
+    order_id::set<entity>(id, 0x78);
+    REQUIRE(order_id::get<entity>(id) == 0x78);
+    REQUIRE(order_id::get<shard>(id) == 0x1234);
+    REQUIRE(order_id::get<sequence>(id) == 0x3FFFFFFFFFFFFull);
+    order_id::set<sequence>(id, 0xFFFFFFFFFFFFFFFFull);
+    REQUIRE(order_id::get<sequence>(id) == 0x3FFFFFFFFFFFFull);
+    REQUIRE(order_id::valid(id));
+
+    // UUIDs sort by the first fields.
+    REQUIRE(order_id::encode(1, 0xFFFF, 0xFF, 0) < order_id::encode(2, 0, 0, 0));
+}
+
+TEST_CASE("Layout columns", "[layout]")
+{
+    const size_t count = 1001;
+    std::vector<uint64_t> timestamps(count), sequences(count);
+    std::vector<uint16_t> shards(count);
+    std::vector<uint8_t> entities(count);
+    std::mt19937_64 engine(49);
+    for(size_t n=0; n<count; ++n)
+    {
+        timestamps[n] = engine() & 0xFFFFFFFFFFFFull;
+        shards[n] = (uint16_t)engine();
+        entities[n] = (uint8_t)engine();
+        sequences[n] = engine() & 0x3FFFFFFFFFFFFull;
+    }
+
+    std::vector<uuid> ids(count);
+    order_id::encode(ids.data(), count, timestamps.data(), shards.data(), entities.data(), sequences.data());
+    for(size_t n=0; n<count; ++n)
+    {
+        REQUIRE(ids[n] == order_id::encode(timestamps[n], shards[n], entities[n], sequences[n]));
+    }
+
+    std::vector<uint64_t> timestamps_out(count), sequences_out(count);
+    std::vector<uint16_t> shards_out(count);
+    std::vector<uint8_t> entities_out(count);
+    order_id::decode(ids.data(), count, timestamps_out.data(), shards_out.data(), entities_out.data(), sequences_out.data());
+    REQUIRE(timestamps_out == timestamps);
+    REQUIRE(shards_out == shards);
+    REQUIRE(entities_out == entities);
+    REQUIRE(sequences_out == sequences);
+}
@@ -0,0 +1,119 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-node.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "uuidpp-node.hpp"
+
+namespace
+{
+
+const std::string sysfs_path = "test-node-net";
+
+/** Fake sysfs network class directory, removed on destruction. */
+struct fake_sysfs
+{
+    std::vector<std::string> files, dirs;
+
+    fake_sysfs()
+    {
+        ::mkdir(sysfs_path.c_str(), 0755);
+        dirs.push_back(sysfs_path);
+    }
+
+    ~fake_sysfs()
+    {
+        for(const std::string& file : files)
+        {
+            std::remove(file.c_str());
+        }
+        for(auto dir = dirs.rbegin(); dir != dirs.rend(); ++dir)
+        {
+            ::rmdir(dir->c_str());
+        }
+    }
+
+    void add(const std::string& name, const std::string& type, const std::string& address)
+    {
+        const std::string dir = sysfs_path + "/" + name;
+        ::mkdir(dir.c_str(), 0755);
+        dirs.insert(dirs.begin() + 1, dir);
+        files.push_back(dir + "/type");
+        std::ofstream(files.back()) << type << "\n";
+        files.push_back(dir + "/address");
+        std::ofstream(files.back()) << address << "\n";
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("MAC address parsing", "[node]")
+{
+    uint64_t node = 0;
+    REQUIRE(uuid_node::parse("00:1a:2B:3c:4d:5e", node));
+    REQUIRE(node == 0x001a2b3c4d5eull);
+    REQUIRE_FALSE(uuid_node::parse("00:1a:2b:3c:4d", node));
+    REQUIRE_FALSE(uuid_node::parse("00:1a:2b:3c:4d:5g", node));
+    REQUIRE_FALSE(uuid_node::parse("00-1a-2b-3c-4d-5e", node));
+    REQUIRE(node == 0x001a2b3c4d5eull);
+}
+
+TEST_CASE("Hardware address discovery", "[node]")
+{
+    fake_sysfs sysfs;
+    uint64_t node = 0;
+    REQUIRE_FALSE(uuid_node::discover(sysfs_path, node));
+    REQUIRE_FALSE(uuid_node::discover("missing-directory", node));
+
+    sysfs.add("lo", "772", "00:00:00:00:00:00");
+    sysfs.add("tun0", "65534", "");
+    REQUIRE_FALSE(uuid_node::discover(sysfs_path, node));
+
+    // Locally administered addresses are taken only without a better one.
+    sysfs.add("veth1", "1", "02:42:ac:11:00:02");
+    REQUIRE(uuid_node::discover(sysfs_path, node));
+    REQUIRE(node == 0x0242ac110002ull);
+
+    sysfs.add("eth1", "1", "00:1a:2b:3c:4d:5f");
+    sysfs.add("eth0", "1", "00:1a:2b:3c:4d:5e");
+    sysfs.add("mc0", "1", "01:00:5e:00:00:01");
+    REQUIRE(uuid_node::discover(sysfs_path, node));
+    REQUIRE(node == 0x001a2b3c4d5eull);
+}
+
+TEST_CASE("Node of the host", "[node]")
+{
+    const uint64_t node = uuid_node::host();
+    REQUIRE(node == uuid_node::host());
+    REQUIRE(node <= 0xFFFFFFFFFFFFull);
+    REQUIRE(((node & uuid_node::multicast) == 0) == uuid_node::hardware());
+
+    const uint64_t random = uuid_node::random();
+    REQUIRE(random <= 0xFFFFFFFFFFFFull);
+    REQUIRE((random & uuid_node::multicast) != 0);
+    REQUIRE(random != uuid_node::random());
+}
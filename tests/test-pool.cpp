@@ -0,0 +1,219 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-pool.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <algorithm>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "uuidpp-pool.hpp"
+
+namespace
+{
+
+/** Take count UUIDs one by one and in batches, checking they are distinct random UUIDs. */
+void check_pool(uuid_pool& pool, size_t count)
+{
+    std::set<uuid> seen;
+    std::vector<uuid> batch(37);
+    while(seen.size() < count)
+    {
+        uuid id = pool.next();
+        REQUIRE(id.version() == uuid::version_t::version_random);
+        REQUIRE(id.variant() == uuid::variant_t::variant_rfc4122);
+        REQUIRE(seen.insert(id).second);
+        pool.next(batch.data(), batch.size());
+        for(const uuid& other : batch)
+        {
+            REQUIRE(other.version() == uuid::version_t::version_random);
+            REQUIRE(seen.insert(other).second);
+        }
+    }
+}
+
+} // anonymous namespace
+
+TEST_CASE("Latency histogram percentiles", "[pool]")
+{
+    uuid_latency_histogram histogram;
+    REQUIRE(histogram.percentile(0.5) == 0);
+    for(uint64_t ns=1; ns<=100; ++ns)
+    {
+        histogram.record(ns);
+    }
+    REQUIRE(histogram.count() == 100);
+    REQUIRE(histogram.max() == 100);
+    REQUIRE(histogram.percentile(0.1) == 10);
+    // Values above 16 are bucketed with a 1/16 relative precision.
+    REQUIRE(histogram.percentile(0.5) >= 50);
+    REQUIRE(histogram.percentile(0.5) <= 50 + 50 / 16);
+    REQUIRE(histogram.percentile(0.99) >= 99);
+    REQUIRE(histogram.percentile(1.0) == 100);
+
+    uuid_latency_histogram other;
+    other.record(1000000);
+    histogram.merge(other);
+    REQUIRE(histogram.count() == 101);
+    REQUIRE(histogram.percentile(1.0) == 1000000);
+    histogram.reset();
+    REQUIRE(histogram.count() == 0);
+}
+
+TEST_CASE("Pool refilled in bulk", "[pool]")
+{
+    uuid_pool pool(100, uuid_pool::refill_mode::bulk);
+    REQUIRE(pool.capacity() == 128);
+    REQUIRE(pool.available() == 128);
+    check_pool(pool, 5000);
+    REQUIRE(pool.misses() == 0);
+    REQUIRE(pool.available() >= 64);
+}
+
+TEST_CASE("Pool refilled in background", "[pool]")
+{
+    uuid_pool pool(64);
+    check_pool(pool, 5000);
+    // Half empty: refilled up to capacity.
+    while(pool.available() > pool.capacity() / 2)
+    {
+        pool.next();
+    }
+    pool.next();
+    for(int n=0; n<1000 && pool.available() != pool.capacity(); ++n)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(pool.available() == pool.capacity());
+}
+
+TEST_CASE("Thread local pools", "[pool]")
+{
+    std::vector<std::vector<uuid>> taken(4);
+    std::vector<std::thread> threads;
+    for(std::vector<uuid>& ids : taken)
+    {
+        threads.emplace_back([&ids]()
+        {
+            for(int n=0; n<10000; ++n)
+            {
+                ids.push_back(uuid_pool::local().next());
+            }
+        });
+    }
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    std::vector<uuid> all;
+    for(const std::vector<uuid>& ids : taken)
+    {
+        all.insert(all.end(), ids.begin(), ids.end());
+    }
+    std::sort(all.begin(), all.end());
+    REQUIRE(std::adjacent_find(all.begin(), all.end()) == all.end());
+}
+
+TEST_CASE("Pool latency measure", "[pool]")
+{
+    uuid_pool pool(256, uuid_pool::refill_mode::bulk);
+    pool.next();
+    REQUIRE(pool.latency().count() == 0);
+    pool.measure(true);
+    for(int n=0; n<1000; ++n)
+    {
+        pool.next();
+    }
+    pool.measure(false);
+    pool.next();
+    REQUIRE(pool.latency().count() == 1000);
+    REQUIRE(pool.latency().percentile(0.5) <= pool.latency().percentile(0.99));
+    REQUIRE(pool.latency().percentile(0.99) <= pool.latency().max());
+    pool.reset_latency();
+    REQUIRE(pool.latency().count() == 0);
+}
+
+TEST_CASE("Pools hand out distinct UUIDs in forked processes", "[pool]")
+{
+    // Inherited rings and generators: the child would repeat the parent.
+    uuid_pool& local = uuid_pool::local();
+    uuid_pool bulk(256, uuid_pool::refill_mode::bulk);
+    local.next();
+    bulk.next();
+
+    const size_t count = 3000;
+    int fds[2];
+    REQUIRE(::pipe(fds) == 0);
+    pid_t child = ::fork();
+    REQUIRE(child >= 0);
+    if(child == 0)
+    {
+        ::close(fds[0]);
+        std::vector<uuid> ids(4 * count);
+        local.next(ids.data(), count);
+        for(size_t n=count; n<2*count; ++n)
+        {
+            ids[n] = bulk.next();
+        }
+        uuid::version4(&ids[2 * count], count);
+        // Past the capacity of the ring: refilled in background again.
+        for(size_t n=3*count; n<4*count; ++n)
+        {
+            ids[n] = local.next();
+        }
+        ssize_t written = ::write(fds[1], ids.data(), ids.size() * sizeof(uuid));
+        ::_exit(written == (ssize_t)(ids.size() * sizeof(uuid)) ? 0 : 1);
+    }
+    ::close(fds[1]);
+    std::vector<uuid> ids(4 * count);
+    local.next(ids.data(), count);
+    for(size_t n=count; n<2*count; ++n)
+    {
+        ids[n] = bulk.next();
+    }
+    uuid::version4(&ids[2 * count], count);
+    for(size_t n=3*count; n<4*count; ++n)
+    {
+        ids[n] = local.next();
+    }
+    std::set<uuid> seen(ids.begin(), ids.end());
+    REQUIRE(seen.size() == ids.size());
+
+    size_t size = 0;
+    char* data = reinterpret_cast<char*>(ids.data());
+    while(size < ids.size() * sizeof(uuid))
+    {
+        ssize_t got = ::read(fds[0], data + size, ids.size() * sizeof(uuid) - size);
+        REQUIRE(got > 0);
+        size += got;
+    }
+    ::close(fds[0]);
+    int status = 0;
+    REQUIRE(::waitpid(child, &status, 0) == child);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+    for(const uuid& id : ids)
+    {
+        REQUIRE(seen.insert(id).second);
+    }
+}
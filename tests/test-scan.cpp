@@ -0,0 +1,155 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-scan.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <cctype>
+#include <random>
+#include <string>
+
+#include "catch.hpp"
+#include "uuidpp-scan.hpp"
+
+namespace
+{
+
+std::vector<uuid_match> scan_all(const uuid_scanner& scanner, const std::string& text)
+{
+    std::vector<uuid_match> matches;
+    size_t found = scanner.scan(text.data(), text.size(), [&](const uuid_match& match)
+    {
+        matches.push_back(match);
+    });
+    REQUIRE(found == matches.size());
+    return matches;
+}
+
+/** Straightforward scanner, testing each position. */
+std::vector<uuid_match> reference_scan(unsigned formats, const std::string& text)
+{
+    std::vector<uuid_match> matches;
+    auto hex = [&](size_t pos)
+    {
+        return pos < text.size() && isxdigit((unsigned char)text[pos]);
+    };
+    for(size_t pos=0; pos<text.size(); ++pos)
+    {
+        if(pos > 0 && hex(pos - 1))
+        {
+            continue;
+        }
+        uuid id;
+        if(pos + 36 <= text.size() && !hex(pos + 36) && uuid::parse(text.data() + pos, 36, id))
+        {
+            if((formats & uuid_scanner::braced) && pos > 0 && text[pos - 1] == '{' && pos + 36 < text.size() && text[pos + 36] == '}')
+            {
+                matches.push_back(uuid_match{pos - 1, 38, id});
+            }
+            else if(formats & uuid_scanner::canonical)
+            {
+                matches.push_back(uuid_match{pos, 36, id});
+            }
+        }
+        else if((formats & uuid_scanner::compact) && pos + 32 <= text.size() && !hex(pos + 32)
+                && uuid::parse(text.data() + pos, 32, id))
+        {
+            matches.push_back(uuid_match{pos, 32, id});
+        }
+    }
+    return matches;
+}
+
+}
+
+TEST_CASE("UUID scanner formats", "[scan]")
+{
+    uuid id = uuid::from_string("0a1b2c3d-4e5f-6789-abcd-ef0123456789");
+    std::string text = "GET /items/0a1b2c3d-4e5f-6789-ABCD-ef0123456789?x=1 "
+                       "{\"id\":\"{0a1b2c3d-4e5f-6789-abcd-ef0123456789}\"} "
+                       "trace=0a1b2c3d4e5f6789abcdef0123456789\n"
+                       "0a1b2c3d-4e5f-6789-abcd-ef01234567890 not glued "
+                       "f0a1b2c3d4e5f6789abcdef0123456789 neither";
+
+    std::vector<uuid_match> matches = scan_all(uuid_scanner(), text);
+    REQUIRE(matches.size() == 3);
+    REQUIRE(matches[0].offset == 11);
+    REQUIRE(matches[0].length == 36);
+    REQUIRE(matches[1].offset == text.find("{0a1b"));
+    REQUIRE(matches[1].length == 38);
+    REQUIRE(matches[2].offset == text.find("trace=") + 6);
+    REQUIRE(matches[2].length == 32);
+    for(const uuid_match& match : matches)
+    {
+        REQUIRE(match.id == id);
+    }
+
+    matches = scan_all(uuid_scanner(uuid_scanner::canonical), text);
+    REQUIRE(matches.size() == 2);
+    REQUIRE(matches[1].length == 36);
+    REQUIRE(text[matches[1].offset - 1] == '{');
+
+    matches = scan_all(uuid_scanner(uuid_scanner::braced), text);
+    REQUIRE(matches.size() == 1);
+    REQUIRE(matches[0].length == 38);
+
+    REQUIRE(scan_all(uuid_scanner(), "").empty());
+    REQUIRE(scan_all(uuid_scanner(), id.to_string()).size() == 1);
+    REQUIRE(scan_all(uuid_scanner(), id.to_hex()).size() == 1);
+}
+
+TEST_CASE("UUID scanner against reference", "[scan]")
+{
+    std::mt19937_64 gen(0);
+    const std::string noise = "0123456789abcdefABCDEF---{{}} xyz\n";
+    for(unsigned formats : {1u, 2u, 4u, 3u, 7u})
+    {
+        for(int round=0; round<50; ++round)
+        {
+            std::string text;
+            size_t length = gen() % 3000;
+            while(text.size() < length)
+            {
+                switch(gen() % 8)
+                {
+                case 0:
+                    text += uuid((uint64_t)gen(), (uint64_t)gen()).to_string();
+                    break;
+                case 1:
+                    text += uuid((uint64_t)gen(), (uint64_t)gen()).to_hex();
+                    break;
+                case 2:
+                    text += uuid((uint64_t)gen(), (uint64_t)gen()).to_msguid();
+                    break;
+                default:
+                    text += noise[gen() % noise.size()];
+                    break;
+                }
+            }
+
+            std::vector<uuid_match> expected = reference_scan(formats, text);
+            std::vector<uuid_match> matches = scan_all(uuid_scanner(formats), text);
+            REQUIRE(matches.size() == expected.size());
+            for(size_t n=0; n<matches.size(); ++n)
+            {
+                REQUIRE(matches[n].offset == expected[n].offset);
+                REQUIRE(matches[n].length == expected[n].length);
+                REQUIRE(matches[n].id == expected[n].id);
+            }
+        }
+    }
+}
@@ -0,0 +1,177 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-shard.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+#include "uuidpp-shard.hpp"
+
+namespace
+{
+
+/** UUIDs of a version as generated in a row: consecutive times for versions 1 and 7, random for version 4. */
+std::vector<uuid> generated_ids(int version, size_t count)
+{
+    std::vector<uuid> ids(count);
+    std::mt19937_64 rng(version);
+    for(size_t n=0; n<count; ++n)
+    {
+        switch(version)
+        {
+        case 1:
+            ids[n] = uuid::version1(0x1ec9414c232ab00ull + n, 0x1234, 0x0a1b2c3d4e5full);
+            break;
+        case 7:
+            ids[n] = uuid::version7(1700000000000ull + n / 4096, n % 4096, rng());
+            break;
+        default:
+            ids[n] = uuid((rng() & ~(uint64_t)0xf000) | 0x4000, (rng() >> 2) | ((uint64_t)2 << 62));
+            break;
+        }
+    }
+    return ids;
+}
+
+/** Check that ids are routed to shards with counts within 10% of the mean. */
+void check_uniform(const std::vector<uint32_t>& routes, uint32_t shards)
+{
+    std::vector<size_t> counts(shards);
+    for(uint32_t route : routes)
+    {
+        REQUIRE(route < shards);
+        ++counts[route];
+    }
+    const double mean = (double)routes.size() / shards;
+    for(size_t count : counts)
+    {
+        CHECK(count > mean * 0.9);
+        CHECK(count < mean * 1.1);
+    }
+}
+
+} // anonymous namespace
+
+TEST_CASE("Fast range reduction stays below n", "[shard]")
+{
+    CHECK(uuid_shard::fast_range(0, 10) == 0);
+    CHECK(uuid_shard::fast_range(~(uint64_t)0, 10) == 9);
+    CHECK(uuid_shard::fast_range((uint64_t)1 << 63, 10) == 5);
+    CHECK(uuid_shard::fast_range(~(uint64_t)0, 0) == 0);
+    CHECK(uuid_shard::fast_range(12345, 1) == 0);
+}
+
+TEST_CASE("Hash mixes all bits", "[shard]")
+{
+    const uuid id((uint64_t)0x0123456789abcdefull, (uint64_t)0xfedcba9876543210ull);
+    const uint64_t h = uuid_shard::hash(id);
+    for(size_t bit=0; bit<128; ++bit)
+    {
+        uuid other = id;
+        other.data()[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        const int changed = __builtin_popcountll(h ^ uuid_shard::hash(other));
+        CHECK(changed > 10);
+        CHECK(changed < 54);
+    }
+}
+
+TEST_CASE("Shards are uniform for all versions", "[shard]")
+{
+    const uint32_t shards = 64;
+    const uint64_t nodes[] = {11, 22, 33, 44, 55, 66, 77, 88};
+    for(int version : {1, 4, 7})
+    {
+        INFO("version " << version);
+        const std::vector<uuid> ids = generated_ids(version, 64 * 4000);
+        std::vector<uint32_t> routes(ids.size());
+
+        uuid_shard::range(ids.data(), ids.size(), shards, routes.data());
+        check_uniform(routes, shards);
+
+        uuid_shard::jump(ids.data(), ids.size(), shards, routes.data());
+        check_uniform(routes, shards);
+
+        uuid_shard::rendezvous(ids.data(), ids.size(), nodes, 8, routes.data());
+        check_uniform(routes, 8);
+    }
+}
+
+TEST_CASE("Batch routing matches single routing", "[shard]")
+{
+    const std::vector<uuid> ids = generated_ids(4, 1000);
+    const uint64_t nodes[] = {3, 1, 4, 1000, 5, 9, 2, 6, 5000};
+    std::vector<uint32_t> ranges(ids.size()), jumps(ids.size()), rendezvous(ids.size());
+    uuid_shard::range(ids.data(), ids.size(), 37, ranges.data());
+    uuid_shard::jump(ids.data(), ids.size(), 37, jumps.data());
+    uuid_shard::rendezvous(ids.data(), ids.size(), nodes, 9, rendezvous.data());
+    for(size_t n=0; n<ids.size(); ++n)
+    {
+        REQUIRE(ranges[n] == uuid_shard::range(ids[n], 37));
+        REQUIRE(jumps[n] == uuid_shard::jump(ids[n], 37));
+        REQUIRE(rendezvous[n] == uuid_shard::rendezvous(ids[n], nodes, 9));
+    }
+}
+
+TEST_CASE("Jump hash only moves UUIDs to added shards", "[shard]")
+{
+    const std::vector<uuid> ids = generated_ids(7, 100000);
+    for(uint32_t shards : {1u, 2u, 10u, 63u})
+    {
+        INFO(shards << " shards");
+        size_t moved = 0;
+        for(const uuid& id : ids)
+        {
+            const uint32_t before = uuid_shard::jump(id, shards), after = uuid_shard::jump(id, shards + 1);
+            REQUIRE(before < shards);
+            if(after != before)
+            {
+                REQUIRE(after == shards);
+                ++moved;
+            }
+        }
+        // About 1/(shards+1) of UUIDs move.
+        const double expected = (double)ids.size() / (shards + 1);
+        CHECK(moved > expected * 0.9);
+        CHECK(moved < expected * 1.1);
+    }
+}
+
+TEST_CASE("Rendezvous hash only moves UUIDs of removed shards", "[shard]")
+{
+    const std::vector<uuid> ids = generated_ids(1, 50000);
+    const uint64_t nodes[] = {101, 102, 103, 104, 105, 106};
+    const uint64_t remaining[] = {101, 102, 104, 105, 106};
+    size_t moved = 0;
+    for(const uuid& id : ids)
+    {
+        const uint64_t before = nodes[uuid_shard::rendezvous(id, nodes, 6)];
+        const uint64_t after = remaining[uuid_shard::rendezvous(id, remaining, 5)];
+        if(before != 103)
+        {
+            REQUIRE(after == before);
+        }
+        else
+        {
+            ++moved;
+        }
+    }
+    CHECK(moved > ids.size() / 6 * 0.9);
+    CHECK(moved < ids.size() / 6 * 1.1);
+}
@@ -0,0 +1,152 @@
+/* -*- Mode: C++; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*-  */
+/*
+ * test-stream.cpp
+ *
+ * Copyright (C) 2017 Emilien Kia <emilien.kia@gmail.com>
+ *
+ * uuidpp is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * uuidpp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "uuidpp-stream.hpp"
+
+namespace
+{
+
+const std::string stream_path = "test-stream-" + std::to_string(::getpid()) + ".log";
+
+/** Log-like text, with UUIDs of all formats at every alignment. */
+std::string log_text(size_t size, std::mt19937_64& gen)
+{
+    const std::string noise = "0123456789abcdef-{} xyz\n";
+    std::string text;
+    while(text.size() < size)
+    {
+        uuid id((uint64_t)gen(), (uint64_t)gen());
+        switch(gen() % 4)
+        {
+        case 0:
+            text += id.to_string();
+            break;
+        case 1:
+            text += id.to_hex();
+            break;
+        case 2:
+            text += id.to_msguid();
+            break;
+        default:
+            for(size_t n=gen()%40; n>0; --n)
+            {
+                text += noise[gen() % noise.size()];
+            }
+            break;
+        }
+    }
+    return text;
+}
+
+std::vector<uuid_match> extract_all(uuid_extractor& extractor)
+{
+    std::vector<uuid_match> matches;
+    uuid_match buffer[100];
+    size_t count;
+    while((count = extractor.read(buffer, 100)) > 0)
+    {
+        matches.insert(matches.end(), buffer, buffer + count);
+    }
+    return matches;
+}
+
+void require_same(const std::vector<uuid_match>& matches, const std::vector<uuid_match>& expected)
+{
+    REQUIRE(matches.size() == expected.size());
+    for(size_t n=0; n<matches.size(); ++n)
+    {
+        REQUIRE(matches[n].offset == expected[n].offset);
+        REQUIRE(matches[n].length == expected[n].length);
+        REQUIRE(matches[n].id == expected[n].id);
+    }
+}
+
+}
+
+TEST_CASE("UUID extraction from files", "[stream]")
+{
+    std::mt19937_64 gen(0);
+    for(size_t size : {0, 10, 4096, 100000})
+    {
+        std::string text = log_text(size, gen);
+        std::ofstream(stream_path, std::ios::binary) << text;
+
+        std::vector<uuid_match> expected;
+        uuid_scanner().scan(text.data(), text.size(), [&](const uuid_match& match)
+        {
+            expected.push_back(match);
+        });
+
+        uuid_extractor extractor(stream_path, uuid_scanner(), uuid_extractor::min_chunk_size);
+        require_same(extract_all(extractor), expected);
+        REQUIRE(extractor.bytes_read() == text.size());
+
+        uuid_extractor ids_extractor(stream_path);
+        std::vector<uuid> ids(expected.size() + 1);
+        REQUIRE(ids_extractor.read(ids.data(), ids.size()) == expected.size());
+        for(size_t n=0; n<expected.size(); ++n)
+        {
+            REQUIRE(ids[n] == expected[n].id);
+        }
+    }
+    std::remove(stream_path.c_str());
+
+    REQUIRE_THROWS_AS(uuid_extractor(std::string("missing-file.log")), std::system_error);
+}
+
+TEST_CASE("UUID extraction from pipes", "[stream]")
+{
+    std::mt19937_64 gen(1);
+    std::string text = log_text(200000, gen);
+    std::vector<uuid_match> expected;
+    uuid_scanner(uuid_scanner::canonical).scan(text.data(), text.size(), [&](const uuid_match& match)
+    {
+        expected.push_back(match);
+    });
+
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    // Write by small irregular pieces, so that reads return partial chunks.
+    std::thread writer([&]()
+    {
+        std::mt19937_64 sizes(2);
+        for(size_t pos=0; pos<text.size();)
+        {
+            size_t piece = std::min<size_t>(sizes() % 3000 + 1, text.size() - pos);
+            pos += write(fds[1], text.data() + pos, piece);
+        }
+        close(fds[1]);
+    });
+    uuid_extractor extractor(fds[0], uuid_scanner(uuid_scanner::canonical), uuid_extractor::min_chunk_size);
+    std::vector<uuid_match> matches = extract_all(extractor);
+    writer.join();
+    close(fds[0]);
+    require_same(matches, expected);
+}
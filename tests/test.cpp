@@ -18,7 +18,10 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.";
  */
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
@@ -105,6 +108,20 @@ TEST_CASE("UUID less-than operator", "[UUID]")
     REQUIRE(!(id1<id3));
 }
 
+TEST_CASE("UUID comparison", "[UUID]")
+{
+    uuid id1{{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}};
+    uuid id2{{1, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}};
+    uuid id3{{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 16}};
+
+    REQUIRE(id1.compare(id1) == 0);
+    REQUIRE(id1.compare(id2) < 0);
+    REQUIRE(id2.compare(id1) > 0);
+    REQUIRE(id1.compare(id3) < 0);
+    REQUIRE(id1 != id2);
+    REQUIRE(id3 < id2);
+}
+
 TEST_CASE("UUID assignation", "[UUID]")
 {
     uuid id{{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}};
@@ -137,6 +154,18 @@ TEST_CASE("UUID generic composed construction", "[UUID]")
     REQUIRE(id1==id2);
 }
 
+TEST_CASE("UUID constant construction", "[UUID]")
+{
+    constexpr uuid id1((uint64_t)0x0001020304050607ull, (uint64_t)0x88090A0B0C0D0E0Full);
+    constexpr uuid id2(0x00010203ul, 0x0405u, 0x0607u, 0x0809u, 0x0A0B0C0D0E0Full);
+    constexpr uuid id3(0x0607040500010203ull, uuid::version_t::version_unknown, 0x0809u, 0x0A0B0C0D0E0Full);
+    static_assert(id1[0] == 0 && id1[7] == 7 && id1[8] == 0x88 && id1[15] == 15, "msb-lsb construction");
+    static_assert(id2[3] == 3 && id2[8] == 0x88 && id2[9] == 9 && id2[10] == 10, "decomposed construction");
+    static_assert(id3[6] == 6 && id3[7] == 7 && id3.variant() == uuid::variant_t::variant_rfc4122, "composed construction");
+    REQUIRE(id1 == id2);
+    REQUIRE(id2 == id3);
+}
+
 TEST_CASE("UUID compact hex string format", "[UUID]")
 {
     uuid id{{0xF0, 1, 0x82, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}};
@@ -161,6 +190,50 @@ TEST_CASE("UUID URN string format", "[UUID]")
     REQUIRE(id.to_urn() == "urn:uuid:f0018203-0405-0607-0809-0a0b0c0d0e0f");
 }
 
+TEST_CASE("UUID character buffers", "[UUID]")
+{
+    uuid id{{0xF0, 1, 0x82, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}};
+    char buffer[40];
+    REQUIRE(id.to_chars(buffer) == buffer + 36);
+    REQUIRE(std::string(buffer, 36) == id.to_string());
+    REQUIRE(id.to_hex_chars(buffer) == buffer + 32);
+    REQUIRE(std::string(buffer, 32) == id.to_hex());
+}
+
+TEST_CASE("UUID version 4 in bulk", "[UUID]")
+{
+    std::vector<uuid> ids(1000);
+    uuid::version4(ids.data(), ids.size());
+    for(const uuid& id : ids)
+    {
+        REQUIRE(id.version() == uuid::version_t::version_random);
+        REQUIRE(id.variant() == uuid::variant_t::variant_rfc4122);
+    }
+    std::sort(ids.begin(), ids.end());
+    REQUIRE(std::adjacent_find(ids.begin(), ids.end()) == ids.end());
+}
+
+TEST_CASE("UUID parsing", "[UUID]")
+{
+    uuid id{{0xF0, 1, 0x82, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 0xAF}};
+    REQUIRE(uuid::from_string(id.to_string()) == id);
+    REQUIRE(uuid::from_string(id.to_hex()) == id);
+    REQUIRE(uuid::from_string(id.to_msguid()) == id);
+    REQUIRE(uuid::from_string(id.to_urn()) == id);
+    REQUIRE(uuid::from_string("F0018203-0405-0607-0809-0A0B0C0D0EAF") == id);
+    REQUIRE(uuid::from_string("URN:UUID:f0018203-0405-0607-0809-0a0b0c0d0eaf") == id);
+
+    uuid out;
+    for(const char* str : {"", "f0018203-0405-0607-0809-0a0b0c0d0ea", "f0018203-0405-0607-0809_0a0b0c0d0eaf",
+                           "f0018203-0405-0607-0809-0a0b0c0d0eag", "{f0018203-0405-0607-0809-0a0b0c0d0eaf)",
+                           "urn:uuix:f0018203-0405-0607-0809-0a0b0c0d0eaf", "f00182030405060708090a0b0c0d0e-f"})
+    {
+        REQUIRE_FALSE(uuid::parse(str, strlen(str), out));
+    }
+    REQUIRE(out.nil());
+    REQUIRE_THROWS_AS(uuid::from_string("not a uuid"), std::invalid_argument);
+}
+
 TEST_CASE("UUID version 1", "[UUID]")
 {
     uuid id1 = uuid::version1(0, 0, 0x0123456789ABull);
@@ -172,6 +245,24 @@ TEST_CASE("UUID version 1", "[UUID]")
     REQUIRE(id1==id2);
 }
 
+TEST_CASE("UUID version 6", "[UUID]")
+{
+    // Test vector from RFC 9562 appendix A.5.
+    uuid id = uuid::version6(0x1EC9414C232AB00ull, 0x33C8, 0x9F6BDECED846ull);
+    REQUIRE(id.version()==uuid::version_t::version_reordered_time_based);
+    REQUIRE(id.variant()==uuid::variant_t::variant_rfc4122);
+    REQUIRE(id.to_string()=="1ec9414c-232a-6b00-b3c8-9f6bdeced846");
+}
+
+TEST_CASE("UUID version 7", "[UUID]")
+{
+    // Test vector from RFC 9562 appendix A.6.
+    uuid id = uuid::version7(0x017F22E279B0ull, 0xCC3, 0x18C4DC0C0C07398Full);
+    REQUIRE(id.version()==uuid::version_t::version_unix_time_based);
+    REQUIRE(id.variant()==uuid::variant_t::variant_rfc4122);
+    REQUIRE(id.to_string()=="017f22e2-79b0-7cc3-98c4-dc0c0c07398f");
+}
+
 TEST_CASE("UUID version 4", "[UUID]")
 {
     uuid id = uuid::version4();